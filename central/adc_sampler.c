@@ -0,0 +1,139 @@
+/**
+ * @file
+ * @brief Timer-paced LM19 sampling on ADC channel A10 (P5.2).
+ */
+#include "adc_sampler.h"
+
+#include "msp430fr2355.h"
+#include <driverlib.h>
+
+// ADC trigger inputs on the FR2355: ADCSHS 1 = TB0.1B, 2 = TB1.1B, 3 = TB2.1B
+#define SAMPLEHOLDSOURCE_TB1_1 ADC_SAMPLEHOLDSOURCE_2
+
+// driverlib only lists inputs up to A9; A10-A11 exist on the FR2355
+#define INPUT_A10 ADCINCH_10
+
+// 12-bit conversions at 12 + n bits after decimation, shifted up to the output width
+#define DECIMATED_BITS (12 + ADC_SAMPLER_OVERSAMPLE_BITS)
+#define OUTPUT_SHIFT (ADC_SAMPLER_OUTPUT_BITS - DECIMATED_BITS)
+
+// Window comparator interrupts
+#define WINDOW_INTERRUPTS (ADC_ABOVETHRESHOLD_INTERRUPT | ADC_BELOWTHRESHOLD_INTERRUPT | ADC_INSIDEWINDOW_INTERRUPT)
+#define WINDOW_FLAGS (ADC_ABOVETHRESHOLD_INTERRUPT_FLAG | ADC_BELOWTHRESHOLD_INTERRUPT_FLAG | ADC_INSIDEWINDOW_INTERRUPT_FLAG)
+
+static uint16_t rate_hz = 0;
+static uint16_t window_low = 0;         // monitor thresholds in 12-bit codes
+static uint16_t window_high = 0;
+static uint32_t oversample_sum = 0;     // conversions summed so far for the next output sample
+static uint16_t oversample_count = 0;
+
+void adc_sampler_setup(void)
+{
+    // ADC A10 pin on P5.2
+    P5SEL0 |= BIT2;
+    P5SEL1 |= BIT2;
+
+    // conversions start on a TB1.1 rising edge; the sampling timer holds for
+    // 16 ADC clocks and each conversion needs a new trigger
+    ADC_init(ADC_BASE, SAMPLEHOLDSOURCE_TB1_1, ADC_CLOCKSOURCE_ADCOSC, ADC_CLOCKDIVIDER_1);
+    ADC_enable(ADC_BASE);
+    ADC_setupSamplingTimer(ADC_BASE, ADC_CYCLEHOLD_16_CYCLES, ADC_MULTIPLESAMPLESDISABLE);
+    ADC_setResolution(ADC_BASE, ADC_RESOLUTION_12BIT);
+    ADC_configureMemory(ADC_BASE, INPUT_A10, ADC_VREFPOS_AVCC, ADC_VREFNEG_AVSS);
+    ADC_clearInterrupt(ADC_BASE, ADC_COMPLETED_INTERRUPT_FLAG);
+    ADC_enableInterrupt(ADC_BASE, ADC_COMPLETED_INTERRUPT);
+
+    // TB1.1 is set at CCR0 and reset at CCR1: one rising edge per period
+    TB1CCTL1 = OUTMOD_7;
+    adc_sampler_set_rate(ADC_SAMPLER_DEFAULT_HZ);
+
+    // arm the ADC; with a timer trigger ADCSC is ignored and the timer paces every conversion
+    ADC_startConversion(ADC_BASE, ADC_REPEATED_SINGLECHANNEL);
+}
+
+void adc_sampler_set_rate(uint16_t hz)
+{
+    if (hz == 0)
+    {
+        hz = 1;
+    }
+    else if (hz > ADC_SAMPLER_MAX_HZ)
+    {
+        hz = ADC_SAMPLER_MAX_HZ;
+    }
+
+    uint16_t conversion_hz = hz * ADC_SAMPLER_OVERSAMPLE_COUNT;
+    uint16_t period = (uint16_t)((ADC_SAMPLER_CLOCK_HZ + conversion_hz / 2) / conversion_hz);
+
+    TB1CTL = TBSSEL__ACLK | MC__STOP | TBCLR;
+    TB1CCR0 = period - 1;
+    TB1CCR1 = period / 2;
+    TB1CTL |= MC__UP;
+    rate_hz = hz;
+}
+
+uint16_t adc_sampler_rate(void)
+{
+    return rate_hz;
+}
+
+bool adc_sampler_decimate(uint16_t raw, uint16_t *sample)
+{
+    oversample_sum += raw;
+    if (++oversample_count < ADC_SAMPLER_OVERSAMPLE_COUNT)
+    {
+        return false;
+    }
+
+    // the sum of 4^n samples has 2n extra bits; dropping n of them, rounded, leaves n bits of resolution gained
+    uint16_t decimated = (uint16_t)((oversample_sum + ((1UL << ADC_SAMPLER_OVERSAMPLE_BITS) >> 1)) >> ADC_SAMPLER_OVERSAMPLE_BITS);
+    *sample = decimated << OUTPUT_SHIFT;
+
+    oversample_sum = 0;
+    oversample_count = 0;
+    return true;
+}
+
+void adc_sampler_monitor(uint16_t low, uint16_t high)
+{
+    window_low = low >> (ADC_SAMPLER_OUTPUT_BITS - 12);
+    window_high = high >> (ADC_SAMPLER_OUTPUT_BITS - 12);
+
+    ADC_disableInterrupt(ADC_BASE, ADC_COMPLETED_INTERRUPT);
+    adc_sampler_window_enter(ADC_WINDOW_INSIDE);
+}
+
+void adc_sampler_stream(void)
+{
+    ADC_disableInterrupt(ADC_BASE, WINDOW_INTERRUPTS);
+    oversample_sum = 0;
+    oversample_count = 0;
+    ADC_clearInterrupt(ADC_BASE, ADC_COMPLETED_INTERRUPT_FLAG);
+    ADC_enableInterrupt(ADC_BASE, ADC_COMPLETED_INTERRUPT);
+}
+
+void adc_sampler_window_enter(uint8_t zone)
+{
+    uint16_t high = window_high;
+    uint16_t low = window_low;
+    uint16_t enable = ADC_INSIDEWINDOW_INTERRUPT;
+
+    if (zone == ADC_WINDOW_ABOVE)
+    {
+        high = (window_high > low + ADC_SAMPLER_WINDOW_HYST) ? window_high - ADC_SAMPLER_WINDOW_HYST : low;
+    }
+    else if (zone == ADC_WINDOW_BELOW)
+    {
+        low = (window_low + ADC_SAMPLER_WINDOW_HYST < high) ? window_low + ADC_SAMPLER_WINDOW_HYST : high;
+    }
+    else
+    {
+        enable = ADC_ABOVETHRESHOLD_INTERRUPT | ADC_BELOWTHRESHOLD_INTERRUPT;
+    }
+
+    // flags from earlier conversions are stale once the thresholds move
+    ADC_disableInterrupt(ADC_BASE, WINDOW_INTERRUPTS);
+    ADC_setWindowComp(ADC_BASE, high, low);
+    ADC_clearInterrupt(ADC_BASE, WINDOW_FLAGS);
+    ADC_enableInterrupt(ADC_BASE, enable);
+}
@@ -0,0 +1,132 @@
+/**
+ * @file
+ * @brief Timer-paced LM19 sampling on ADC channel A10 (P5.2).
+ *
+ * Timer_B1 runs from ACLK in up mode and its CCR1 output (TB1.1, reset/set)
+ * is the ADC's sample-and-hold trigger, so every conversion starts on a timer
+ * edge with no CPU involvement and no jitter from interrupt latency. The ADC
+ * runs in repeated single-channel mode from MODOSC, which keeps working in
+ * LPM3, and raises ADCIFG0 after each conversion.
+ *
+ * For more resolution than the 12-bit converter gives, the timer runs
+ * 4^ADC_SAMPLER_OVERSAMPLE_BITS times faster than the output rate and the
+ * application's ADC_ISR hands every conversion to adc_sampler_decimate, which
+ * sums them and decimates to 12 + ADC_SAMPLER_OVERSAMPLE_BITS bits. This only
+ * gains resolution while there is at least an LSB of noise on the input, which
+ * the LM19 and the ADC provide. Output samples are always left-justified to
+ * ADC_SAMPLER_OUTPUT_BITS, so the oversampling can change without touching
+ * the code that consumes them.
+ *
+ * In monitor mode the per-conversion interrupt is off and the ADC window
+ * comparator checks every conversion against a pair of thresholds in
+ * hardware, so the CPU sleeps through in-band conversions and only wakes when
+ * the input leaves the band or comes back into it.
+ */
+#ifndef ADC_SAMPLER_H
+#define ADC_SAMPLER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Timer clock: ACLK */
+#define ADC_SAMPLER_CLOCK_HZ 32768UL
+
+/** Output sample rate used at start-up, build-time configurable */
+#ifndef ADC_SAMPLER_DEFAULT_HZ
+#define ADC_SAMPLER_DEFAULT_HZ 2
+#endif
+
+/** Extra bits of resolution from oversampling, build-time configurable: [0, 4] */
+#ifndef ADC_SAMPLER_OVERSAMPLE_BITS
+#define ADC_SAMPLER_OVERSAMPLE_BITS 2
+#endif
+
+#if (ADC_SAMPLER_OVERSAMPLE_BITS < 0) || (ADC_SAMPLER_OVERSAMPLE_BITS > 4)
+#error "ADC_SAMPLER_OVERSAMPLE_BITS must be in [0, 4]"
+#endif
+
+/** Conversions summed into each output sample */
+#define ADC_SAMPLER_OVERSAMPLE_COUNT (1 << (2 * ADC_SAMPLER_OVERSAMPLE_BITS))
+
+/** Width output samples are left-justified to */
+#define ADC_SAMPLER_OUTPUT_BITS 16
+
+/** Highest conversion rate; bounded by ADC_ISR time at 1 MHz MCLK */
+#define ADC_SAMPLER_MAX_CONVERSION_HZ 2048
+
+/** Hysteresis in 12-bit codes (about 0.35 degrees C on the LM19) before an alarm zone is left */
+#define ADC_SAMPLER_WINDOW_HYST 5
+
+/** Highest accepted output sample rate */
+#define ADC_SAMPLER_MAX_HZ (ADC_SAMPLER_MAX_CONVERSION_HZ / ADC_SAMPLER_OVERSAMPLE_COUNT)
+
+/**
+ * Configure the ADC for A10 with a Timer_B1 trigger and start sampling at
+ * ADC_SAMPLER_DEFAULT_HZ.
+ */
+void adc_sampler_setup(void);
+
+/**
+ * Change the output sample rate. The conversion period is rounded to whole
+ * ACLK ticks.
+ *
+ * @param: hz Output samples per second, clamped to [1, ADC_SAMPLER_MAX_HZ].
+ */
+void adc_sampler_set_rate(uint16_t hz);
+
+/**
+ * Current output sample rate.
+ *
+ * @return: Output samples per second as last set.
+ */
+uint16_t adc_sampler_rate(void);
+
+/**
+ * Accumulate one conversion; call from ADC_ISR with ADCMEM0.
+ *
+ * @param: raw 12-bit conversion result.
+ * @param: sample Set to the decimated sample, left-justified to
+ *         ADC_SAMPLER_OUTPUT_BITS, when one is complete.
+ *
+ * @return: true if sample was set.
+ */
+bool adc_sampler_decimate(uint16_t raw, uint16_t *sample);
+
+/**
+ * Where the input is relative to the monitor window
+ */
+enum adc_window_zone
+{
+    ADC_WINDOW_INSIDE,      /**< Between the thresholds */
+    ADC_WINDOW_BELOW,       /**< Below the low threshold */
+    ADC_WINDOW_ABOVE,       /**< Above the high threshold */
+};
+
+/**
+ * Switch to monitor mode: stop per-conversion interrupts and only interrupt
+ * when a conversion leaves [low, high]. The zone starts as inside.
+ *
+ * @param: low Low threshold, left-justified to ADC_SAMPLER_OUTPUT_BITS.
+ * @param: high High threshold, left-justified to ADC_SAMPLER_OUTPUT_BITS.
+ */
+void adc_sampler_monitor(uint16_t low, uint16_t high);
+
+/**
+ * Leave monitor mode and go back to interrupting on every conversion,
+ * starting a fresh oversampled output sample.
+ */
+void adc_sampler_stream(void);
+
+/**
+ * Re-arm the window comparator after a crossing; call from ADC_ISR on
+ * ADCIV_ADCHIIFG, ADCIV_ADCLOIFG or ADCIV_ADCINIFG.
+ *
+ * Outside the window only the way back in interrupts, with
+ * ADC_SAMPLER_WINDOW_HYST of hysteresis; inside it only the two ways out do,
+ * so a conversion raises at most one interrupt per crossing.
+ *
+ * @param: zone The zone the input just entered, an enum adc_window_zone.
+ */
+void adc_sampler_window_enter(uint8_t zone);
+
+#endif // ADC_SAMPLER_H
@@ -0,0 +1,18 @@
+/**
+ * @file
+ * @brief CRC-16-CCITT over a byte buffer on the CRC hardware module.
+ */
+#include "crc16.h"
+
+#include "msp430fr2355.h"
+#include <driverlib.h>
+
+uint16_t crc16(uint16_t seed, const uint8_t *data, uint8_t len)
+{
+    CRC_setSeed(CRC_BASE, seed);
+    while (len--)
+    {
+        CRC_set8BitData(CRC_BASE, *data++);
+    }
+    return CRC_getResult(CRC_BASE);
+}
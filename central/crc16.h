@@ -0,0 +1,25 @@
+/**
+ * @file
+ * @brief CRC-16-CCITT over a byte buffer on the CRC hardware module.
+ *
+ * Bytes are fed one at a time through CRCDI_L, the same way the LED bar and
+ * LCD nodes check them with their own CRC modules, so both ends agree
+ * without a software table. Only the main loop may use the CRC module.
+ */
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>
+
+/**
+ * Compute the CRC of a buffer.
+ *
+ * @param: seed Initial CRC value.
+ * @param: data Bytes to check.
+ * @param: len Number of bytes.
+ *
+ * @return: The CRC.
+ */
+uint16_t crc16(uint16_t seed, const uint8_t *data, uint8_t len);
+
+#endif // CRC16_H
@@ -0,0 +1,92 @@
+/**
+ * @file
+ * @brief Q15 fixed-point kernels on the MPY32 hardware multiplier.
+ */
+#include "dsp.h"
+
+#ifdef __MSP430__
+#include "intrinsics.h"
+#include "msp430fr2355.h"
+#include <driverlib.h>
+#endif
+
+// Half an LSB of the Q15 result, which is the high word of the Q31 sum
+#define ROUND_Q31 0x8000L
+
+#ifdef __MSP430_HAS_MPY32__
+
+// Run a multiply-accumulate sequence in fractional and saturation mode
+// without disturbing a compiler multiply or another user of the MPY32
+#define MPY32_BEGIN()                                   \
+    unsigned short int_state = __get_interrupt_state(); \
+    __disable_interrupt();                              \
+    uint16_t saved_mode = MPY32CTL0;                    \
+    MPY32_enableFractionalMode();                       \
+    MPY32_enableSaturationMode();                       \
+    RESLO = ROUND_Q31;                                  \
+    RESHI = 0
+
+#define MPY32_END(result)                               \
+    result = (int16_t)RESHI;                            \
+    MPY32CTL0 = saved_mode;                             \
+    __set_interrupt_state(int_state)
+
+int16_t dsp_q15_scale(int16_t x, int16_t gain)
+{
+    int16_t result;
+
+    MPY32_BEGIN();
+    MPY32_setOperandOne16Bit(MPY32_MULTIPLYACCUMULATE_SIGNED, x);
+    MPY32_setOperandTwo16Bit(gain);
+    MPY32_END(result);
+    return result;
+}
+
+int16_t dsp_q15_dot(const int16_t *a, const int16_t *b, uint8_t n)
+{
+    int16_t result;
+
+    MPY32_BEGIN();
+    while (n--)
+    {
+        MPY32_setOperandOne16Bit(MPY32_MULTIPLYACCUMULATE_SIGNED, *a++);
+        MPY32_setOperandTwo16Bit(*b++);
+    }
+    MPY32_END(result);
+    return result;
+}
+
+#else
+
+// Bit-exact model of the MPY32 sequence above: Q31 sum with the rounding
+// preload, saturated on read, high word returned
+static int16_t saturate_high(int64_t q31)
+{
+    if (q31 > INT32_MAX)
+    {
+        return INT16_MAX;
+    }
+    if (q31 < INT32_MIN)
+    {
+        return INT16_MIN;
+    }
+    return (int16_t)(((int32_t)q31) >> 16);
+}
+
+int16_t dsp_q15_scale(int16_t x, int16_t gain)
+{
+    return saturate_high(ROUND_Q31 + 2 * (int64_t)x * gain);
+}
+
+int16_t dsp_q15_dot(const int16_t *a, const int16_t *b, uint8_t n)
+{
+    int64_t acc = ROUND_Q31;
+
+    while (n--)
+    {
+        acc += 2 * (int64_t)*a++ * *b++;
+    }
+    return saturate_high(acc);
+}
+
+#endif
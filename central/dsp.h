@@ -0,0 +1,48 @@
+/**
+ * @file
+ * @brief Q15 fixed-point kernels on the MPY32 hardware multiplier.
+ *
+ * Products are formed with MPY32 fractional mode (the Q30 product is shifted
+ * up to Q31) and read back with saturation on, so the fixed-point scaling and
+ * the clamp cost nothing. Results are rounded to nearest by preloading half
+ * an LSB into the result registers before the multiply-accumulate.
+ *
+ * Where there is no MPY32 (__MSP430_HAS_MPY32__ undefined, e.g. on a host)
+ * the same functions are built from portable C that reproduces the hardware
+ * results bit for bit, and serves as the model to test against.
+ *
+ * Each call saves and restores the multiplier mode with interrupts disabled,
+ * so the kernels can be used from both the main loop and ISRs alongside
+ * compiler-generated multiplies.
+ */
+#ifndef DSP_H
+#define DSP_H
+
+#include <stdint.h>
+
+/**
+ * Scale an integer by a Q15 gain: x * gain / 32768, rounded to nearest.
+ *
+ * @param: x Value to scale, any int16_t.
+ * @param: gain Q15 gain in [-1, 1).
+ *
+ * @return: The scaled value, saturated to int16_t.
+ */
+int16_t dsp_q15_scale(int16_t x, int16_t gain);
+
+/**
+ * Dot product of two Q15 vectors, rounded to nearest.
+ *
+ * The sum is saturated once at the end, so partial sums must stay within
+ * [-1, 1); weights that are all non-negative and sum to at most 1.0, as in an
+ * averaging FIR, always do.
+ *
+ * @param: a First vector.
+ * @param: b Second vector.
+ * @param: n Number of elements.
+ *
+ * @return: sum of a[i] * b[i] in Q15, saturated.
+ */
+int16_t dsp_q15_dot(const int16_t *a, const int16_t *b, uint8_t n);
+
+#endif // DSP_H
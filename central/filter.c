@@ -0,0 +1,174 @@
+/**
+ * @file
+ * @brief Selectable smoothing filter for the decimated temperature samples.
+ */
+#include "filter.h"
+
+#include "dsp.h"
+#include "rolling_avg.h"
+
+// Hamming-windowed sinc low-pass, cutoff 0.08 of the sample rate, Q15. All
+// taps are positive and sum to exactly 1.0, so the output cannot overflow.
+static const int16_t fir_coeffs[FILTER_FIR_TAPS] = {
+    415, 1780, 5417, 8772, 8772, 5417, 1780, 415,
+};
+
+static uint8_t kind = FILTER_BOXCAR;
+static uint16_t output = 0;             // last output of the EMA, median and FIR filters
+
+static struct rolling_avg boxcar;
+
+static struct
+{
+    uint32_t acc;                       // average << shift
+    uint8_t shift;
+    bool primed;
+} ema;
+
+static struct
+{
+    uint16_t ring[FILTER_MEDIAN_MAX_WINDOW];    // arrival order; the oldest sample is at head once full
+    uint16_t sorted[FILTER_MEDIAN_MAX_WINDOW];  // the same samples in ascending order
+    uint8_t head;
+    uint8_t count;
+    uint8_t size;
+} median;
+
+static struct
+{
+    int16_t history[2 * FILTER_FIR_TAPS];   // samples re-centred on 0, stored twice so the last
+    uint8_t head;                           // FILTER_FIR_TAPS are always contiguous from history[head]
+    uint8_t count;
+} fir;
+
+bool filter_select(uint8_t new_kind, uint8_t size)
+{
+    if ((new_kind >= FILTER_COUNT) || !rolling_avg_init(&boxcar, size))
+    {
+        return false;
+    }
+
+    kind = new_kind;
+
+    // EMA with alpha = 2^-k has a time constant of about 2^k samples
+    ema.shift = 0;
+    while (((1U << ema.shift) < size) && (ema.shift < FILTER_EMA_MAX_SHIFT))
+    {
+        ema.shift++;
+    }
+    ema.primed = false;
+
+    median.size = ((size > FILTER_MEDIAN_MAX_WINDOW) ? FILTER_MEDIAN_MAX_WINDOW : size) | 1;
+    median.head = 0;
+    median.count = 0;
+
+    fir.head = 0;
+    fir.count = 0;
+    return true;
+}
+
+static void ema_push(uint16_t sample)
+{
+    if (!ema.primed)
+    {
+        ema.acc = (uint32_t)sample << ema.shift;
+        ema.primed = true;
+    }
+    else
+    {
+        ema.acc = ema.acc - (ema.acc >> ema.shift) + sample;
+    }
+    output = (uint16_t)((ema.acc + ((1UL << ema.shift) >> 1)) >> ema.shift);
+}
+
+static void median_push(uint16_t sample)
+{
+    uint8_t i;
+
+    // drop the oldest sample from the sorted copy
+    if (median.count == median.size)
+    {
+        uint16_t oldest = median.ring[median.head];
+        for (i = 0; median.sorted[i] != oldest; i++)
+        {
+        }
+        for (; i + 1 < median.count; i++)
+        {
+            median.sorted[i] = median.sorted[i + 1];
+        }
+        median.count--;
+    }
+
+    median.ring[median.head] = sample;
+    median.head = (median.head + 1 == median.size) ? 0 : median.head + 1;
+
+    // insertion step keeps the copy sorted
+    for (i = median.count; (i > 0) && (median.sorted[i - 1] > sample); i--)
+    {
+        median.sorted[i] = median.sorted[i - 1];
+    }
+    median.sorted[i] = sample;
+    median.count++;
+
+    output = median.sorted[median.count / 2];
+}
+
+static void fir_push(uint16_t sample)
+{
+    int16_t centred = (int16_t)(sample - 0x8000);
+
+    fir.history[fir.head] = centred;
+    fir.history[fir.head + FILTER_FIR_TAPS] = centred;
+    fir.head = (fir.head + 1 == FILTER_FIR_TAPS) ? 0 : fir.head + 1;
+    if (fir.count < FILTER_FIR_TAPS)
+    {
+        fir.count++;
+    }
+
+    // oldest to newest from history[head]; the taps are symmetric, so their order doesn't matter
+    output = (uint16_t)dsp_q15_dot(fir_coeffs, &fir.history[fir.head], FILTER_FIR_TAPS) + 0x8000;
+}
+
+void filter_push(uint16_t sample)
+{
+    switch (kind)
+    {
+        case FILTER_BOXCAR:
+            rolling_avg_push(&boxcar, sample);
+            break;
+        case FILTER_EMA:
+            ema_push(sample);
+            break;
+        case FILTER_MEDIAN:
+            median_push(sample);
+            break;
+        default:
+            fir_push(sample);
+            break;
+    }
+}
+
+bool filter_ready(void)
+{
+    switch (kind)
+    {
+        case FILTER_BOXCAR:
+            return rolling_avg_full(&boxcar);
+        case FILTER_EMA:
+            return ema.primed;
+        case FILTER_MEDIAN:
+            return median.count == median.size;
+        default:
+            return fir.count == FILTER_FIR_TAPS;
+    }
+}
+
+uint16_t filter_output(void)
+{
+    // the boxcar mean costs a division, so it is only worked out when asked for
+    if (kind == FILTER_BOXCAR)
+    {
+        return rolling_avg_mean(&boxcar);
+    }
+    return output;
+}
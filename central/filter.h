@@ -0,0 +1,74 @@
+/**
+ * @file
+ * @brief Selectable smoothing filter for the decimated temperature samples.
+ *
+ * One filter is active at a time and is fed every decimated sample:
+ *   - boxcar: the exact moving average from rolling_avg.h;
+ *   - EMA: exponential moving average with alpha = 2^-k, shifts only;
+ *   - median: sliding median over a sorted copy of the window, which rejects
+ *     single-sample spikes that the averaging filters smear out;
+ *   - FIR: fixed FILTER_FIR_TAPS-tap Q15 low-pass, a dot product on the
+ *     MPY32 hardware multiplier (dsp.h).
+ * Selecting a filter resets it. Samples and outputs are 16-bit left-justified
+ * ADC codes. filter_push runs from ADC_ISR; the rest is called with
+ * interrupts disabled or from the ISR.
+ */
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Largest median window, odd */
+#define FILTER_MEDIAN_MAX_WINDOW 15
+
+/** Largest EMA shift: alpha = 1/256 */
+#define FILTER_EMA_MAX_SHIFT 8
+
+/** FIR length, a power of two */
+#define FILTER_FIR_TAPS 8
+
+/**
+ * Available filters
+ */
+enum filter_kind
+{
+    FILTER_BOXCAR,          /**< Moving average over size samples */
+    FILTER_EMA,             /**< Exponential moving average, time constant about size samples */
+    FILTER_MEDIAN,          /**< Median of size samples, rounded up to odd and capped */
+    FILTER_FIR,             /**< Fixed low-pass FIR, size unused */
+    FILTER_COUNT
+};
+
+/**
+ * Select and reset the active filter.
+ *
+ * @param: kind Filter to use, an enum filter_kind.
+ * @param: size Window size in samples: [1, ROLLING_AVG_MAX_WINDOW].
+ *
+ * @return: true if kind and size were accepted; otherwise nothing changes.
+ */
+bool filter_select(uint8_t kind, uint8_t size);
+
+/**
+ * Feed a sample to the active filter.
+ *
+ * @param: sample Decimated sample.
+ */
+void filter_push(uint16_t sample);
+
+/**
+ * Check whether the active filter has seen enough samples for a valid output.
+ *
+ * @return: true once the filter's window or delay line is full.
+ */
+bool filter_ready(void);
+
+/**
+ * Current filter output.
+ *
+ * @return: The filtered sample; only meaningful once filter_ready.
+ */
+uint16_t filter_output(void);
+
+#endif // FILTER_H
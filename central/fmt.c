@@ -0,0 +1,75 @@
+/**
+ * @file
+ * @brief Fixed-width decimal formatting straight into a character buffer.
+ */
+#include "fmt.h"
+
+// v / 10 for every 16-bit v: 0xCCCD / 2^19 is just over 1/10, and the error
+// stays below one step across the 16-bit range
+static uint16_t div10(uint16_t v)
+{
+    return (uint16_t)(((uint32_t)v * 0xCCCDUL) >> 19);
+}
+
+static void fill(char *dst, char c, uint8_t width)
+{
+    while (width--)
+    {
+        *dst++ = c;
+    }
+}
+
+void fmt_uint(char *dst, uint16_t value, uint8_t width)
+{
+    char *p = dst + width;
+
+    while (p > dst)
+    {
+        uint16_t q = div10(value);
+        *--p = '0' + (value - q * 10);
+        value = q;
+    }
+
+    if (value != 0)
+    {
+        fill(dst, '#', width);
+    }
+}
+
+void fmt_fixed1(char *dst, int16_t tenths, uint8_t width)
+{
+    char *p = dst + width;
+    uint16_t mag = (tenths < 0) ? (uint16_t)(0 - (uint16_t)tenths) : (uint16_t)tenths;
+    uint16_t q;
+
+    // fractional digit and point
+    q = div10(mag);
+    *--p = '0' + (mag - q * 10);
+    mag = q;
+    *--p = '.';
+
+    // integer part, at least one digit
+    do
+    {
+        if (p == dst)
+        {
+            fill(dst, '#', width);
+            return;
+        }
+        q = div10(mag);
+        *--p = '0' + (mag - q * 10);
+        mag = q;
+    } while (mag != 0);
+
+    if (tenths < 0)
+    {
+        if (p == dst)
+        {
+            fill(dst, '#', width);
+            return;
+        }
+        *--p = '-';
+    }
+
+    fill(dst, ' ', p - dst);
+}
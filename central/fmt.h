@@ -0,0 +1,35 @@
+/**
+ * @file
+ * @brief Fixed-width decimal formatting straight into a character buffer.
+ *
+ * A small replacement for sprintf for LCD fields: numbers are written
+ * right-justified into exactly width characters, with no terminator, so they
+ * can be dropped into the middle of the message buffer. Digits are peeled off
+ * with a multiply-and-shift divide by 10 instead of a library division. A
+ * value that does not fit fills its field with '#'.
+ */
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdint.h>
+
+/**
+ * Write an unsigned integer, zero-padded to width digits, e.g. "007".
+ *
+ * @param: dst First character of the field.
+ * @param: value Value to write.
+ * @param: width Number of characters to write.
+ */
+void fmt_uint(char *dst, uint16_t value, uint8_t width);
+
+/**
+ * Write a signed value in tenths with one decimal place, space-padded on the
+ * left, e.g. " 23.4" or "-12.3".
+ *
+ * @param: dst First character of the field.
+ * @param: tenths Value to write, in tenths.
+ * @param: width Number of characters to write, at least 3.
+ */
+void fmt_fixed1(char *dst, int16_t tenths, uint8_t width);
+
+#endif // FMT_H
@@ -0,0 +1,162 @@
+/**
+ * @file
+ * @brief Interrupt-driven, non-blocking I2C master transmit queue on EUSCI_B0.
+ */
+#include "i2c_master.h"
+
+#include "intrinsics.h"
+#include "msp430fr2355.h"
+#include <string.h>
+
+#define QUEUE_MASK (I2C_TX_QUEUE_LEN - 1)
+
+/**
+ * A queued write transaction
+ */
+struct i2c_transaction
+{
+    /** 7-bit slave address */
+    uint8_t addr;
+
+    /** Number of bytes in data */
+    uint8_t len;
+
+    /** Payload */
+    uint8_t data[I2C_TX_MAX_LEN];
+};
+
+static struct i2c_transaction queue[I2C_TX_QUEUE_LEN];
+static volatile uint8_t queue_head = 0;     // free-running index of the transaction on the bus; advanced by the ISR
+static volatile uint8_t queue_tail = 0;     // free-running index of the next free slot; advanced by the caller
+static volatile bool tx_active = false;     // a transaction is on the bus
+static volatile uint8_t tx_index = 0;       // next byte of the active transaction to load into TXBUF
+static volatile bool tx_nacked = false;     // the slave NACKed the active transaction
+static uint8_t tx_retries = 0;              // times the active transaction has been sent again
+static volatile uint8_t drop_count = 0;     // transactions dropped after I2C_NACK_RETRIES retries
+
+// Start the transaction at the head of the queue, if any. Must run with interrupts disabled.
+static void start_next(void)
+{
+    if (queue_head == queue_tail)
+    {
+        tx_active = false;
+        return;
+    }
+
+    const struct i2c_transaction *t = &queue[queue_head & QUEUE_MASK];
+    tx_active = true;
+    tx_index = 0;
+
+    UCB0CTLW0 |= UCSWRST;                   // TBCNT can only be changed in reset
+    UCB0TBCNT = t->len;                     // auto STOP after len bytes
+    UCB0I2CSA = t->addr;
+    UCB0CTLW0 &= ~UCSWRST;
+    UCB0IE |= UCTXIE0 | UCSTPIE | UCNACKIE;
+
+    UCB0CTLW0 |= UCTR | UCTXSTT;            // generate START; TXIFG0 requests the first byte
+}
+
+void i2c_master_setup(void)
+{
+    UCB0CTLW0 |= UCSWRST;   // Hold USCI in reset
+
+    //-- Setup I2C Pins
+    P1SEL1 &= ~(BIT2 | BIT3);
+    P1SEL0 |=  (BIT2 | BIT3);
+
+    //-- Configure I2C
+    UCB0CTLW0 = UCSWRST | UCSSEL_3 | UCMODE_3 | UCMST | UCTR | UCSYNC; // SMCLK, I2C master, Tx mode
+    UCB0BRW = 10;                   // SCL = SMCLK / 10 = 100kHz
+
+    UCB0CTLW1 = UCASTP_2;           // Auto STOP after TBCNT bytes
+
+    PM5CTL0 &= ~LOCKLPM5;           // Enable GPIOs
+
+    UCB0CTLW0 &= ~UCSWRST;          // Release from reset
+
+    __delay_cycles(10000);          // Setup settle delay
+}
+
+bool i2c_master_enqueue(uint8_t addr, const uint8_t *data, uint8_t len)
+{
+    if ((len == 0) || (len > I2C_TX_MAX_LEN))
+    {
+        return false;
+    }
+
+    // Only the ISR frees slots, so a slot seen free here stays free
+    if ((uint8_t)(queue_tail - queue_head) >= I2C_TX_QUEUE_LEN)
+    {
+        return false;
+    }
+
+    struct i2c_transaction *t = &queue[queue_tail & QUEUE_MASK];
+    t->addr = addr;
+    t->len = len;
+    memcpy(t->data, data, len);
+
+    unsigned short state = __get_interrupt_state();
+    __disable_interrupt();
+    queue_tail++;
+    if (!tx_active)
+    {
+        start_next();
+    }
+    __set_interrupt_state(state);
+
+    return true;
+}
+
+bool i2c_master_busy(void)
+{
+    return tx_active || (queue_head != queue_tail);
+}
+
+uint8_t i2c_master_drop_count(void)
+{
+    return drop_count;
+}
+
+#pragma vector = EUSCI_B0_VECTOR
+__interrupt void EUSCI_B0_I2C_ISR(void)
+{
+    switch (__even_in_range(UCB0IV, USCI_I2C_UCBIT9IFG))
+    {
+        case USCI_I2C_UCNACKIFG:
+            UCB0CTLW0 |= UCTXSTP;           // slave did not answer: stop, and retry or drop at STOP
+            tx_nacked = true;
+            break;
+
+        case USCI_I2C_UCSTPIFG:
+            if (tx_nacked && (tx_retries < I2C_NACK_RETRIES))
+            {
+                tx_retries++;               // leave it at the head to be sent again
+            }
+            else
+            {
+                if (tx_nacked)
+                {
+                    drop_count++;
+                }
+                tx_retries = 0;
+                queue_head++;               // transaction done (or dropped), free its slot
+            }
+            tx_nacked = false;
+            start_next();
+            __bic_SR_register_on_exit(LPM3_bits);   // let the caller queue more or pick a deeper sleep
+            break;
+
+        case USCI_I2C_UCTXIFG0:
+        {
+            const struct i2c_transaction *t = &queue[queue_head & QUEUE_MASK];
+            if (tx_index < t->len)
+            {
+                UCB0TXBUF = t->data[tx_index++];
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @brief Interrupt-driven, non-blocking I2C master transmit queue on EUSCI_B0.
+ *
+ * Callers copy a transaction into a small queue and return immediately. The
+ * EUSCI_B0 ISR feeds TXBUF, lets the byte counter generate the STOP, and then
+ * starts the next queued transaction, so the CPU is free (or asleep) while
+ * bytes go out on the bus. A transaction the slave NACKs is sent again up to
+ * I2C_NACK_RETRIES times and then dropped, which i2c_master_drop_count shows.
+ */
+#ifndef I2C_MASTER_H
+#define I2C_MASTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Slave address of the LCD node */
+#define I2C_ADDR_LCD 0x40
+
+/** Slave address of the LED bar node */
+#define I2C_ADDR_LED_BAR 0x45
+
+/** Number of pending transactions that can be queued, must be a power of two */
+#define I2C_TX_QUEUE_LEN 4
+
+/** Largest payload of a single transaction in bytes */
+#define I2C_TX_MAX_LEN 40
+
+/** Times a transaction the slave NACKs is sent again before it is dropped */
+#define I2C_NACK_RETRIES 2
+
+/**
+ * Configure EUSCI_B0 on P1.2 (SDA) and P1.3 (SCL) as a 100 kHz I2C master.
+ */
+void i2c_master_setup(void);
+
+/**
+ * Queue a write transaction.
+ *
+ * The payload is copied, so the caller's buffer may be reused right away.
+ *
+ * @param: addr 7-bit slave address.
+ * @param: data Bytes to send.
+ * @param: len Number of bytes to send: [1, I2C_TX_MAX_LEN].
+ *
+ * @return: false if the queue is full or len is out of range, in which case
+ *          nothing is sent.
+ */
+bool i2c_master_enqueue(uint8_t addr, const uint8_t *data, uint8_t len);
+
+/**
+ * Check for queued or in-flight transactions.
+ *
+ * The bus is clocked from SMCLK, so the CPU must not enter a low-power mode
+ * that stops SMCLK while this returns true.
+ *
+ * @return: true if the bus is in use or transactions are pending.
+ */
+bool i2c_master_busy(void);
+
+/**
+ * Count transactions dropped because the slave NACKed every try.
+ *
+ * The count is free-running and wraps; compare two readings to see whether
+ * anything was dropped in between.
+ *
+ * @return: Number of dropped transactions, modulo 256.
+ */
+uint8_t i2c_master_drop_count(void);
+
+#endif // I2C_MASTER_H
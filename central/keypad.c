@@ -0,0 +1,201 @@
+/**
+ * @file
+ * @brief 4x4 matrix keypad with timer-sampled debounce and key events.
+ */
+#include "keypad.h"
+
+#include "intrinsics.h"
+#include "msp430fr2355.h"
+#include <string.h>
+
+#define KEYPAD_COLS (BIT4 | BIT5 | BIT6 | BIT7)     // outputs on P1.4, P1.5, P1.6, P1.7
+#define KEYPAD_ROWS (BIT0 | BIT1 | BIT2 | BIT3)     // inputs on P2.0, P2.1, P2.2, P2.3
+#define KEY_COUNT 16
+#define QUEUE_MASK (KEYPAD_QUEUE_LEN - 1)
+
+// Key k is column k / 4 (driven) and row k % 4 (read)
+static const char keys[KEY_COUNT] = {
+    '1', '2', '3', 'A',
+    '4', '5', '6', 'B',
+    '7', '8', '9', 'C',
+    '*', '0', '#', 'D'
+};
+
+static const unsigned char col_pins[4] = {BIT4, BIT5, BIT6, BIT7};
+
+static uint8_t integrator[KEY_COUNT];   // debounce integrators: 0 = released, KEYPAD_DEBOUNCE_SCANS = pressed
+static uint16_t hold_scans[KEY_COUNT];  // scans since each key was pressed
+static uint16_t pressed = 0;            // debounced state, bit k for key k
+
+static struct keypad_event queue[KEYPAD_QUEUE_LEN];
+static volatile uint8_t queue_head = 0;     // free-running; advanced by the consumer only
+static volatile uint8_t queue_tail = 0;     // free-running; advanced by the timer ISR only
+
+// Raw state of all keys, bit k for key k
+static uint16_t scan_matrix(void)
+{
+    uint16_t raw = 0;
+    unsigned char i;
+
+    P1OUT &= ~KEYPAD_COLS;
+    for (i = 0; i < 4; i++)
+    {
+        P1OUT |= col_pins[i];
+        raw |= (uint16_t)(P2IN & KEYPAD_ROWS) << (i * 4);
+        P1OUT &= ~col_pins[i];
+    }
+    P1OUT |= KEYPAD_COLS;
+
+    return raw;
+}
+
+// Producer side of the queue; events are dropped while it is full
+static bool push_event(uint8_t key, uint8_t type)
+{
+    if ((uint8_t)(queue_tail - queue_head) >= KEYPAD_QUEUE_LEN)
+    {
+        return false;
+    }
+    queue[queue_tail & QUEUE_MASK].key = keys[key];
+    queue[queue_tail & QUEUE_MASK].type = type;
+    queue_tail++;
+    return true;
+}
+
+// Idle: stop scanning and wait for a rising edge on any row
+static void arm_wake(void)
+{
+    P2IFG &= ~KEYPAD_ROWS;
+    P2IE |= KEYPAD_ROWS;
+
+    // a key that went down before the edge interrupt was armed produced no edge
+    if (P2IN & KEYPAD_ROWS)
+    {
+        P2IE &= ~KEYPAD_ROWS;
+        TB2CTL |= MC__UP;
+    }
+    else
+    {
+        TB2CTL &= ~MC_3;
+    }
+}
+
+void keypad_setup(void)
+{
+    // every key released and the queue empty
+    memset(integrator, 0, sizeof(integrator));
+    pressed = 0;
+    queue_head = queue_tail;
+
+    // columns as outputs, all driven high while idle so any key pulls its row up
+    P1DIR |= KEYPAD_COLS;
+    P1OUT |= KEYPAD_COLS;
+
+    // rows as inputs pulled down internally, interrupting on the rising edge
+    P2DIR &= ~KEYPAD_ROWS;
+    P2REN |= KEYPAD_ROWS;
+    P2OUT &= ~KEYPAD_ROWS;
+    P2IES &= ~KEYPAD_ROWS;
+
+    // scan timer on ACLK so it keeps running in LPM3; started by the first edge
+    TB2CTL = TBSSEL__ACLK | MC__STOP | TBCLR;
+    TB2CCR0 = KEYPAD_SCAN_TICKS - 1;
+    TB2CCTL0 = CCIE;
+
+    arm_wake();
+}
+
+bool keypad_scan_step(uint16_t raw)
+{
+    uint16_t bit = 1;
+    uint8_t busy = 0;
+    uint8_t k;
+
+    for (k = 0; k < KEY_COUNT; k++, bit <<= 1)
+    {
+        // integrate towards the raw reading; the state only flips at the ends
+        if (raw & bit)
+        {
+            if (integrator[k] < KEYPAD_DEBOUNCE_SCANS)
+            {
+                integrator[k]++;
+            }
+        }
+        else if (integrator[k] > 0)
+        {
+            integrator[k]--;
+        }
+        busy |= integrator[k];
+
+        if (!(pressed & bit))
+        {
+            if (integrator[k] == KEYPAD_DEBOUNCE_SCANS)
+            {
+                pressed |= bit;
+                hold_scans[k] = 0;
+                push_event(k, KEYPAD_PRESS);
+            }
+        }
+        else if (integrator[k] == 0)
+        {
+            pressed &= ~bit;
+            push_event(k, KEYPAD_RELEASE);
+        }
+        else
+        {
+            hold_scans[k]++;
+            if (hold_scans[k] == KEYPAD_LONG_PRESS_SCANS)
+            {
+                push_event(k, KEYPAD_LONG_PRESS);
+            }
+            else if (hold_scans[k] == KEYPAD_LONG_PRESS_SCANS + KEYPAD_REPEAT_SCANS)
+            {
+                hold_scans[k] = KEYPAD_LONG_PRESS_SCANS;
+                push_event(k, KEYPAD_REPEAT);
+            }
+        }
+    }
+
+    return busy != 0;
+}
+
+bool keypad_get_event(struct keypad_event *event)
+{
+    if (queue_head == queue_tail)
+    {
+        return false;
+    }
+    *event = queue[queue_head & QUEUE_MASK];
+    queue_head++;
+    return true;
+}
+
+bool keypad_has_event(void)
+{
+    return queue_head != queue_tail;
+}
+
+#pragma vector = PORT2_VECTOR
+__interrupt void PORT2_ISR(void)
+{
+    // hand over to the scan timer; edges are ignored until every key is released
+    P2IE &= ~KEYPAD_ROWS;
+    P2IFG &= ~KEYPAD_ROWS;
+    TB2CTL |= TBCLR | MC__UP;
+}
+
+#pragma vector = TIMER2_B0_VECTOR
+__interrupt void KEYPAD_SCAN_ISR(void)
+{
+    uint8_t queued = queue_tail;
+
+    if (!keypad_scan_step(scan_matrix()))
+    {
+        arm_wake();
+    }
+
+    if (queued != queue_tail)
+    {
+        __bic_SR_register_on_exit(LPM3_bits);   // events for the main loop
+    }
+}
@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief 4x4 matrix keypad with timer-sampled debounce and key events.
+ *
+ * Columns are driven on P1.4-P1.7 and rows are read on P2.0-P2.3 with
+ * pull-downs. While idle all columns are driven high and the rows are armed
+ * for rising-edge interrupts, so a key press wakes the CPU from LPM3. The
+ * wake-up starts Timer_B2, which scans the whole matrix every
+ * KEYPAD_SCAN_TICKS of ACLK and runs a debounce integrator per key. Each key
+ * is tracked independently (n-key rollover). Presses, releases, long presses
+ * and auto-repeats go into a lock-free single-producer/single-consumer queue
+ * that the main loop drains with keypad_get_event. The timer stops itself
+ * once every key has been released.
+ *
+ * The matrix has no diodes, so holding three keys on the corners of a
+ * rectangle also reads the fourth corner as pressed.
+ */
+#ifndef KEYPAD_H
+#define KEYPAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Scan period in ACLK (32.768 kHz) ticks: 5 ms */
+#define KEYPAD_SCAN_TICKS 164
+
+/** Consecutive scans a key must agree on before it changes state: 20 ms */
+#define KEYPAD_DEBOUNCE_SCANS 4
+
+/** Scans a key is held before a long press is reported: 1 s */
+#define KEYPAD_LONG_PRESS_SCANS 200
+
+/** Scans between auto-repeats after a long press: 200 ms */
+#define KEYPAD_REPEAT_SCANS 40
+
+/** Number of events the queue holds, must be a power of two */
+#define KEYPAD_QUEUE_LEN 16
+
+/**
+ * Kinds of key event
+ */
+enum keypad_event_type
+{
+    KEYPAD_PRESS,       /**< Key went down */
+    KEYPAD_RELEASE,     /**< Key went up */
+    KEYPAD_LONG_PRESS,  /**< Key held for KEYPAD_LONG_PRESS_SCANS */
+    KEYPAD_REPEAT       /**< Key still held, every KEYPAD_REPEAT_SCANS after a long press */
+};
+
+/**
+ * A debounced key event
+ */
+struct keypad_event
+{
+    /** Key character: '0'-'9', 'A'-'D', '*' or '#' */
+    char key;
+
+    /** An enum keypad_event_type */
+    uint8_t type;
+};
+
+/**
+ * Configure the column and row pins and the scan timer, and arm the wake-up
+ * interrupt.
+ */
+void keypad_setup(void);
+
+/**
+ * Run the debounce integrators on one scan of the matrix and queue the events
+ * it produces. The scan timer's ISR calls this; it touches no registers.
+ *
+ * @param: raw Keys that read as down in this scan, bit k for key k in
+ *         keypad order ("123A456B789C*0#D").
+ *
+ * @return: false once every key has settled released, so scanning can stop.
+ */
+bool keypad_scan_step(uint16_t raw);
+
+/**
+ * Take the oldest event from the queue.
+ *
+ * @param: event Filled in with the event.
+ *
+ * @return: false if the queue is empty.
+ */
+bool keypad_get_event(struct keypad_event *event);
+
+/**
+ * Check for queued events without taking one.
+ *
+ * @return: true if keypad_get_event would return an event.
+ */
+bool keypad_has_event(void);
+
+#endif // KEYPAD_H
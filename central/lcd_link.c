@@ -0,0 +1,97 @@
+/**
+ * @file
+ * @brief Sends LCD frame changes to the LCD node as dirty spans.
+ */
+#include "lcd_link.h"
+
+#include "crc16.h"
+#include "i2c_master.h"
+#include "lcd_protocol.h"
+#include <stdint.h>
+#include <string.h>
+
+// Unchanged cells between two changed runs that are still sent inside one span.
+// A new span costs 2 header bytes and a cursor move on the LCD, so bridging a
+// single unchanged cell is no more expensive than starting a new span.
+#define SPAN_MERGE_GAP 1
+
+static char sent[LCD_FRAME_LEN];    // frame as of the last queued transaction
+static bool sent_valid = false;     // false until a full frame has been queued
+static uint8_t ticks = 0;           // lcd_link_tick calls since the last full frame
+
+void lcd_link_invalidate(void)
+{
+    sent_valid = false;
+}
+
+void lcd_link_tick(void)
+{
+    if (++ticks >= LCD_LINK_RESYNC_TICKS)
+    {
+        sent_valid = false;
+    }
+}
+
+bool lcd_link_update(const char *frame)
+{
+    uint8_t buf[LCD_MAX_TRANSACTION_LEN];
+    uint8_t len = 0;
+    uint8_t i = 0;
+
+    if (!sent_valid)
+    {
+        ticks = 0;
+        buf[len++] = 0;
+        buf[len++] = LCD_FRAME_LEN;
+        memcpy(&buf[len], frame, LCD_FRAME_LEN);
+        len += LCD_FRAME_LEN;
+    }
+    else
+    {
+        while (i < LCD_FRAME_LEN)
+        {
+            if (frame[i] == sent[i])
+            {
+                i++;
+                continue;
+            }
+
+            // Extend the span over changed cells and short unchanged gaps
+            uint8_t start = i;
+            uint8_t end = i + 1;
+            uint8_t j;
+            for (j = end; (j < LCD_FRAME_LEN) && (j <= end + SPAN_MERGE_GAP); j++)
+            {
+                if (frame[j] != sent[j])
+                {
+                    end = j + 1;
+                }
+            }
+
+            // Gaps are at least SPAN_MERGE_GAP + 1 cells, so this never overflows buf
+            buf[len++] = start;
+            buf[len++] = end - start;
+            memcpy(&buf[len], &frame[start], end - start);
+            len += end - start;
+            i = end;
+        }
+
+        if (len == 0)
+        {
+            return true;
+        }
+    }
+
+    uint16_t crc = crc16(LCD_CRC_SEED, (const uint8_t *)frame, LCD_FRAME_LEN);
+    buf[len++] = crc >> 8;
+    buf[len++] = crc & 0xFF;
+
+    if (!i2c_master_enqueue(I2C_ADDR_LCD, buf, len))
+    {
+        return false;
+    }
+
+    memcpy(sent, frame, LCD_FRAME_LEN);
+    sent_valid = true;
+    return true;
+}
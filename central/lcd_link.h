@@ -0,0 +1,45 @@
+/**
+ * @file
+ * @brief Sends LCD frame changes to the LCD node as dirty spans.
+ *
+ * The link keeps a copy of the last frame it queued and, on each update,
+ * sends only the cells that differ, followed by the CRC of the whole frame.
+ * Every LCD_LINK_RESYNC_TICKS calls of lcd_link_tick the next update sends
+ * the whole frame again, so a transaction the LCD node dropped is repaired.
+ * The controller ticks the link with each average it shows, at DISPLAY_HZ
+ * (2 Hz), so that is every 4 s while samples are streaming. In monitor mode
+ * nothing is shown between crossings and the next resend waits for one, a
+ * key press or the end of monitoring. See lcd_protocol.h for the wire format.
+ */
+#ifndef LCD_LINK_H
+#define LCD_LINK_H
+
+#include <stdbool.h>
+
+/** Number of lcd_link_tick calls between full-frame resends */
+#define LCD_LINK_RESYNC_TICKS 8
+
+/**
+ * Forget the last sent frame so that the next update resends every cell.
+ */
+void lcd_link_invalidate(void);
+
+/**
+ * Count one tick of the caller's time base towards the next full-frame resend.
+ */
+void lcd_link_tick(void);
+
+/**
+ * Queue the cells of frame that changed since the last successful update.
+ *
+ * Cheap to call when nothing changed: it only compares the frame with the
+ * last sent copy.
+ *
+ * @param: frame LCD_FRAME_LEN characters, top row first.
+ *
+ * @return: false if the changes could not be queued; the changes are kept
+ *          and retried on the next call.
+ */
+bool lcd_link_update(const char *frame);
+
+#endif // LCD_LINK_H
@@ -0,0 +1,218 @@
+/**
+ * @file
+ * @brief Batches LED bar commands into CRC-checked frames.
+ */
+#include "led_link.h"
+
+#include "crc16.h"
+#include "i2c_master.h"
+#include "led_protocol.h"
+#include <string.h>
+
+static bool period_pending = false;
+static uint16_t pending_period;
+
+static bool display_pending = false;
+static uint8_t display_cmd;                 // LED_CMD_SET_PATTERN, _SET_RAW, _SEQ_PLAY or _PROG_RUN
+static uint8_t display_arg;
+
+static struct
+{
+    const uint8_t *frames;
+    uint8_t slot;
+    uint8_t count;
+    uint8_t next;                           // first frame not yet sent; count once only the commit is left
+    bool pending;                           // frames or the commit still to queue
+    bool checking;                          // all queued; check for drops once the bus is idle
+    uint8_t drops;                          // i2c_master_drop_count when this attempt started
+    uint8_t attempts;
+    bool failed;
+} upload;
+
+// Start sending the upload from its first frame
+static void upload_start(void)
+{
+    upload.next = 0;
+    upload.pending = true;
+    upload.checking = false;
+    upload.drops = i2c_master_drop_count();
+    upload.attempts++;
+}
+
+void led_link_set_pattern(uint8_t pattern)
+{
+    display_cmd = LED_CMD_SET_PATTERN;
+    display_arg = pattern;
+    display_pending = true;
+}
+
+void led_link_set_period(uint16_t period)
+{
+    pending_period = period;
+    period_pending = true;
+}
+
+void led_link_set_raw(uint8_t bits)
+{
+    display_cmd = LED_CMD_SET_RAW;
+    display_arg = bits;
+    display_pending = true;
+}
+
+void led_link_play_sequence(uint8_t slot)
+{
+    display_cmd = LED_CMD_SEQ_PLAY;
+    display_arg = slot;
+    display_pending = true;
+}
+
+void led_link_run_program(uint8_t slot)
+{
+    display_cmd = LED_CMD_PROG_RUN;
+    display_arg = slot;
+    display_pending = true;
+}
+
+bool led_link_upload_sequence(uint8_t slot, const uint8_t *frames, uint8_t count)
+{
+    if (upload.pending || upload.checking || (slot >= LED_SEQ_SLOTS) || (count == 0) ||
+        (count > LED_SEQ_MAX_FRAMES))
+    {
+        return false;
+    }
+    upload.frames = frames;
+    upload.slot = slot;
+    upload.count = count;
+    upload.attempts = 0;
+    upload.failed = false;
+    upload_start();
+    return true;
+}
+
+bool led_link_upload_failed(void)
+{
+    return upload.failed;
+}
+
+// Fill in the header and CRC around len - LED_FRAME_HEADER_LEN bytes of commands and queue it
+static bool send_frame(uint8_t *frame, uint8_t len)
+{
+    frame[0] = LED_FRAME_START;
+    frame[1] = len - LED_FRAME_HEADER_LEN;
+    uint16_t crc = crc16(LED_CRC_SEED, frame, len);
+    frame[len++] = crc >> 8;
+    frame[len++] = crc & 0xFF;
+
+    return i2c_master_enqueue(I2C_ADDR_LED_BAR, frame, len);
+}
+
+// Send as much of a pending upload as the queue takes
+static bool upload_flush(void)
+{
+    uint8_t frame[LED_MAX_TRANSACTION_LEN];
+
+    while (upload.pending)
+    {
+        uint8_t len = LED_FRAME_HEADER_LEN;
+        uint8_t n = upload.count - upload.next;
+
+        if (n != 0)
+        {
+            if (n > LED_SEQ_CHUNK_FRAMES)
+            {
+                n = LED_SEQ_CHUNK_FRAMES;
+            }
+            frame[len++] = LED_CMD_SEQ_WRITE;
+            frame[len++] = upload.slot;
+            frame[len++] = upload.next;
+            frame[len++] = n;
+            memcpy(&frame[len], &upload.frames[upload.next * LED_SEQ_FRAME_LEN], n * LED_SEQ_FRAME_LEN);
+            len += n * LED_SEQ_FRAME_LEN;
+        }
+        else
+        {
+            uint16_t crc = crc16(LED_CRC_SEED, upload.frames, upload.count * LED_SEQ_FRAME_LEN);
+            frame[len++] = LED_CMD_SEQ_COMMIT;
+            frame[len++] = upload.slot;
+            frame[len++] = upload.count;
+            frame[len++] = crc >> 8;
+            frame[len++] = crc & 0xFF;
+        }
+
+        if (!send_frame(frame, len))
+        {
+            return false;
+        }
+        upload.next += n;
+        upload.pending = (n != 0);
+        upload.checking = !upload.pending;
+    }
+    return true;
+}
+
+// Once the upload is off the bus, send it again if the I2C master dropped a frame meanwhile. Any
+// dropped frame counts, even one to the LCD: re-sending is cheaper than a slot that never plays.
+static void upload_check(void)
+{
+    if (!upload.checking || i2c_master_busy())
+    {
+        return;
+    }
+    upload.checking = false;
+    if (i2c_master_drop_count() == upload.drops)
+    {
+        return;
+    }
+
+    if (upload.attempts < LED_LINK_UPLOAD_ATTEMPTS)
+    {
+        upload_start();
+        // the LED bar stops a slot while it is rewritten, so play it again afterwards
+        if (((display_cmd == LED_CMD_SEQ_PLAY) || (display_cmd == LED_CMD_PROG_RUN)) && (display_arg == upload.slot))
+        {
+            display_pending = true;
+        }
+    }
+    else
+    {
+        upload.failed = true;
+    }
+}
+
+bool led_link_flush(void)
+{
+    uint8_t frame[LED_MAX_TRANSACTION_LEN];
+    uint8_t len = LED_FRAME_HEADER_LEN;
+
+    // an upload goes first, so a play of the new sequence follows its commit
+    upload_check();
+    if (!upload_flush())
+    {
+        return false;
+    }
+    if (!period_pending && !display_pending)
+    {
+        return true;
+    }
+
+    // period first, so a new pattern starts at the new speed
+    if (period_pending)
+    {
+        frame[len++] = LED_CMD_SET_PERIOD;
+        frame[len++] = pending_period >> 8;
+        frame[len++] = pending_period & 0xFF;
+    }
+    if (display_pending)
+    {
+        frame[len++] = display_cmd;
+        frame[len++] = display_arg;
+    }
+
+    if (!send_frame(frame, len))
+    {
+        return false;
+    }
+    period_pending = false;
+    display_pending = false;
+    return true;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief Batches LED bar commands into CRC-checked frames.
+ *
+ * Commands only update a pending set; led_link_flush sends everything
+ * pending as one frame (see led_protocol.h), so several changes made while
+ * handling a key cost a single I2C transaction. Only the latest period and
+ * the latest display command (pattern, raw bits, sequence or program) are
+ * kept.
+ *
+ * A sequence upload is sent ahead of them, a chunk per frame, over as many
+ * flushes as the I2C queue needs. The LED bar can't be read back, so once
+ * the upload has gone out, a flush with the bus idle checks whether the I2C
+ * master dropped anything meanwhile; if it did, the upload (and a play of
+ * its slot) is sent again, up to LED_LINK_UPLOAD_ATTEMPTS times in all.
+ */
+#ifndef LED_LINK_H
+#define LED_LINK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Times an upload is sent before led_link_upload_failed reports it */
+#define LED_LINK_UPLOAD_ATTEMPTS 3
+
+/**
+ * Run a pattern on the next flush.
+ *
+ * @param: pattern Pattern 0-8, or LED_PATTERN_OFF.
+ */
+void led_link_set_pattern(uint8_t pattern);
+
+/**
+ * Set the base period on the next flush.
+ *
+ * @param: period Base period in 512 Hz ticks: [LED_PERIOD_MIN, LED_PERIOD_MAX].
+ */
+void led_link_set_period(uint16_t period);
+
+/**
+ * Show fixed bits instead of a pattern on the next flush.
+ *
+ * @param: bits LED states, bit 0 on the first LED.
+ */
+void led_link_set_raw(uint8_t bits);
+
+/**
+ * Play an uploaded sequence on the next flush.
+ *
+ * @param: slot Sequence slot: [0, LED_SEQ_SLOTS).
+ */
+void led_link_play_sequence(uint8_t slot);
+
+/**
+ * Run an uploaded VM program on the next flush.
+ *
+ * @param: slot Sequence slot holding the program: [0, LED_SEQ_SLOTS).
+ */
+void led_link_run_program(uint8_t slot);
+
+/**
+ * Start storing a sequence, or a VM program, in the LED bar's FRAM.
+ *
+ * The frames are sent by the following flushes, and the upload is
+ * committed with their CRC once all of them are out; a play of the same
+ * slot requested meanwhile is sent after the commit.
+ *
+ * @param: slot Sequence slot: [0, LED_SEQ_SLOTS).
+ * @param: frames count frames of [bits][duration] (see led_protocol.h);
+ *         must stay valid until the upload is done.
+ * @param: count Number of frames: [1, LED_SEQ_MAX_FRAMES].
+ *
+ * @return: false if another upload is in progress or an argument is out of
+ *          range; nothing is sent.
+ */
+bool led_link_upload_sequence(uint8_t slot, const uint8_t *frames, uint8_t count);
+
+/**
+ * Check whether the last upload gave up.
+ *
+ * @return: true if every attempt at the last upload lost a frame on the way,
+ *          so the slot can't be played; false while it is in progress or once
+ *          it has gone through.
+ */
+bool led_link_upload_failed(void);
+
+/**
+ * Queue one frame with every pending command.
+ *
+ * @return: false if the frame could not be queued; the commands stay
+ *          pending and are retried on the next call.
+ */
+bool led_link_flush(void);
+
+#endif // LED_LINK_H
@@ -0,0 +1,53 @@
+/**
+ * @file
+ * @brief Integer-only LM19 temperature conversion from 16-bit left-justified ADC codes.
+ */
+#include "lm19.h"
+#include "dsp.h"
+#include "lm19_table.h"
+
+// Q15 scale factors for converting hundredths of a degree C:
+// 0.1 for tenths of a degree C, 0.18 for tenths of a degree F (before the 32 F offset)
+#define CENTI_TO_DECI_Q15 3277
+#define CENTI_C_TO_DECI_F_Q15 5898
+
+int16_t lm19_centi_c(uint16_t code)
+{
+    return lm19_lookup(code);
+}
+
+int16_t lm19_deci_c(uint16_t code)
+{
+    return dsp_q15_scale(lm19_centi_c(code), CENTI_TO_DECI_Q15);
+}
+
+int16_t lm19_deci_f(uint16_t code)
+{
+    return dsp_q15_scale(lm19_centi_c(code), CENTI_C_TO_DECI_F_Q15) + 320;
+}
+
+uint16_t lm19_code_at_centi_c(int16_t centi)
+{
+    uint16_t lo = 0;
+    uint16_t hi = 0xFFFF;
+
+    if (lm19_centi_c(hi) > centi)
+    {
+        return hi;
+    }
+
+    // lm19_centi_c never increases with the code, so bisect for the first code at or below centi
+    while (lo < hi)
+    {
+        uint16_t mid = lo + (hi - lo) / 2;
+        if (lm19_centi_c(mid) <= centi)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @brief Integer-only LM19 temperature conversion from 16-bit left-justified ADC codes.
+ *
+ * The LM19 transfer function is tabulated at build time by
+ * tools/gen_sensor_table.py from sensors/lm19.json (see lm19_table.h) and
+ * linearly interpolated between entries, so a conversion is one table
+ * lookup, one multiply and a few shifts instead of soft-float math and sqrt.
+ * Interpolation stays within 0.015 degrees C of the datasheet equation over
+ * the whole code range. Codes come from adc_sampler, which left-justifies its
+ * decimated samples to 16 bits whatever the oversampling.
+ */
+#ifndef LM19_H
+#define LM19_H
+
+#include <stdint.h>
+
+/**
+ * Convert an ADC code to hundredths of a degree Celsius.
+ *
+ * @param: code 16-bit left-justified ADC code.
+ *
+ * @return: Temperature in 0.01 degrees C.
+ */
+int16_t lm19_centi_c(uint16_t code);
+
+/**
+ * Convert an ADC code to tenths of a degree Celsius, rounded.
+ *
+ * @param: code 16-bit left-justified ADC code.
+ *
+ * @return: Temperature in 0.1 degrees C.
+ */
+int16_t lm19_deci_c(uint16_t code);
+
+/**
+ * Convert an ADC code to tenths of a degree Fahrenheit, rounded.
+ *
+ * @param: code 16-bit left-justified ADC code.
+ *
+ * @return: Temperature in 0.1 degrees F.
+ */
+int16_t lm19_deci_f(uint16_t code);
+
+/**
+ * Find the ADC code for a temperature, e.g. to turn a limit into an ADC
+ * window-comparator threshold.
+ *
+ * The LM19 output falls as temperature rises, so codes at or above the
+ * returned one read at or below the temperature.
+ *
+ * @param: centi Temperature in 0.01 degrees C.
+ *
+ * @return: Smallest 16-bit left-justified code that reads at or below centi.
+ */
+uint16_t lm19_code_at_centi_c(int16_t centi);
+
+#endif // LM19_H
@@ -0,0 +1,31 @@
+/**
+ * @file
+ * @brief LM19 temperature sensor, 16-bit left-justified ADC code to hundredths of a degree C.
+ *
+ * Generated by tools/gen_sensor_table.py from sensors/lm19.json; do not edit.
+ */
+#include "lm19_table.h"
+
+#define TABLE_SHIFT 10
+
+// Model output times LM19_SCALE at code i << TABLE_SHIFT (16-bit codes, 3.3 V at code 65520)
+static const int16_t table[65] = {
+     15407,  15000,  14592,  14183,  13774,  13363,  12951,  12538,
+     12124,  11709,  11293,  10875,  10457,  10037,   9617,   9195,
+      8772,   8348,   7923,   7497,   7069,   6641,   6211,   5780,
+      5348,   4914,   4479,   4044,   3606,   3168,   2728,   2287,
+      1845,   1401,    956,    510,     62,   -387,   -837,  -1289,
+     -1742,  -2196,  -2652,  -3110,  -3568,  -4029,  -4490,  -4954,
+     -5418,  -5885,  -6352,  -6822,  -7293,  -7765,  -8239,  -8715,
+     -9192,  -9671, -10152, -10634, -11118, -11604, -12091, -12581,
+    -13071,
+};
+
+int16_t lm19_lookup(uint16_t code)
+{
+    uint16_t i = code >> TABLE_SHIFT;
+    int16_t frac = code & ((1 << TABLE_SHIFT) - 1);
+    int32_t product = (int32_t)(table[i + 1] - table[i]) * frac;
+
+    return table[i] + (int16_t)(product / (1 << TABLE_SHIFT));
+}
@@ -0,0 +1,30 @@
+/**
+ * @file
+ * @brief LM19 temperature sensor, 16-bit left-justified ADC code to hundredths of a degree C.
+ *
+ * Generated by tools/gen_sensor_table.py from sensors/lm19.json; do not edit.
+ */
+#ifndef LM19_TABLE_H
+#define LM19_TABLE_H
+
+#include <stdint.h>
+
+/** Width of the codes the table is indexed by */
+#define LM19_ADC_BITS 16
+
+/** Lookup output units per model unit */
+#define LM19_SCALE 100
+
+/**
+ * Convert an ADC code with the lm19 model.
+ *
+ * Interpolates linearly between table entries 1024 codes apart; the largest
+ * deviation from the model is 0.0144 model units.
+ *
+ * @param: code Decimated ADC sample from adc_sampler, 12 bits plus oversampling left-justified to 16.
+ *
+ * @return: Model output times LM19_SCALE.
+ */
+int16_t lm19_lookup(uint16_t code);
+
+#endif // LM19_TABLE_H
@@ -2,62 +2,90 @@
 #include "intrinsics.h"
 #include "msp430fr2355.h"
 #include <driverlib.h>
-#include <math.h>
+#include <stdbool.h>
 #include <string.h>
-
-//-- KEYPAD
-void setupKeypad();                         // init
-char readKeypad();                          // checks for pressed keys on keypad
-int checkCols();                            // ussed internally by readKeypad()
-char lastKey = 'X';                         // used internally for debouncing
-
-//-- ADC SAMPLING AND AVERAGING
-void setupADC();                            // init
-void readADC();                             // read value from ADC into adc_val
-int adc_val;                                // ADC buffer read into this value by ISR
-unsigned int adc_sensor_array[100];         // array to store values used to calculate average
-unsigned int adc_filled = 0;                // number of values used in average (when adc_filled == adc_buffer_length, average is accurate)
+#include "adc_sampler.h"
+#include "filter.h"
+#include "fmt.h"
+#include "i2c_master.h"
+#include "keypad.h"
+#include "lcd_link.h"
+#include "led_link.h"
+#include "led_protocol.h"
+#include "lm19.h"
+#include "scanner_program.h"
+#include "state_table.h"
+
+//-- ADC SAMPLING AND AVERAGING (adc_sampler.h: conversions are triggered by Timer_B1, no CPU involved)
+#define DISPLAY_HZ 2                        // rate the average is shown at, independent of the sample rate
+uint8_t filter_kind = FILTER_BOXCAR;        // smoothing filter applied to the decimated samples (filter.h)
+const char *const filter_names[FILTER_COUNT] = {    // names shown for each enum filter_kind
+    "Filter: Average ",
+    "Filter: EMA     ",
+    "Filter: Median  ",
+    "Filter: FIR     ",
+};
 int adc_buffer_length = 3;                  // number of values to  be used in average: can be [1,100]
 unsigned int temp_adc_buffer_length = 0;    // holds number of values to be used in average while user is entering the number
-unsigned int adc_tens = 0;                  // used to input multiple-digit number for window size
-volatile unsigned int adc_sensor_avg = 0;   // sensor average in ADC code
-void setupSampleClock();                    // setup clock on TB3 to sample ADC every 0.5s
-
-//-- ADC CODE TO C/F CONVERSION
-#define ADC_SCALER (3.3 / 4095.0)           // 3.3V / 2^12
-float adc2c(unsigned int code);             // convert ADC code to celcius
-float adc2f(unsigned int code);             // convert ADC code to fahrenheit
+volatile unsigned int adc_sensor_avg = 0;   // filtered sensor reading in 16-bit left-justified ADC code
+
+//-- MONITOR MODE (adc_sampler.h: the ADC window comparator watches the limits, the CPU sleeps in band)
+#define ALERT_PATTERN 1                     // LED bar pattern shown while the temperature is out of band
+unsigned int temp_limit = 0;                // holds the limit while the user is entering it, whole degrees in current units
+int low_limit_centi = 0;                    // low limit in hundredths of a degree C, kept until the high limit is entered
+#define LIMIT_MAX_CENTI_C 13000L            // top of the LM19 range, 130 C (266 F); higher limits are rejected. Limits
+                                            // have no sign, so the lowest, 0 C or 0 F, is inside its -55 C bottom
+bool monitoring = false;                    // window comparator armed, per-sample averaging stopped
+volatile uint8_t monitor_zone = ADC_WINDOW_INSIDE;  // zone the last crossing entered, an enum adc_window_zone
+volatile bool monitor_changed = false;      // set by the ADC ISR on a crossing, cleared when the main loop handles it
+void show_monitor_zone();                   // alert or clear on the LCD and LED bar
+
+//-- ADC CODE TO C/F CONVERSION (lm19.h)
 int corf_toggle = 0;                        // toggle temperature units between F (1) and C (0)
-float average = 0;                          // sensor average in units matching corf_toggle
-
-//-- I2C
-void i2c_master_setup();                    // init
-void i2c_send_int(unsigned char data);      // sents a 1 byte integer over i2c
-void i2c_send_msg(char *msg);         // sends a 33 byte string over i2c
+int average = 0;                            // sensor average in tenths of a degree, units matching corf_toggle
 
 //-- LCD
 char message[] =
-"LOCKED          T=##.#X    N=3  ";    // 33 characters long; first 16 are the top row, last is new line, rest are the bottom
-volatile char adc_sensor_avg_string[4];     // string to print rolling average to LCD
-char adc_buffer_length_string[3];           // string for printing window size to LCD 
+"LOCKED          T=###.#X   N=003";    // 33 characters long; first 16 are the top row, last is new line, rest are the bottom
+#define MSG_TEMP 18                         // temperature field, 5 characters, e.g. " 23.4"
+#define MSG_TEMP_WIDTH 5
+#define MSG_UNIT 23                         // 'C' or 'F'
+#define MSG_WINDOW 29                       // window size field, 3 digits, e.g. "007"
+#define MSG_WINDOW_WIDTH 3
+volatile bool average_ready = false;        // set by the sample ISR when adc_sensor_avg is a full-window average
+void show_average();                        // convert and format the latest average into message
 
 //-- LED BAR
 char cur_pattern[16] = {0};                 // saves displayed name for current pattern while user-input modes are being used
-
-// STATE
-    // 0    Locked
-    // 1    First correct digit entered
-    // 2    Second
-    // 3    Third
-    // 4    Unlocked
-    // 5    Pattern input
-    // 6    Windown input
-int state = 0;
+unsigned char cur_pattern_id = LED_PATTERN_OFF;     // pattern last selected, restored after an alert
+#define SCANNER_SLOT 0                      // LED bar slot the scanner program is uploaded to
+#define SCANNER_PATTERN 0x80                // cur_pattern_id while key '9' runs the scanner program
+void show_pattern(unsigned char id);        // send a pattern id, or run the scanner program
+#define LED_PERIOD_STEP 32                  // base period change per keypress, in 512 Hz ticks
+#define LED_PERIOD_KEY_MIN 32               // range reachable from the keypad
+#define LED_PERIOD_KEY_MAX 608
+unsigned int led_period = LED_PERIOD_DEFAULT;   // LED bar base period, sent as an exact value
+const char *const pattern_names[] = {       // names shown for patterns 0-8 and key 9
+    "Static          ",
+    "Toggle          ",
+    "Up Counter      ",
+    "In and Out      ",
+    "Down Counter    ",
+    "Rotate One Left ",
+    "Rotate 7 Right  ",
+    "Fill to the Left",
+    "Fade Wave       ",
+    "Scanner         ",
+};
+
+// STATE: see state_table.h; transitions and their side effects are table-driven
+uint8_t state = STATE_LOCKED;
+void handle_key(char key);                  // run the transition for a key press
+void sleep_until_event();                   // low-power wait for a key press, new sample or I2C progress
 
 int main(void) {
 
-    volatile uint32_t i;
-    char key_val;
+    struct keypad_event key_event;
 
     // Stop watchdog timer
     WDT_A_hold(WDT_A_BASE);
@@ -70,12 +98,12 @@ int main(void) {
     P6DIR |= BIT6;
     P6OUT &= ~BIT6;
 
-    // Setup Keypad on P1.4-3.1 (one rail of MSP breakout board)
-    setupKeypad();
+    // Setup Keypad on P1.4-P1.7 and P2.0-P2.3 (one rail of MSP breakout board)
+    keypad_setup();
 
     // Setup ADC conversion
-    setupADC();
-    setupSampleClock();
+    filter_select(filter_kind, adc_buffer_length);
+    adc_sampler_setup();
 
     // Setup I2C
     i2c_master_setup();
@@ -87,456 +115,380 @@ int main(void) {
     // enable interrupts
     __enable_interrupt();
     
-    // Send default message "LOCKED          T=##.#°X    N=3  \n"
+    // Send default message "LOCKED          T=###.#X   N=003"
     __delay_cycles(5000);
-    //i2c_send_msg(message);
+    lcd_link_update(message);
 
-    // Send default pattern - 9 (off)
-    i2c_send_int(9);
-
-    
+    // Send default pattern (off) and period
+    led_link_set_period(led_period);
+    led_link_set_pattern(LED_PATTERN_OFF);
+    led_link_upload_sequence(SCANNER_SLOT, scanner_program, SCANNER_PROGRAM_FRAMES);
 
     while(1)
     {
+        // the state machine only acts on presses; releases and repeats are drained
+        while (keypad_get_event(&key_event)) {
+            if (key_event.type == KEYPAD_PRESS) {
+                handle_key(key_event.key);
+            }
+        }
 
-        key_val = readKeypad();
-        if (key_val != 'X') {
-            if (state == 0) {
-                if (key_val=='1') {
-                    state = 1;
-                    P1OUT |= BIT0;
-                    memcpy(&message[0], "UNLOCKING       ", 16);
-                    //i2c_send_msg(message);
-
-                } else {
-                    state = 0;
-                    P1OUT &= ~BIT0;
-                    memcpy(&message[0], "LOCKED          ", 16);
-                    //i2c_send_msg(message);
+        // crossing reported by the window comparator
+        if (monitor_changed) {
+            monitor_changed = false;
+            show_monitor_zone();
+        }
 
-                }
+        // format a new average here rather than in the sample ISR
+        if (average_ready) {
+            average_ready = false;
+            show_average();
+            lcd_link_tick();                    // shown averages are the LCD link's time base for resends
+        }
 
-            } else if (state == 1) {
-                if (key_val=='1') {
-                    state = 2;
-                } else {
-                    state = 0;
-                    P1OUT &= ~BIT0;
-                    memcpy(&message[0], "LOCKED          ", 16);
-                    //i2c_send_msg(message);
-                }
-                
-            } else if (state == 2) {
-                if (key_val=='1') {
-                    state = 3;
-                } else {
-                    state = 0;
-                    P1OUT &= ~BIT0;
-                    memcpy(&message[0], "LOCKED          ", 16);
-                    //i2c_send_msg(message);
-                }
+        // send whatever changed in message since the last update (keys or new average)
+        lcd_link_update(message);
 
-            } else if (state == 3) {
-                if (key_val=='1') {
-                    state = 4;
-                    P6OUT |= BIT6;
-                    memcpy(&message[0], "UNLOCKED        ", 16);
-                    //i2c_send_msg(message);
-                } else {
-                    state = 0;
-                    P1OUT &= ~BIT0;
-                    memcpy(&message[0], "LOCKED          ", 16);
-                    //i2c_send_msg(message);
-                }
+        // send LED bar commands from this pass as one frame
+        led_link_flush();
 
-            } else if (state == 4) {
-                if (key_val=='D') {             // lock
-                    state = 0;
-                    P1OUT &= ~BIT0;
-                    memcpy(&message[0], "LOCKED          ", 16);
-                    //i2c_send_msg(message);
-                    P6OUT &= ~BIT6;
-
-                } else if (key_val=='A') {      // enter pattern
-                    memcpy(&message[0], "Set Pattern     ", 16);
-                    //i2c_send_msg(message);
-                    state = 5;
-
-                } else if (key_val=='B') {      // enter window
-                    memcpy(&message[0], "Set Window Size ", 16);
-                    //i2c_send_msg(message);
-                    adc_tens = 0;
-                    temp_adc_buffer_length = 0;
-                    state = 6;
-
-                } else if (key_val=='C') {      // toggle degF/degC
-                    corf_toggle ^= 1;
-                }
+        sleep_until_event();
+    }
+}
 
-            } else if (state == 5) {
-                if (key_val=='D') {             // lock
-                    state = 0;
-                    P1OUT &= ~BIT0;
-                    memcpy(&message[0], "LOCKED          ", 16);
-                    //i2c_send_msg(message);
-                    P6OUT &= ~BIT6;
-                } else if (key_val=='A') {      // decrease base period by 0.25 s
-                    i2c_send_int(10); 
-                } else if (key_val=='B') {      // increase base period by 0.25 s
-                    i2c_send_int(11); 
-                } else if (key_val=='0') {      // pattern 0
-                    memcpy(&cur_pattern[0], "Static          ", 16);
-                    memcpy(&message[0], cur_pattern, 16);
-                    //i2c_send_msg(message);
-                    i2c_send_int(0);
-                } else if (key_val=='1') {      // pattern 1
-                memcpy(&cur_pattern[0], "Toggle          ", 16);
-                    memcpy(&message[0], cur_pattern, 16);
-                    //i2c_send_msg(message);
-                    i2c_send_int(1);
-                } else if (key_val=='2') {      // pattern 2
-                memcpy(&cur_pattern[0], "Toggle          ", 16);
-                    memcpy(&message[0], cur_pattern, 16);
-                    //i2c_send_msg(message);
-                    i2c_send_int(2);
-                } else if (key_val=='3') {      // pattern 3
-                    memcpy(&cur_pattern[0], "In and Out      ", 16);
-                    memcpy(&message[0], cur_pattern, 16);
-                    //i2c_send_msg(message); 
-                    i2c_send_int(3);
-                } else if (key_val=='4') {      // pattern 4
-                    memcpy(&cur_pattern[0], "Down Counter    ", 16);
-                    memcpy(&message[0], cur_pattern, 16);
-                    //i2c_send_msg(message);
-                    i2c_send_int(4);
-                } else if (key_val=='5') {      // pattern 5
-                    memcpy(&cur_pattern[0], "Rotate One Left ", 16);
-                    memcpy(&message[0], cur_pattern, 16);
-                    //i2c_send_msg(message);
-                    i2c_send_int(5);
-                } else if (key_val=='6') {      // pattern 6
-                    memcpy(&cur_pattern[0], "Fill to the Left ", 16);
-                    memcpy(&message[0], cur_pattern, 16);
-                    //i2c_send_msg(message);
-                    i2c_send_int(6);
-                } else if (key_val=='7') {      // pattern 7
-                    memcpy(&cur_pattern[0], "Static          ", 16);
-                    memcpy(&message[0], cur_pattern, 16);
-                    //i2c_send_msg(message);
-                    i2c_send_int(7);
-                } else if (key_val=='*') {      // exit
-                    state = 4;
-                }
+void sleep_until_event() {
+    __disable_interrupt();
+    if (keypad_has_event() || average_ready || monitor_changed) {
+        // something to handle or send: go around again
+        __enable_interrupt();
+    } else if (i2c_master_busy()) {
+        __bis_SR_register(LPM0_bits | GIE);     // I2C runs from SMCLK, which LPM3 stops
+    } else {
+        __bis_SR_register(LPM3_bits | GIE);     // only ACLK (sample and keypad timers) and the keypad edge can wake us
+    }
+}
 
-            } else if (state == 6) {
-                if (key_val=='D') {             // lock
-                    state = 0;
-                    P1OUT &= ~BIT0;
-                    memcpy(&message[0], "LOCKED          ", 16);
-                    //i2c_send_msg(message);
-                    P6OUT &= ~BIT6;
-                    
-                } else if ((key_val >= '0') & (key_val <= '9')) {
-                    temp_adc_buffer_length = temp_adc_buffer_length*pow(10, adc_tens)+(key_val-'0');
-                
-                } else if (key_val=='*') {      // exit
-
-                    if ((temp_adc_buffer_length > 0) & (temp_adc_buffer_length < 101)) {    // update length of rolling average
-                        adc_buffer_length = temp_adc_buffer_length;
-                    } else {
-                        adc_buffer_length = 3;
-                    }
-                    memset(adc_sensor_array, 0, sizeof(adc_sensor_array));                  // clear collected values used for average
-                    adc_sensor_avg = 0;                                                     // clear average
-                    adc_filled = 0;                                                         // reset counter for values used in average
-                    sprintf(adc_buffer_length_string, "%03d", adc_buffer_length);           // format zero-padded to 3 digits, e.g., "007"
-                    memcpy(&message[28], adc_buffer_length_string, 3);                      // update message
-                    memcpy(&message[0], cur_pattern, 16);                                   // display current pattern
-                    //i2c_send_msg(message);                                                  // send message
-                    state = 4;
-                }
+// --------------------------------------------- STATE ACTIONS ---------------------------------------------
+static bool action_none(char key) {
+    (void)key;
+    return true;
+}
 
-            } else {
-                state = 0;
-                P1OUT &= ~BIT0;
-                P6OUT &= ~BIT6;
-            }
-        }
-    }
+static bool action_lock(char key) {
+    (void)key;
+    P1OUT &= ~BIT0;
+    P6OUT &= ~BIT6;
+    memcpy(&message[0], "LOCKED          ", 16);
+    return true;
 }
 
-// --------------------------------------------- KEYPAD ---------------------------------------------
-void setupKeypad() {
-    // columns as outputs on P1.4, P5.3, P5.1, P5.0 initialized to 0
-    //P1DIR |= BIT4;
-    //P5DIR |= BIT3;
-    //P5DIR |= BIT1;
-    //P5DIR |= BIT0;
-    //P1OUT &= ~BIT4;      
-    //P5OUT &= ~BIT3;
-    //P5OUT &= ~BIT1;
-    //P5OUT &= ~BIT0;
-    
-    // columns as outputs on P1.4, P1.5, P1.6, P1.7 initialized to 0
-    P1DIR |= BIT4;
-    P1DIR |= BIT5;
-    P1DIR |= BIT6;
-    P1DIR |= BIT7;
-    P1OUT &= ~BIT4;
-    P1OUT &= ~BIT5;  
-    P1OUT &= ~BIT6;  
-    P1OUT &= ~BIT7;        
-   
-    // rows as inputs pulled down internally on P5.4, P1.1, P3.5, 3.1
-    //P5DIR &= ~BIT4;     // inputs
-    //P1DIR &= ~BIT1;
-    //P3DIR &= ~BIT5;
-    //P3DIR &= ~BIT1;
-    //P5REN |= BIT4;      // internal resistors
-    //P1REN |= BIT1;
-    //P3REN |= BIT5;
-    //P3REN |= BIT1;
-	//P5OUT &=~ BIT4;     // pull-downs
-	//P1OUT &=~ BIT1;
-	//P3OUT &=~ BIT5;
-	//P3OUT &=~ BIT1;
-
-    // rows as inputs pulled down internally on P2.0, P2.1, P2.2, P2.3
-    P2DIR &= ~BIT0;     // inputs
-    P2DIR &= ~BIT1;
-    P2DIR &= ~BIT2;
-    P2DIR &= ~BIT3;
-    P2REN |= BIT0;      // internal resistors
-    P2REN |= BIT1;
-    P2REN |= BIT2;
-    P2REN |= BIT3;
-	P2OUT &=~ BIT0;     // pull-downs
-	P2OUT &=~ BIT1;
-	P2OUT &=~ BIT2;
-	P2OUT &=~ BIT3;
+static bool action_unlocking(char key) {
+    (void)key;
+    P1OUT |= BIT0;
+    memcpy(&message[0], "UNLOCKING       ", 16);
+    return true;
+}
+
+static bool action_unlocked(char key) {
+    (void)key;
+    P6OUT |= BIT6;
+    memcpy(&message[0], "UNLOCKED        ", 16);
+    return true;
 }
 
-char readKeypad() {
-    // columns on P1.4, P5.3, P5.1, P5.0
-    // rows on P5.4, P1.1, P3.5, 3.1
-
-    char keys[4][4] = {
-        {'1', '2', '3', 'A'},
-        {'4', '5', '6', 'B'},
-        {'7', '8', '9', 'C'},
-        {'*', '0', '#', 'D'}
-    };
-
-    char pressed = 'X';
-
-    // check row 1
-    P1OUT |= BIT4;
-    int col = checkCols();
-    if (col!=-1) {
-        pressed = keys[0][col];
-    } 
-    P1OUT &= ~BIT4;
-
-    // check row 2
-    P1OUT |= BIT5;
-    col = checkCols();
-    if (col!=-1) {
-        pressed =  keys[1][col];
-    } 
-    P1OUT &= ~BIT5;
-
-    // check row 3
-    P1OUT |= BIT6;
-    col = checkCols();
-    if (col!=-1) {
-        pressed =  keys[2][col];
+static bool action_enter_pattern(char key) {
+    (void)key;
+    memcpy(&message[0], "Set Pattern     ", 16);
+    return true;
+}
+
+static bool action_enter_window(char key) {
+    (void)key;
+    memcpy(&message[0], "Set Window Size ", 16);
+    temp_adc_buffer_length = 0;
+    return true;
+}
+
+static bool action_toggle_units(char key) {     // toggle degF/degC
+    (void)key;
+    corf_toggle ^= 1;
+    return true;
+}
+
+static bool action_period_dec(char key) {       // make the LED bar faster by one step
+    (void)key;
+    if (led_period > LED_PERIOD_KEY_MIN) {
+        led_period -= LED_PERIOD_STEP;
+        led_link_set_period(led_period);
     }
-    P1OUT &= ~BIT6;
+    return true;
+}
 
-    // check row 4
-    P1OUT |= BIT7;
-    col = checkCols();
-    if (col!=-1) {
-        pressed =  keys[3][col];
+static bool action_period_inc(char key) {       // make the LED bar slower by one step
+    (void)key;
+    if (led_period < LED_PERIOD_KEY_MAX) {
+        led_period += LED_PERIOD_STEP;
+        led_link_set_period(led_period);
     }
-    P1OUT &= ~BIT7;
+    return true;
+}
 
-    if (pressed != lastKey) {
-        lastKey = pressed;
-        return pressed;
-    } else {
-        return 'X';
+static bool action_select_pattern(char key) {   // keys '0'-'8' select patterns 0-8, '9' the scanner program
+    memcpy(&cur_pattern[0], pattern_names[key - '0'], 16);
+    memcpy(&message[0], cur_pattern, 16);
+    cur_pattern_id = (key == '9') ? SCANNER_PATTERN : key - '0';
+    if ((cur_pattern_id == SCANNER_PATTERN) && led_link_upload_failed()) {    // the LED bar never got it: try again
+        led_link_upload_sequence(SCANNER_SLOT, scanner_program, SCANNER_PROGRAM_FRAMES);
+        memcpy(&message[0], "Upload Retrying ", 16);
     }
+    if (!(monitoring && (monitor_zone != ADC_WINDOW_INSIDE))) {  // an active alert keeps the bar until it clears
+        show_pattern(cur_pattern_id);
+    }
+    return true;
 }
 
-int checkCols() {
-    // check inputs for rows on P5.4, P1.1, P3.5, 3.1 (rows 1-4)
-    if (P2IN & BIT0) {
-        return 0;
-    } else if (P2IN & BIT1) {
-        return 1;
-    } else if (P2IN & BIT2) {
-        return 2;
-    } else if (P2IN & BIT3) {
-        return 3;
+void show_pattern(unsigned char id) {
+    if (id == SCANNER_PATTERN) {
+        led_link_run_program(SCANNER_SLOT);
     } else {
-        return -1;
+        led_link_set_pattern(id);
     }
 }
 
-//---------------------------------------------ADC---------------------------------------------
-void setupADC() {
-    // Configure ADC A10 pin on P5.2
-    P5SEL0 |= BIT2;
-    P5SEL1 |= BIT2;
-
-    // Configure ADC12
-    ADCCTL0 |= ADCSHT_2 | ADCON;                             // ADCON, S&H=16 ADC clks
-    ADCCTL1 |= ADCSHP;                                       // ADCCLK = MODOSC; sampling timer
-    ADCCTL2 &= ~ADCRES;                                      // clear ADCRES in ADCCTL
-    ADCCTL2 |= ADCRES_2;                                     // 12-bit conversion results
-    ADCMCTL0 |= ADCINCH_10;                                   // A10 ADC input select; Vref=AVCC
-    ADCIE |= ADCIE0;                                         // Enable ADC conv complete interrupt
+static bool action_window_digit(char key) {
+    if (temp_adc_buffer_length < 1000) {        // anything past 3 digits is invalid anyway
+        temp_adc_buffer_length = temp_adc_buffer_length * 10 + (key - '0');
+    }
+    return true;
 }
 
-void readADC() {
-    // start sampling and conversion
-    ADCCTL0 |= ADCENC | ADCSC;
+static bool action_window_commit(char key) {
+    (void)key;
+    if ((temp_adc_buffer_length > 0) & (temp_adc_buffer_length < 101)) {    // update length of rolling average
+        adc_buffer_length = temp_adc_buffer_length;
+    } else {
+        adc_buffer_length = 3;
+    }
+    __disable_interrupt();                                                  // sample ISR also touches the filter
+    filter_select(filter_kind, adc_buffer_length);                          // clear collected values used for average
+    adc_sensor_avg = 0;                                                     // clear average
+    average_ready = false;                                                  // drop an average from the old window
+    __enable_interrupt();
+    fmt_uint(&message[MSG_WINDOW], adc_buffer_length, MSG_WINDOW_WIDTH);    // zero-padded to 3 digits, e.g., "007"
+    memcpy(&message[0], cur_pattern, 16);                                   // display current pattern
+    return true;
 }
 
-#pragma vector=ADC_VECTOR
-__interrupt void ADC_ISR(void)
-{
-    switch(ADCIV)
-    {
-        case ADCIV_ADCIFG:
-            adc_val = ADCMEM0;
-            break;
-        default:
-            break;
+static bool action_enter_limits(char key) {
+    (void)key;
+    memcpy(&message[0], "Set Low Limit   ", 16);
+    temp_limit = 0;
+    return true;
+}
+
+static bool action_limit_digit(char key) {
+    if (temp_limit < 1000) {                    // anything past 3 digits is invalid anyway
+        temp_limit = temp_limit * 10 + (key - '0');
     }
+    return true;
 }
 
-//--------------------------------------------------I2C------------------------------------------------
-// Master Setup
-void i2c_master_setup(){
-    UCB0CTLW0 |= UCSWRST;   // Hold USCI in reset
+static long limit_to_centi_c(unsigned int limit) {  // whole degrees in the current units; long: int is 16 bits
+    if (corf_toggle == 0) {
+        return (long)limit * 100;
+    }
+    return ((long)limit - 32) * 500 / 9;
+}
 
-    //-- Setup I2C Pins
-    P1SEL1 &= ~(BIT2 | BIT3);   
-    P1SEL0 |=  (BIT2 | BIT3);             
+static bool action_low_limit_commit(char key) {  // fails on a limit past the LM19's range; the table then returns to UNLOCKED
+    (void)key;
+    long centi = limit_to_centi_c(temp_limit);
 
-    //-- Configure I2C
-    UCB0CTLW0 = UCSWRST | UCSSEL_3 | UCMODE_3 | UCMST | UCTR | UCSYNC; // SMCLK, I2C master, Tx mode
-    UCB0BRW = 10;                   // SCL = SMCLK / 10 = 100kHz
+    if (centi > LIMIT_MAX_CENTI_C) {
+        memcpy(&message[0], "Limit Rejected  ", 16);
+        return false;
+    }
+    low_limit_centi = (int)centi;
+    memcpy(&message[0], "Set High Limit  ", 16);
+    temp_limit = 0;
+    return true;
+}
 
-    UCB0CTLW1 = UCASTP_2;           // Auto STOP after TBCNT bytes
+static bool action_high_limit_commit(char key) {
+    (void)key;
+    long high_limit_centi = limit_to_centi_c(temp_limit);
 
-    PM5CTL0 &= ~LOCKLPM5;           // Enable GPIOs
+    if ((high_limit_centi > LIMIT_MAX_CENTI_C) || (high_limit_centi <= low_limit_centi)) {  // keep the current mode
+        memcpy(&message[0], "Limit Rejected  ", 16);
+        return false;
+    }
 
-    UCB0CTLW0 &= ~UCSWRST;          // Release from reset
+    if (monitoring && (monitor_zone != ADC_WINDOW_INSIDE)) {
+        show_pattern(cur_pattern_id);                                               // clear a standing alert; re-arming starts in band
+    }
 
-    __delay_cycles(10000);          // Setup settle delay
+    // the LM19 output falls as temperature rises: the high limit is the low ADC threshold
+    __disable_interrupt();
+    monitoring = true;
+    monitor_zone = ADC_WINDOW_INSIDE;
+    monitor_changed = false;
+    average_ready = false;
+    adc_sampler_monitor(lm19_code_at_centi_c((int16_t)high_limit_centi), lm19_code_at_centi_c(low_limit_centi));
+    __enable_interrupt();
+    memcpy(&message[0], "Monitoring      ", 16);
+    return true;
 }
 
-// Integer send function (for led bar)
-void i2c_send_int(unsigned char data) {
-    while (UCB0CTLW0 & UCTXSTP);         // Wait for STOP if in progress
-    UCB0I2CSA = 0x45;                    // Set slave address
-    UCB0TBCNT = 1;                       // Number of bytes to send
-
-    UCB0CTLW0 |= UCTXSTT;                // Generate START
-    while (UCB0CTLW0 & UCTXSTT);         // Wait for START to complete
-
-    while (!(UCB0IFG & UCTXIFG0));       // Wait for TX buffer ready
-    UCB0TXBUF = data;                    // Send data
-
-    while (!(UCB0IFG & UCBCNTIFG));      // Wait for byte counter
-    UCB0CTLW0 |= UCTXSTP;                // Send STOP
-    while (UCB0CTLW0 & UCTXSTP);         // Wait for STOP to finish
+static bool action_monitor_off(char key) {
+    (void)key;
+    if (!monitoring) {
+        return true;
+    }
+    __disable_interrupt();
+    monitoring = false;
+    monitor_changed = false;
+    filter_select(filter_kind, adc_buffer_length);                          // samples from before monitoring are stale
+    adc_sampler_stream();
+    __enable_interrupt();
+    if (monitor_zone != ADC_WINDOW_INSIDE) {
+        show_pattern(cur_pattern_id);                                               // clear a standing alert
+    }
+    memcpy(&message[0], cur_pattern, 16);
+    return true;
 }
 
-// Messqage send function (for lcd) sends 33 bytes only
-void i2c_send_msg(char *msg) {
-    while (UCB0CTLW0 & UCTXSTP);         // Wait for STOP if needed
-    UCB0I2CSA = 0x40;                    // Set LCD slave address
-    UCB0TBCNT = 32;                      // Send 33 bytes
+static bool action_enter_filter(char key) {
+    (void)key;
+    memcpy(&message[0], "Filter 1-4?     ", 16);
+    return true;
+}
 
-    UCB0CTLW0 |= UCTXSTT;                // Generate START
-    while (UCB0CTLW0 & UCTXSTT);         // Wait for START to complete
+static bool action_select_filter(char key) {    // keys '1'-'4' select enum filter_kind 0-3
+    filter_kind = key - '1';
+    __disable_interrupt();
+    filter_select(filter_kind, adc_buffer_length);
+    average_ready = false;
+    __enable_interrupt();
+    memcpy(&message[0], filter_names[filter_kind], 16);
+    return true;
+}
 
-    int i;
-    for (i = 0; i < 32; i++) {
-        while (!(UCB0IFG & UCTXIFG0));   // Wait for TX buffer ready
-        UCB0TXBUF = msg[i];              // Send byte
+// Indexed by enum ui_action; an action returns false to send the state machine to the entry's reject state
+static bool (*const actions[ACTION_COUNT])(char key) = {
+    [ACTION_NONE] = action_none,
+    [ACTION_LOCK] = action_lock,
+    [ACTION_UNLOCKING] = action_unlocking,
+    [ACTION_UNLOCKED] = action_unlocked,
+    [ACTION_ENTER_PATTERN] = action_enter_pattern,
+    [ACTION_ENTER_WINDOW] = action_enter_window,
+    [ACTION_TOGGLE_UNITS] = action_toggle_units,
+    [ACTION_PERIOD_DEC] = action_period_dec,
+    [ACTION_PERIOD_INC] = action_period_inc,
+    [ACTION_SELECT_PATTERN] = action_select_pattern,
+    [ACTION_WINDOW_DIGIT] = action_window_digit,
+    [ACTION_WINDOW_COMMIT] = action_window_commit,
+    [ACTION_ENTER_LIMITS] = action_enter_limits,
+    [ACTION_LIMIT_DIGIT] = action_limit_digit,
+    [ACTION_LOW_LIMIT_COMMIT] = action_low_limit_commit,
+    [ACTION_HIGH_LIMIT_COMMIT] = action_high_limit_commit,
+    [ACTION_MONITOR_OFF] = action_monitor_off,
+    [ACTION_ENTER_FILTER] = action_enter_filter,
+    [ACTION_SELECT_FILTER] = action_select_filter,
+};
+
+void handle_key(char key) {
+    struct transition t = state_table_lookup(state, key);
+    state = t.next_state;
+    if (!actions[t.action](key)) {              // the action refused the input
+        state = t.reject_state;
     }
-
-    while (!(UCB0IFG & UCBCNTIFG));      // Wait for byte count complete
-    while (UCB0CTLW0 & UCTXSTP);         // Wait for STOP to complete
 }
 
+//---------------------------------------------ADC---------------------------------------------
+static inline unsigned int samples_per_display(void) {  // from the current rate, so a rate change keeps DISPLAY_HZ
+    uint16_t rate = adc_sampler_rate();
+    return (rate > DISPLAY_HZ) ? rate / DISPLAY_HZ : 1;
+}
 
-//---------------------------------------------Sample Clock---------------------------------------------
-void setupSampleClock() {
-    TB3CTL |= TBCLR;    // reset settings
-    TB3CTL |= TBSSEL__ACLK | MC__UP | ID__8;    // 32.768 kHz / 8 = 4096 / 2 - 1 = 2047
-    TB3CCR0 = 2047;                             // period of .5s
-    TB3CCTL0 |= CCIE;                           // Enable capture compare
-    TB3CCTL0 &= ~CCIFG;                         // Clear IFG
-
-    // start ADC read for first sample
-    readADC();                                  
+// Crossing in monitor mode: re-arm the comparator and hand the conversion that crossed to the main loop
+static inline void monitor_entered(uint8_t zone) {
+    adc_sampler_window_enter(zone);
+    monitor_zone = zone;
+    monitor_changed = true;
+    adc_sensor_avg = ADCMEM0 << (ADC_SAMPLER_OUTPUT_BITS - 12);
+    average_ready = true;
 }
 
-#pragma vector = TIMER3_B0_VECTOR
-__interrupt void ISR_TB0_CCR0(void)
+#pragma vector=ADC_VECTOR
+__interrupt void ADC_ISR(void)
 {
-    // update array       
-    int popped = adc_sensor_array[adc_buffer_length-1];
-    int i;
-    for (i=adc_buffer_length-1; i>0; i--) {
-        adc_sensor_array[i] = adc_sensor_array[i-1];
-    }
-    adc_sensor_array[0] = adc_val;
+    static unsigned int samples_since_display = 0;
+    uint16_t sample;
 
-    // update average with cool move
-    adc_sensor_avg += (adc_val-popped)/adc_buffer_length;
+    switch(ADCIV)
+    {
+        case ADCIV_ADCIFG:
+            // oversample; only decimated samples reach the window
+            if (!adc_sampler_decimate(ADCMEM0, &sample)) {
+                break;
+            }
 
-    // keep track of how many values have been read for average
-    if (adc_filled < adc_buffer_length) {
-        adc_filled++;
-    } else {
-        if (corf_toggle == 0) {
-            average = adc2c(adc_sensor_avg);
-            sprintf(adc_sensor_avg_string, "%2d.%1d", adc_sensor_avg / 10, adc_sensor_avg % 10); //Adds decimal and prints to string
-            memcpy(&message[18], adc_sensor_avg_string, 4);
-            ////i2c_send_msg(message);
-        } else {
-            average = adc2f(adc_sensor_avg);
-            sprintf(adc_sensor_avg_string, "%2d.%1d", adc_sensor_avg / 10, adc_sensor_avg % 10); //Adds decimal and prints to string
-            memcpy(&message[18], adc_sensor_avg_string, 4);
-            ////i2c_send_msg(message);
-        }
+            // smooth with the selected filter
+            filter_push(sample);
+
+            // only display once the filter has filled, at DISPLAY_HZ; the main loop does the formatting
+            if (++samples_since_display >= samples_per_display()) {
+                samples_since_display = 0;
+                if (filter_ready()) {
+                    adc_sensor_avg = filter_output();
+                    average_ready = true;
+                    __bic_SR_register_on_exit(LPM3_bits);
+                }
+            }
+            break;
+        case ADCIV_ADCHIIFG:                    // code above the high threshold: colder than the low limit
+            monitor_entered(ADC_WINDOW_ABOVE);
+            __bic_SR_register_on_exit(LPM3_bits);
+            break;
+        case ADCIV_ADCLOIFG:                    // code below the low threshold: hotter than the high limit
+            monitor_entered(ADC_WINDOW_BELOW);
+            __bic_SR_register_on_exit(LPM3_bits);
+            break;
+        case ADCIV_ADCINIFG:                    // back in band
+            monitor_entered(ADC_WINDOW_INSIDE);
+            __bic_SR_register_on_exit(LPM3_bits);
+            break;
+        default:
+            break;
     }
+}
 
-    // read value
-    readADC();
+void show_monitor_zone() {
+    const char *status;
 
-    // clear CCR0 IFG
-    TB3CCTL0 &= ~CCIFG;
-}
+    if (monitor_zone == ADC_WINDOW_BELOW) {
+        status = "HIGH TEMP ALERT ";
+        led_link_set_pattern(ALERT_PATTERN);
+    } else if (monitor_zone == ADC_WINDOW_ABOVE) {
+        status = "LOW TEMP ALERT  ";
+        led_link_set_pattern(ALERT_PATTERN);
+    } else {
+        status = "Monitoring      ";
+        show_pattern(cur_pattern_id);
+    }
 
-//---------------------------------------------ADC CONVERSIONS---------------------------------------------
-float adc2c(unsigned int code) {
-    // 12-bit adc conversion with 3.3V reference
-    float voltage = ((float) code) * ADC_SCALER;
-    // Vo to C conversion from LM19 datasheet
-    float celcius = -1481.96 + sqrt(2.1962e6 + (1.8639 - voltage) / (3.88e-6));
-    return celcius;
+    if (state == STATE_UNLOCKED) {              // don't cover LOCKED or an input prompt
+        memcpy(&message[0], status, 16);
+    }
 }
 
-float adc2f(unsigned int code) {
-    float fahrenheit = 1.8*adc2c(code)+32.0;
-    return fahrenheit;
+void show_average() {
+    if (corf_toggle == 0) {
+        average = lm19_deci_c(adc_sensor_avg);
+        message[MSG_UNIT] = 'C';
+    } else {
+        average = lm19_deci_f(adc_sensor_avg);
+        message[MSG_UNIT] = 'F';
+    }
+    fmt_fixed1(&message[MSG_TEMP], average, MSG_TEMP_WIDTH);
 }
-
@@ -0,0 +1,57 @@
+/**
+ * @file
+ * @brief Constant-time moving average over a ring buffer of ADC samples.
+ */
+#include "rolling_avg.h"
+
+bool rolling_avg_init(struct rolling_avg *avg, uint8_t size)
+{
+    if ((size == 0) || (size > ROLLING_AVG_MAX_WINDOW))
+    {
+        return false;
+    }
+
+    avg->sum = 0;
+    avg->head = 0;
+    avg->count = 0;
+    avg->size = size;
+    return true;
+}
+
+void rolling_avg_push(struct rolling_avg *avg, uint16_t sample)
+{
+    // Once full, the slot at head holds the oldest sample, which drops out of the sum
+    if (avg->count < avg->size)
+    {
+        avg->count++;
+    }
+    else
+    {
+        avg->sum -= avg->samples[avg->head];
+    }
+
+    avg->samples[avg->head] = sample;
+    avg->sum += sample;
+
+    // Wrap by compare; there is no hardware divider for a modulo
+    avg->head++;
+    if (avg->head >= avg->size)
+    {
+        avg->head = 0;
+    }
+}
+
+bool rolling_avg_full(const struct rolling_avg *avg)
+{
+    return avg->count >= avg->size;
+}
+
+uint16_t rolling_avg_mean(const struct rolling_avg *avg)
+{
+    if (avg->count == 0)
+    {
+        return 0;
+    }
+
+    return (uint16_t)((avg->sum + (avg->count / 2)) / avg->count);
+}
@@ -0,0 +1,78 @@
+/**
+ * @file
+ * @brief Constant-time moving average over a ring buffer of ADC samples.
+ *
+ * The window keeps an exact running sum, so pushing a sample costs the same
+ * regardless of the window size. Window sizes from 1 to ROLLING_AVG_MAX_WINDOW
+ * can be selected at runtime by re-initialising the window.
+ */
+#ifndef ROLLING_AVG_H
+#define ROLLING_AVG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Largest window size supported by the averaging engine */
+#define ROLLING_AVG_MAX_WINDOW 100
+
+/**
+ * Moving average window state
+ */
+struct rolling_avg
+{
+    /** Samples currently in the window, oldest at head */
+    uint16_t samples[ROLLING_AVG_MAX_WINDOW];
+
+    /** Exact sum of the samples currently in the window */
+    uint32_t sum;
+
+    /** Index of the oldest sample, i.e., the next slot to overwrite */
+    uint8_t head;
+
+    /** Number of valid samples, saturates at size */
+    uint8_t count;
+
+    /** Number of samples used in the average: [1, ROLLING_AVG_MAX_WINDOW] */
+    uint8_t size;
+};
+
+/**
+ * Reset a window and set its size.
+ *
+ * Sizes outside of [1, ROLLING_AVG_MAX_WINDOW] are rejected and leave the
+ * window untouched.
+ *
+ * @param: avg Window to reset.
+ * @param: size Number of samples to average over.
+ *
+ * @return: true if the size was accepted.
+ */
+bool rolling_avg_init(struct rolling_avg *avg, uint8_t size);
+
+/**
+ * Add a sample to the window, evicting the oldest one once the window is full.
+ *
+ * @param: avg Window to update.
+ * @param: sample New sample.
+ */
+void rolling_avg_push(struct rolling_avg *avg, uint16_t sample);
+
+/**
+ * Check whether the window holds size samples, i.e., the average is valid.
+ *
+ * @param: avg Window to check.
+ *
+ * @return: true once size samples have been pushed since the last reset.
+ */
+bool rolling_avg_full(const struct rolling_avg *avg);
+
+/**
+ * Average of the samples in the window, rounded to the nearest integer.
+ *
+ * @param: avg Window to average.
+ *
+ * @return: The average, or 0 if the window is empty.
+ */
+uint16_t rolling_avg_mean(const struct rolling_avg *avg);
+
+#endif // ROLLING_AVG_H
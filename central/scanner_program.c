@@ -0,0 +1,19 @@
+/**
+ * @file
+ * @brief LED bar animation program assembled from animations/scanner.led.
+ *
+ * Generated by tools/led_asm.py; do not edit.
+ */
+#include "scanner_program.h"
+
+const uint8_t scanner_program[SCANNER_PROGRAM_FRAMES * 2] = {
+    0x00, 0x03,
+    0x06, 0x06,
+    0x05, 0x01,
+    0x01, 0x01,
+    0x07, 0x02,
+    0x06, 0x06,
+    0x05, 0x01,
+    0x02, 0x01,
+    0x07, 0x06,
+};
@@ -0,0 +1,18 @@
+/**
+ * @file
+ * @brief LED bar animation program assembled from animations/scanner.led.
+ *
+ * Generated by tools/led_asm.py; do not edit.
+ */
+#ifndef SCANNER_PROGRAM_H
+#define SCANNER_PROGRAM_H
+
+#include <stdint.h>
+
+/** Number of instructions, the frame count for led_link_upload_sequence */
+#define SCANNER_PROGRAM_FRAMES 9
+
+/** [opcode][argument] pairs */
+extern const uint8_t scanner_program[SCANNER_PROGRAM_FRAMES * 2];
+
+#endif // SCANNER_PROGRAM_H
@@ -0,0 +1,146 @@
+/**
+ * @file
+ * @brief Keypad-driven controller state machine as a constant transition table.
+ */
+#include "state_table.h"
+
+#define KEY_COUNT 16
+
+// Keypad characters '#' (0x23) to 'D' (0x44) map to a table column + 1; 0 is not a key
+#define KEY_MAP_FIRST '#'
+#define KEY_MAP_LAST 'D'
+#define KEY(column) ((column) + 1)
+
+// Table columns, in keypad order
+enum
+{
+    K1, K2, K3, KA,
+    K4, K5, K6, KB,
+    K7, K8, K9, KC,
+    KSTAR, K0, KHASH, KD
+};
+
+static const uint8_t key_map[KEY_MAP_LAST - KEY_MAP_FIRST + 1] = {
+    ['#' - KEY_MAP_FIRST] = KEY(KHASH),
+    ['*' - KEY_MAP_FIRST] = KEY(KSTAR),
+    ['0' - KEY_MAP_FIRST] = KEY(K0),
+    ['1' - KEY_MAP_FIRST] = KEY(K1),
+    ['2' - KEY_MAP_FIRST] = KEY(K2),
+    ['3' - KEY_MAP_FIRST] = KEY(K3),
+    ['4' - KEY_MAP_FIRST] = KEY(K4),
+    ['5' - KEY_MAP_FIRST] = KEY(K5),
+    ['6' - KEY_MAP_FIRST] = KEY(K6),
+    ['7' - KEY_MAP_FIRST] = KEY(K7),
+    ['8' - KEY_MAP_FIRST] = KEY(K8),
+    ['9' - KEY_MAP_FIRST] = KEY(K9),
+    ['A' - KEY_MAP_FIRST] = KEY(KA),
+    ['B' - KEY_MAP_FIRST] = KEY(KB),
+    ['C' - KEY_MAP_FIRST] = KEY(KC),
+    ['D' - KEY_MAP_FIRST] = KEY(KD),
+};
+
+#define T(next, action) { STATE_##next, ACTION_##action, STATE_##next }
+#define T_OR(next, action, reject) { STATE_##next, ACTION_##action, STATE_##reject }
+#define LOCK T(LOCKED, LOCK)
+
+// Rows are states, columns are keys in keypad order:
+//   1      2      3      A      4      5      6      B      7      8      9      C      *      0      #      D
+static const struct transition table[STATE_COUNT][KEY_COUNT] = {
+    [STATE_LOCKED] = {
+        T(UNLOCK_1, UNLOCKING), LOCK, LOCK, LOCK, LOCK, LOCK, LOCK, LOCK,
+        LOCK, LOCK, LOCK, LOCK, LOCK, LOCK, LOCK, LOCK,
+    },
+    [STATE_UNLOCK_1] = {
+        T(UNLOCK_2, NONE), LOCK, LOCK, LOCK, LOCK, LOCK, LOCK, LOCK,
+        LOCK, LOCK, LOCK, LOCK, LOCK, LOCK, LOCK, LOCK,
+    },
+    [STATE_UNLOCK_2] = {
+        T(UNLOCK_3, NONE), LOCK, LOCK, LOCK, LOCK, LOCK, LOCK, LOCK,
+        LOCK, LOCK, LOCK, LOCK, LOCK, LOCK, LOCK, LOCK,
+    },
+    [STATE_UNLOCK_3] = {
+        T(UNLOCKED, UNLOCKED), LOCK, LOCK, LOCK, LOCK, LOCK, LOCK, LOCK,
+        LOCK, LOCK, LOCK, LOCK, LOCK, LOCK, LOCK, LOCK,
+    },
+    [STATE_UNLOCKED] = {
+        [K1] = T(UNLOCKED, NONE), [K2] = T(UNLOCKED, NONE), [K3] = T(UNLOCKED, NONE),
+        [KA] = T(PATTERN_ENTRY, ENTER_PATTERN),
+        [K4] = T(UNLOCKED, NONE), [K5] = T(UNLOCKED, NONE), [K6] = T(UNLOCKED, NONE),
+        [KB] = T(WINDOW_ENTRY, ENTER_WINDOW),
+        [K7] = T(UNLOCKED, NONE), [K8] = T(UNLOCKED, NONE), [K9] = T(UNLOCKED, NONE),
+        [KC] = T(UNLOCKED, TOGGLE_UNITS),
+        [KSTAR] = T(UNLOCKED, MONITOR_OFF), [K0] = T(FILTER_ENTRY, ENTER_FILTER),
+        [KHASH] = T(LOW_LIMIT_ENTRY, ENTER_LIMITS), [KD] = LOCK,
+    },
+    [STATE_PATTERN_ENTRY] = {
+        [K1] = T(PATTERN_ENTRY, SELECT_PATTERN), [K2] = T(PATTERN_ENTRY, SELECT_PATTERN),
+        [K3] = T(PATTERN_ENTRY, SELECT_PATTERN), [KA] = T(PATTERN_ENTRY, PERIOD_DEC),
+        [K4] = T(PATTERN_ENTRY, SELECT_PATTERN), [K5] = T(PATTERN_ENTRY, SELECT_PATTERN),
+        [K6] = T(PATTERN_ENTRY, SELECT_PATTERN), [KB] = T(PATTERN_ENTRY, PERIOD_INC),
+        [K7] = T(PATTERN_ENTRY, SELECT_PATTERN), [K8] = T(PATTERN_ENTRY, SELECT_PATTERN),
+        [K9] = T(PATTERN_ENTRY, SELECT_PATTERN), [KC] = T(PATTERN_ENTRY, NONE),
+        [KSTAR] = T(UNLOCKED, NONE), [K0] = T(PATTERN_ENTRY, SELECT_PATTERN),
+        [KHASH] = T(PATTERN_ENTRY, NONE), [KD] = LOCK,
+    },
+    [STATE_WINDOW_ENTRY] = {
+        [K1] = T(WINDOW_ENTRY, WINDOW_DIGIT), [K2] = T(WINDOW_ENTRY, WINDOW_DIGIT),
+        [K3] = T(WINDOW_ENTRY, WINDOW_DIGIT), [KA] = T(WINDOW_ENTRY, NONE),
+        [K4] = T(WINDOW_ENTRY, WINDOW_DIGIT), [K5] = T(WINDOW_ENTRY, WINDOW_DIGIT),
+        [K6] = T(WINDOW_ENTRY, WINDOW_DIGIT), [KB] = T(WINDOW_ENTRY, NONE),
+        [K7] = T(WINDOW_ENTRY, WINDOW_DIGIT), [K8] = T(WINDOW_ENTRY, WINDOW_DIGIT),
+        [K9] = T(WINDOW_ENTRY, WINDOW_DIGIT), [KC] = T(WINDOW_ENTRY, NONE),
+        [KSTAR] = T(UNLOCKED, WINDOW_COMMIT), [K0] = T(WINDOW_ENTRY, WINDOW_DIGIT),
+        [KHASH] = T(WINDOW_ENTRY, NONE), [KD] = LOCK,
+    },
+    [STATE_LOW_LIMIT_ENTRY] = {
+        [K1] = T(LOW_LIMIT_ENTRY, LIMIT_DIGIT), [K2] = T(LOW_LIMIT_ENTRY, LIMIT_DIGIT),
+        [K3] = T(LOW_LIMIT_ENTRY, LIMIT_DIGIT), [KA] = T(LOW_LIMIT_ENTRY, NONE),
+        [K4] = T(LOW_LIMIT_ENTRY, LIMIT_DIGIT), [K5] = T(LOW_LIMIT_ENTRY, LIMIT_DIGIT),
+        [K6] = T(LOW_LIMIT_ENTRY, LIMIT_DIGIT), [KB] = T(LOW_LIMIT_ENTRY, NONE),
+        [K7] = T(LOW_LIMIT_ENTRY, LIMIT_DIGIT), [K8] = T(LOW_LIMIT_ENTRY, LIMIT_DIGIT),
+        [K9] = T(LOW_LIMIT_ENTRY, LIMIT_DIGIT), [KC] = T(LOW_LIMIT_ENTRY, NONE),
+        [KSTAR] = T_OR(HIGH_LIMIT_ENTRY, LOW_LIMIT_COMMIT, UNLOCKED), [K0] = T(LOW_LIMIT_ENTRY, LIMIT_DIGIT),
+        [KHASH] = T(LOW_LIMIT_ENTRY, NONE), [KD] = LOCK,
+    },
+    [STATE_HIGH_LIMIT_ENTRY] = {
+        [K1] = T(HIGH_LIMIT_ENTRY, LIMIT_DIGIT), [K2] = T(HIGH_LIMIT_ENTRY, LIMIT_DIGIT),
+        [K3] = T(HIGH_LIMIT_ENTRY, LIMIT_DIGIT), [KA] = T(HIGH_LIMIT_ENTRY, NONE),
+        [K4] = T(HIGH_LIMIT_ENTRY, LIMIT_DIGIT), [K5] = T(HIGH_LIMIT_ENTRY, LIMIT_DIGIT),
+        [K6] = T(HIGH_LIMIT_ENTRY, LIMIT_DIGIT), [KB] = T(HIGH_LIMIT_ENTRY, NONE),
+        [K7] = T(HIGH_LIMIT_ENTRY, LIMIT_DIGIT), [K8] = T(HIGH_LIMIT_ENTRY, LIMIT_DIGIT),
+        [K9] = T(HIGH_LIMIT_ENTRY, LIMIT_DIGIT), [KC] = T(HIGH_LIMIT_ENTRY, NONE),
+        [KSTAR] = T_OR(UNLOCKED, HIGH_LIMIT_COMMIT, UNLOCKED), [K0] = T(HIGH_LIMIT_ENTRY, LIMIT_DIGIT),
+        [KHASH] = T(HIGH_LIMIT_ENTRY, NONE), [KD] = LOCK,
+    },
+    [STATE_FILTER_ENTRY] = {
+        [K1] = T(UNLOCKED, SELECT_FILTER), [K2] = T(UNLOCKED, SELECT_FILTER),
+        [K3] = T(UNLOCKED, SELECT_FILTER), [KA] = T(FILTER_ENTRY, NONE),
+        [K4] = T(UNLOCKED, SELECT_FILTER), [K5] = T(FILTER_ENTRY, NONE),
+        [K6] = T(FILTER_ENTRY, NONE), [KB] = T(FILTER_ENTRY, NONE),
+        [K7] = T(FILTER_ENTRY, NONE), [K8] = T(FILTER_ENTRY, NONE),
+        [K9] = T(FILTER_ENTRY, NONE), [KC] = T(FILTER_ENTRY, NONE),
+        [KSTAR] = T(UNLOCKED, NONE), [K0] = T(FILTER_ENTRY, NONE),
+        [KHASH] = T(FILTER_ENTRY, NONE), [KD] = LOCK,
+    },
+};
+
+struct transition state_table_lookup(uint8_t state, char key)
+{
+    if (state >= STATE_COUNT)
+    {
+        return (struct transition)LOCK;
+    }
+
+    uint8_t column = 0;
+    if ((key >= KEY_MAP_FIRST) && (key <= KEY_MAP_LAST))
+    {
+        column = key_map[key - KEY_MAP_FIRST];
+    }
+
+    if (column == 0)
+    {
+        return (struct transition){ state, ACTION_NONE, state };
+    }
+
+    return table[state][column - 1];
+}
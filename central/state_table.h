@@ -0,0 +1,92 @@
+/**
+ * @file
+ * @brief Keypad-driven controller state machine as a constant transition table.
+ *
+ * Each (state, key) pair maps to the next state and an action id. The table
+ * lives in FRAM, so handling a key is one table lookup and one call through
+ * the caller's action table, whatever the state. New modes are added as new
+ * rows instead of new branches.
+ *
+ * An action that validates input can fail; the caller then moves to the
+ * entry's reject state instead of its next state. Only the limit commits
+ * have a reject state of their own; every other entry's is its next state.
+ */
+#ifndef STATE_TABLE_H
+#define STATE_TABLE_H
+
+#include <stdint.h>
+
+/**
+ * Controller states
+ */
+enum ui_state
+{
+    STATE_LOCKED,           /**< Locked */
+    STATE_UNLOCK_1,         /**< First correct digit entered */
+    STATE_UNLOCK_2,         /**< Second correct digit entered */
+    STATE_UNLOCK_3,         /**< Third correct digit entered */
+    STATE_UNLOCKED,         /**< Unlocked */
+    STATE_PATTERN_ENTRY,    /**< Pattern input */
+    STATE_WINDOW_ENTRY,     /**< Window size input */
+    STATE_LOW_LIMIT_ENTRY,  /**< Monitor low temperature limit input */
+    STATE_HIGH_LIMIT_ENTRY, /**< Monitor high temperature limit input */
+    STATE_FILTER_ENTRY,     /**< Smoothing filter selection */
+    STATE_COUNT
+};
+
+/**
+ * Side effects run on a transition; implemented by the caller
+ */
+enum ui_action
+{
+    ACTION_NONE,            /**< No side effect */
+    ACTION_LOCK,            /**< Turn off status LEDs and show LOCKED */
+    ACTION_UNLOCKING,       /**< First digit accepted */
+    ACTION_UNLOCKED,        /**< Code accepted */
+    ACTION_ENTER_PATTERN,   /**< Start pattern input */
+    ACTION_ENTER_WINDOW,    /**< Start window size input */
+    ACTION_TOGGLE_UNITS,    /**< Switch between degrees C and F */
+    ACTION_PERIOD_DEC,      /**< Make the LED bar faster */
+    ACTION_PERIOD_INC,      /**< Make the LED bar slower */
+    ACTION_SELECT_PATTERN,  /**< Select the LED bar pattern named by the key */
+    ACTION_WINDOW_DIGIT,    /**< Append the key's digit to the window size */
+    ACTION_WINDOW_COMMIT,   /**< Apply the entered window size */
+    ACTION_ENTER_LIMITS,    /**< Start monitor limit input with the low limit */
+    ACTION_LIMIT_DIGIT,     /**< Append the key's digit to the limit being entered */
+    ACTION_LOW_LIMIT_COMMIT,    /**< Keep the low limit and start the high limit; fails if out of range */
+    ACTION_HIGH_LIMIT_COMMIT,   /**< Keep the high limit and start monitoring; fails if out of range or not above the low limit */
+    ACTION_MONITOR_OFF,     /**< Stop monitoring and go back to streaming samples */
+    ACTION_ENTER_FILTER,    /**< Start filter selection */
+    ACTION_SELECT_FILTER,   /**< Use the smoothing filter named by the key */
+    ACTION_COUNT
+};
+
+/**
+ * Result of a table lookup
+ */
+struct transition
+{
+    /** State to move to, an enum ui_state */
+    uint8_t next_state;
+
+    /** Action to run, an enum ui_action */
+    uint8_t action;
+
+    /** State to move to instead if the action fails, an enum ui_state */
+    uint8_t reject_state;
+};
+
+/**
+ * Look up the transition for a key press.
+ *
+ * Unknown keys leave the state unchanged with no action; unknown states lock.
+ *
+ * @param: state Current state, an enum ui_state.
+ * @param: key Keypad character: '0'-'9', 'A'-'D', '*' or '#'.
+ *
+ * @return: The next state, the action to run and the state to move to if
+ *          it fails.
+ */
+struct transition state_table_lookup(uint8_t state, char key);
+
+#endif // STATE_TABLE_H
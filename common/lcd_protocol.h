@@ -0,0 +1,47 @@
+/**
+ * @file
+ * @brief I2C protocol between the controller and the LCD node.
+ *
+ * The LCD shows a 32 character frame: cells 0-15 are the top row and cells
+ * 16-31 are the bottom row. Instead of resending the whole frame, the
+ * controller sends only the spans that changed since its last transaction.
+ * A transaction is one or more spans back to back:
+ *
+ *     [offset][length][length bytes of characters] [offset][length]...
+ *
+ * A span may cross from the top row to the bottom row. Spans that would run
+ * past the end of the frame invalidate the whole transaction.
+ *
+ * The spans are followed by [CRC high][CRC low]: the CRC-16-CCITT, as
+ * computed by the MSP430 CRC module seeded with LCD_CRC_SEED, of the whole
+ * LCD_FRAME_LEN frame the controller holds once the spans are applied. The
+ * LCD node applies the spans to a copy of its frame and keeps the result only
+ * if the CRCs agree, so a corrupted transaction, or one applied to a frame
+ * that has drifted, is dropped instead of drawn. A transaction whose CRC
+ * matches the frame already shown changes nothing and is not rendered. The
+ * controller resends the whole frame every LCD_LINK_RESYNC_TICKS shown
+ * averages (4 s while streaming, see lcd_link.h), which repairs a dropped
+ * transaction and costs no redraw when nothing was lost.
+ */
+#ifndef LCD_PROTOCOL_H
+#define LCD_PROTOCOL_H
+
+/** Number of character cells in a frame */
+#define LCD_FRAME_LEN 32
+
+/** Number of character cells in one row */
+#define LCD_ROW_LEN 16
+
+/** Bytes of offset and length in front of each span */
+#define LCD_SPAN_HEADER_LEN 2
+
+/** Bytes of CRC after the spans */
+#define LCD_FRAME_CRC_LEN 2
+
+/** CRC seed */
+#define LCD_CRC_SEED 0xFFFF
+
+/** Largest transaction the controller sends: a single span covering the whole frame */
+#define LCD_MAX_TRANSACTION_LEN (LCD_SPAN_HEADER_LEN + LCD_FRAME_LEN + LCD_FRAME_CRC_LEN)
+
+#endif // LCD_PROTOCOL_H
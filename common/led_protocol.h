@@ -0,0 +1,118 @@
+/**
+ * @file
+ * @brief I2C protocol between the controller and the LED bar node.
+ *
+ * A transaction is either a legacy single-byte opcode (0-8 select a pattern,
+ * 9 turns the bar off, 10/11 step the base period down or up) or a frame carrying a batch of commands:
+ *
+ *     [LED_FRAME_START][length][length bytes of commands][CRC high][CRC low]
+ *
+ * The CRC is CRC-16-CCITT as computed by the MSP430 CRC module: seeded with
+ * LED_CRC_SEED, fed one byte at a time through CRCDI_L, over the start byte,
+ * the length and the commands. A frame with a bad CRC or length is dropped
+ * whole, so a bit error can't select the wrong pattern. Commands are applied
+ * in order; parsing stops at an unknown command.
+ *
+ * The LED bar also keeps LED_SEQ_SLOTS uploadable sequences in FRAM, so they
+ * survive a reset. A sequence is up to LED_SEQ_MAX_FRAMES frames of
+ * [bits][duration], the duration in base periods (1 to LED_SEQ_MAX_DURATION).
+ * It is uploaded in chunks with LED_CMD_SEQ_WRITE, which also invalidates
+ * the slot, and becomes playable once LED_CMD_SEQ_COMMIT carries the CRC of
+ * its frames (same CRC as above, over count * LED_SEQ_FRAME_LEN bytes).
+ *
+ * A slot can instead hold a program for the LED bar's animation VM, run with
+ * LED_CMD_PROG_RUN. Each frame is then one instruction, [opcode][argument]:
+ *
+ *     SET b     bits = b
+ *     SHL n     bits <<= n               SHR n     bits >>= n
+ *     ROL n     rotate bits left n       XOR b     bits ^= b
+ *     WAIT n    show bits and hold them for n ticks (at least 1)
+ *     LOOP n    counter = n
+ *     BRANCH i  counter -= 1; if counter != 0, go to instruction i
+ *
+ * A tick is one base period. Running off the end restarts the program with
+ * bits and counter kept. At most LED_VM_BUDGET instructions run per tick; a
+ * tick that uses them all without a WAIT shows bits as they stand.
+ * tools/led_asm.py assembles programs and simulates them on a host.
+ */
+#ifndef LED_PROTOCOL_H
+#define LED_PROTOCOL_H
+
+/** First byte of a framed transaction; never a legacy opcode */
+#define LED_FRAME_START 0xA5
+
+/** Bytes of start and length in front of the commands */
+#define LED_FRAME_HEADER_LEN 2
+
+/** Bytes of CRC after the commands */
+#define LED_FRAME_CRC_LEN 2
+
+/** Largest number of command bytes in one frame */
+#define LED_MAX_PAYLOAD 12
+
+/** Largest transaction: a frame with a full payload */
+#define LED_MAX_TRANSACTION_LEN (LED_FRAME_HEADER_LEN + LED_MAX_PAYLOAD + LED_FRAME_CRC_LEN)
+
+/** CRC seed */
+#define LED_CRC_SEED 0xFFFF
+
+/** [pattern]: run pattern 0-8; any other value turns the bar off */
+#define LED_CMD_SET_PATTERN 0x01
+
+/** [high][low]: base period in 512 Hz ticks, clamped to [LED_PERIOD_MIN, LED_PERIOD_MAX] */
+#define LED_CMD_SET_PERIOD 0x02
+
+/** [bits]: stop animating and show bits, bit 0 on the first LED */
+#define LED_CMD_SET_RAW 0x03
+
+/** [slot][first][count][count frames]: store frames first.. of a sequence and invalidate it */
+#define LED_CMD_SEQ_WRITE 0x04
+
+/** [slot][count][CRC high][CRC low]: make the first count frames of slot playable if the CRC matches */
+#define LED_CMD_SEQ_COMMIT 0x05
+
+/** [slot]: play a committed sequence; ignored for an invalid slot */
+#define LED_CMD_SEQ_PLAY 0x06
+
+/** [slot]: run a committed slot as a VM program; ignored for an invalid slot */
+#define LED_CMD_PROG_RUN 0x07
+
+/** VM opcodes */
+#define LED_VM_SET 0x00
+#define LED_VM_SHL 0x01
+#define LED_VM_SHR 0x02
+#define LED_VM_ROL 0x03
+#define LED_VM_XOR 0x04
+#define LED_VM_WAIT 0x05
+#define LED_VM_LOOP 0x06
+#define LED_VM_BRANCH 0x07
+
+/** Most VM instructions run in one tick */
+#define LED_VM_BUDGET 16
+
+/** Number of sequence slots */
+#define LED_SEQ_SLOTS 4
+
+/** Frames per sequence slot */
+#define LED_SEQ_MAX_FRAMES 16
+
+/** Bytes per sequence frame: bits, then duration */
+#define LED_SEQ_FRAME_LEN 2
+
+/** Longest frame duration in base periods */
+#define LED_SEQ_MAX_DURATION 6
+
+/** Frames that fit in one LED_CMD_SEQ_WRITE */
+#define LED_SEQ_CHUNK_FRAMES ((LED_MAX_PAYLOAD - 4) / LED_SEQ_FRAME_LEN)
+
+/** Pattern number that turns the bar off */
+#define LED_PATTERN_OFF 9
+
+/** Base period limits; patterns run at up to 6 times the base period on a 16-bit timer */
+#define LED_PERIOD_MIN 16
+#define LED_PERIOD_MAX 10922
+
+/** Base period at power-up: 0.25 s */
+#define LED_PERIOD_DEFAULT 128
+
+#endif // LED_PROTOCOL_H
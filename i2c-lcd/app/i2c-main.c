@@ -1,79 +1,106 @@
 #include <msp430fr2355.h>
-
-// Pin Definitions
-#define LCD_RS BIT0     // Register Select
-#define LCD_RW BIT1     // Read/Write
-#define LCD_E  BIT2     // Enable
-#define LCD_DATA P2OUT  // Data bus on Port 1
-#define MAX_MSG_LEN 33
-
-volatile char message_buffer[MAX_MSG_LEN];
-volatile unsigned char msg_index = 0;
-volatile unsigned char received_data = 0;
-
-
-// Delay Function
-void delay(unsigned int count) {
-    while(count--) __delay_cycles(1000);
-}
-
-// Enable Pulse
-void lcd_enable_pulse() {
-    P3OUT |= LCD_E;
-    delay(1);
-    P3OUT &= ~LCD_E;
+#include "lcd_protocol.h"
+#include "src/lcd.h"
+#include <string.h>
+
+volatile unsigned char rx_buffer[LCD_MAX_TRANSACTION_LEN];    // bytes of the transaction being received
+volatile unsigned char rx_len = 0;
+volatile unsigned char rx_overflow = 0;                       // transaction was longer than any valid one
+
+// Double-buffered frame: the I2C ISR applies received spans to the back frame and flags the
+// changed cells; the main loop copies flagged cells to the front frame and renders from it,
+// so reception never waits on the LCD.
+char back_frame[LCD_FRAME_LEN];                               // latest frame received; written by the ISR
+char front_frame[LCD_FRAME_LEN];                              // frame being drawn; owned by the main loop
+volatile unsigned long back_dirty = 0;                        // cells of back_frame not yet copied to front_frame
+unsigned int back_crc;                                        // CRC of back_frame
+char staged_frame[LCD_FRAME_LEN];                             // back_frame with a transaction applied, until its CRC checks out
+
+// CRC of a frame on the CRC module, as the controller computes it
+unsigned int lcd_frame_crc(const char *frame) {
+    unsigned char i;
+
+    CRCINIRES = LCD_CRC_SEED;
+    for (i = 0; i < LCD_FRAME_LEN; i++) {
+        CRCDI_L = frame[i];
+    }
+    return CRCINIRES;
 }
 
-// Command Write Function
-void lcd_write_command(unsigned char cmd) {
-    P3OUT &= ~LCD_RS;  // RS = 0 for command
-    P3OUT &= ~LCD_RW;  // RW = 0 for write
-    LCD_DATA = cmd;    // Write command to data bus
-    lcd_enable_pulse();
-    delay(1);         // Command execution delay
-}
+// Apply the spans of a received transaction to back_frame, returning a bit per changed cell.
+// A malformed transaction, or one whose CRC doesn't match the resulting frame, changes nothing.
+unsigned long lcd_apply_spans(volatile unsigned char *buf, unsigned char len) {
+    unsigned char i = 0;
 
-// Data Write Function
-void lcd_write_data(unsigned char data) {
-    P3OUT |= LCD_RS;   // RS = 1 for data
-    P3OUT &= ~LCD_RW;  // RW = 0 for write
-    LCD_DATA = data;   // Write data to data bus
-    lcd_enable_pulse();
-    delay(1);         // Data write delay
-}
+    if (len < LCD_FRAME_CRC_LEN) {
+        return 0;
+    }
+    len -= LCD_FRAME_CRC_LEN;
+    unsigned int crc = (buf[len] << 8) | buf[len + 1];
+    if (crc == back_crc) {
+        return 0;   // same frame as the one already shown (e.g. a periodic resend): nothing to draw
+    }
 
-// LCD Initialization
-void lcd_init() {
-    P3DIR |= LCD_RS | LCD_RW | LCD_E;
-    P2DIR |= 0xFF;   // Set Port 1 as output for data bus
+    // validate every span before touching the frame
+    while (i < len) {
+        if (len - i < LCD_SPAN_HEADER_LEN) {
+            return 0;
+        }
+        unsigned char offset = buf[i];
+        unsigned char count = buf[i + 1];
+        if ((count == 0) || (offset >= LCD_FRAME_LEN) || (count > LCD_FRAME_LEN - offset) ||
+            (count > len - i - LCD_SPAN_HEADER_LEN)) {
+            return 0;
+        }
+        i += LCD_SPAN_HEADER_LEN + count;
+    }
 
-    delay(50);    // Power-on delay
+    // apply to a copy and check the result against the controller's frame
+    memcpy(staged_frame, back_frame, LCD_FRAME_LEN);
+    i = 0;
+    while (i < len) {
+        unsigned char offset = buf[i];
+        unsigned char count = buf[i + 1];
+        i += LCD_SPAN_HEADER_LEN;
+        while (count--) {
+            staged_frame[offset++] = buf[i++];
+        }
+    }
+    if (lcd_frame_crc(staged_frame) != crc) {
+        return 0;
+    }
 
-    lcd_write_command(0x38); // Function set: 8-bit, 2 lines, 5x8 dots
-    lcd_write_command(0x0C); // Display ON, Cursor OFF
-    lcd_clear();
-    lcd_write_command(0x06); // Entry mode set: Increment cursor
+    unsigned long dirty = 0;
+    unsigned long bit = 1;
+    for (i = 0; i < LCD_FRAME_LEN; i++, bit <<= 1) {
+        if (back_frame[i] != staged_frame[i]) {
+            back_frame[i] = staged_frame[i];
+            dirty |= bit;
+        }
+    }
+    back_crc = crc;
+    return dirty;
 }
 
-// Set LCD Cursor Position
-void lcd_set_cursor(unsigned char address) {
-    lcd_write_command(0x80 | address);
-    delay(1);
-}
+// Write the cells flagged in dirty, only moving the cursor where a run of dirty cells starts
+void lcd_render(unsigned long dirty) {
+    unsigned char i;
+    unsigned char cursor_valid = 0;
+    unsigned long bit = 1;
 
-// Display String on LCD
-void lcd_display_string(char *str) {
-    while(*str) {
-        lcd_write_data(*str++);
+    for (i = 0; i < LCD_FRAME_LEN; i++, bit <<= 1) {
+        if (!(dirty & bit)) {
+            cursor_valid = 0;
+            continue;
+        }
+        if ((!cursor_valid) || (i == LCD_ROW_LEN)) {
+            lcd_set_cursor(i < LCD_ROW_LEN ? i : LCD_ROW2_ADDR + (i - LCD_ROW_LEN));
+            cursor_valid = 1;
+        }
+        lcd_write_data(front_frame[i]);
     }
 }
 
-// Clear LCD
-void lcd_clear(){
-    lcd_write_command(0x01); // Clear display
-    delay(1);             // Delay for clear command
-}
-
 void i2c_slave_setup() {
     UCB0CTLW0 |= UCSWRST;       // Software reset
 
@@ -105,11 +132,32 @@ int main(void) {
     __delay_cycles(50000);      // Wait ~50ms after power-up
     i2c_slave_setup();          // Setup I2C
     lcd_init();                 // Initialize LCD
+    back_crc = lcd_frame_crc(back_frame);
     __enable_interrupt();       // Enable global iunterupts
 
     lcd_display_string("Ready");
 
     while (1) {
+        // Swap in what the ISR received: copy the changed cells while the ISR can't touch them
+        __disable_interrupt();
+        unsigned long dirty = back_dirty;
+        back_dirty = 0;
+        unsigned char i;
+        unsigned long bit = 1;
+        for (i = 0; i < LCD_FRAME_LEN; i++, bit <<= 1) {
+            if (dirty & bit) {
+                front_frame[i] = back_frame[i];
+            }
+        }
+
+        if (dirty == 0) {
+            __bis_SR_register(LPM0_bits | GIE);     // sleep until the next frame; enables interrupts
+            continue;
+        }
+        __enable_interrupt();
+
+        // Slow part: frames arriving meanwhile accumulate in back_frame
+        lcd_render(dirty);
     }
 }
 
@@ -118,34 +166,25 @@ __interrupt void EUSCI_B0_I2C_ISR(void) {
     switch (__even_in_range(UCB0IV, USCI_I2C_UCBIT9IFG)) {
         case USCI_I2C_UCRXIFG0: {
             char c = UCB0RXBUF;
-            if (msg_index < MAX_MSG_LEN) {
-                message_buffer[msg_index++] = c;
+            if (rx_len < LCD_MAX_TRANSACTION_LEN) {
+                rx_buffer[rx_len++] = c;
+            } else {
+                rx_overflow = 1;
             }
             break;
         }
 
         case USCI_I2C_UCSTPIFG: {
-            // STOP received — display message if 32 bytes
-            if (msg_index == 32) {
-                lcd_clear();
-
-                delay(5);
-
-                // Top row
-                lcd_set_cursor(0x00);
-                unsigned char i;
-                for (i = 0; i < 16; i++) {
-                    lcd_write_data(message_buffer[i]);
-                }
-
-                // Bottom row
-                lcd_set_cursor(0x40);
-                for (i = 16; i < 32; i++) {
-                    lcd_write_data(message_buffer[i]);
+            // STOP received — commit the spans to the back frame and let the main loop draw them
+            if (!rx_overflow) {
+                back_dirty |= lcd_apply_spans(rx_buffer, rx_len);
+                if (back_dirty) {
+                    __bic_SR_register_on_exit(LPM0_bits);
                 }
             }
 
-            msg_index = 0;  // Always reset
+            rx_len = 0;     // Always reset
+            rx_overflow = 0;
             break;
         }
 
@@ -0,0 +1,179 @@
+/**
+ * @file
+ * @brief HD44780 character LCD driver on an 8-bit or 4-bit parallel bus.
+ */
+#include "lcd.h"
+
+#include <msp430fr2355.h>
+
+// Pin Definitions
+#define LCD_RS BIT0         // Register Select
+#define LCD_RW BIT1         // Read/Write
+#define LCD_E  BIT2         // Enable
+#define LCD_DATA P2OUT      // Data bus on Port 2
+#define LCD_DATA_IN P2IN
+#define LCD_DATA_DIR P2DIR
+#define LCD_BUSY BIT7       // Busy flag on D7
+
+#if LCD_BUS_4BIT
+#define LCD_DATA_PINS 0xF0          // D4-D7 on P2.4-P2.7
+#define LCD_FUNCTION_SET 0x28       // 4-bit, 2 lines, 5x8 dots
+#else
+#define LCD_DATA_PINS 0xFF          // D0-D7 on P2.0-P2.7
+#define LCD_FUNCTION_SET 0x38       // 8-bit, 2 lines, 5x8 dots
+#endif
+
+// Instruction times from the HD44780 datasheet (270 kHz oscillator) with margin
+#define LCD_CYCLES(us) ((unsigned long)(us) * (LCD_MCLK_HZ / 1000000UL))
+#define LCD_EXEC_CYCLES LCD_CYCLES(50)          // most instructions and data writes: 37 us
+#define LCD_HOME_CYCLES LCD_CYCLES(1700)        // clear display and return home: 1.52 ms
+#define LCD_POWER_ON_CYCLES LCD_CYCLES(50000)   // Vcc rise to first instruction: > 40 ms
+
+// Give up on the busy flag after roughly the slowest instruction, so a missing LCD can't hang the node
+#define LCD_BUSY_POLL_LIMIT 2000
+
+// Enable Pulse: E high for at least 230 ns, one instruction at MCLK <= 4 MHz
+static void lcd_enable_pulse(void)
+{
+    P3OUT |= LCD_E;
+    __delay_cycles(1);
+    P3OUT &= ~LCD_E;
+}
+
+#if LCD_BUS_4BIT
+// Latch the high nibble of value on D4-D7, leaving P2.0-P2.3 alone
+static void lcd_write_nibble(unsigned char value)
+{
+    LCD_DATA = (LCD_DATA & ~LCD_DATA_PINS) | (value & LCD_DATA_PINS);
+    lcd_enable_pulse();
+}
+#endif
+
+// Latch a full byte, as two nibbles (high first) on the 4-bit bus
+static void lcd_bus_write(unsigned char value)
+{
+#if LCD_BUS_4BIT
+    lcd_write_nibble(value);
+    lcd_write_nibble(value << 4);
+#else
+    LCD_DATA = value;
+    lcd_enable_pulse();
+#endif
+}
+
+#if LCD_TIMING == LCD_TIMING_BUSY_FLAG
+// Block until the controller clears the busy flag
+static void lcd_wait_ready(void)
+{
+    unsigned int polls = LCD_BUSY_POLL_LIMIT;
+    unsigned char busy;
+
+    LCD_DATA_DIR &= (unsigned char)~LCD_DATA_PINS;    // release the bus to the LCD
+    P3OUT &= ~LCD_RS;       // RS = 0, RW = 1: read busy flag and address
+    P3OUT |= LCD_RW;
+
+    do
+    {
+        P3OUT |= LCD_E;
+        __delay_cycles(1);  // data valid 160 ns after E rises
+        busy = LCD_DATA_IN & LCD_BUSY;
+        P3OUT &= ~LCD_E;
+#if LCD_BUS_4BIT
+        lcd_enable_pulse();             // clock out the low nibble of the address counter
+#endif
+    } while (busy && --polls);
+
+    P3OUT &= ~LCD_RW;
+    LCD_DATA_DIR |= LCD_DATA_PINS;
+}
+#endif
+
+// Write one byte to the instruction (rs = 0) or data (rs = LCD_RS) register
+static void lcd_write(unsigned char rs, unsigned char value)
+{
+#if LCD_TIMING == LCD_TIMING_BUSY_FLAG
+    lcd_wait_ready();
+#endif
+
+    if (rs)
+    {
+        P3OUT |= LCD_RS;
+    }
+    else
+    {
+        P3OUT &= ~LCD_RS;
+    }
+    P3OUT &= ~LCD_RW;       // RW = 0 for write
+    lcd_bus_write(value);
+
+#if LCD_TIMING == LCD_TIMING_FIXED
+    if (!rs && (value < 0x04))
+    {
+        __delay_cycles(LCD_HOME_CYCLES);    // clear display / return home
+    }
+    else
+    {
+        __delay_cycles(LCD_EXEC_CYCLES);
+    }
+#endif
+}
+
+void lcd_write_command(unsigned char cmd)
+{
+    lcd_write(0, cmd);
+}
+
+void lcd_write_data(unsigned char data)
+{
+    lcd_write(LCD_RS, data);
+}
+
+void lcd_init(void)
+{
+    P3OUT &= ~(LCD_RS | LCD_RW | LCD_E);
+    P3DIR |= LCD_RS | LCD_RW | LCD_E;
+    LCD_DATA_DIR |= LCD_DATA_PINS;  // Data bus pins as outputs
+
+    __delay_cycles(LCD_POWER_ON_CYCLES);
+
+    // The busy flag can't be checked until after the first function set
+    P3OUT &= ~(LCD_RS | LCD_RW);
+#if LCD_BUS_4BIT
+    // Initialization by instruction: force 8-bit mode three times, then switch to 4-bit
+    lcd_write_nibble(0x30);
+    __delay_cycles(LCD_CYCLES(4100));
+    lcd_write_nibble(0x30);
+    __delay_cycles(LCD_CYCLES(100));
+    lcd_write_nibble(0x30);
+    __delay_cycles(LCD_EXEC_CYCLES);
+    lcd_write_nibble(0x20);
+    __delay_cycles(LCD_EXEC_CYCLES);
+#else
+    LCD_DATA = LCD_FUNCTION_SET;
+    lcd_enable_pulse();
+    __delay_cycles(LCD_EXEC_CYCLES);
+#endif
+
+    lcd_write_command(LCD_FUNCTION_SET);
+    lcd_write_command(0x0C); // Display ON, Cursor OFF
+    lcd_clear();
+    lcd_write_command(0x06); // Entry mode set: Increment cursor
+}
+
+void lcd_set_cursor(unsigned char address)
+{
+    lcd_write_command(0x80 | address);
+}
+
+void lcd_display_string(char *str)
+{
+    while (*str)
+    {
+        lcd_write_data(*str++);
+    }
+}
+
+void lcd_clear(void)
+{
+    lcd_write_command(0x01);
+}
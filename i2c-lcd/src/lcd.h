@@ -0,0 +1,102 @@
+/**
+ * @file
+ * @brief HD44780 character LCD driver on an 8-bit or 4-bit parallel bus.
+ *
+ * RS, RW and E are on P3.0-P3.2. With the default 8-bit bus D0-D7 are on
+ * P2.0-P2.7. Building with LCD_BUS_4BIT set to 1 drives only D4-D7 on
+ * P2.4-P2.7, sending each byte as two nibbles, and leaves P2.0-P2.3 free for
+ * other uses; D0-D3 of the LCD are left unconnected. How the driver waits
+ * for the controller to finish an instruction is selected at build time with
+ * LCD_TIMING:
+ *
+ * - LCD_TIMING_FIXED, the default, waits the datasheet worst case after each
+ *   write, with the delays calibrated to MCLK through LCD_MCLK_HZ. RW is held
+ *   low, so this is safe whatever the LCD's supply.
+ * - LCD_TIMING_BUSY_FLAG polls the busy flag on D7 before each write, so every
+ *   write costs only as long as the controller actually needs. This reads the
+ *   bus back, so D7 must be at a level P2.7 tolerates (LCD on 3.3 V or a level
+ *   shifter); only select it once the board is known to be wired that way.
+ *
+ * A full-screen redraw (two cursor moves and 32 characters on the 8-bit bus)
+ * at the default 1 MHz MCLK, timed by test/test_lcd_timing.c against the
+ * simulator's HD44780 model (37 us per character, the datasheet's figure),
+ * with the driver charged for its delays and port accesses:
+ *
+ * - the old driver, 1-2 ms of delay() per write: about 70 ms, worked out
+ *   from its delays;
+ * - LCD_TIMING_FIXED, 50 us plus about 15 us of port I/O per write: 2.1 ms;
+ * - LCD_TIMING_BUSY_FLAG: 2.3 ms. A poll takes about 10 us at 1 MHz, and
+ *   with turning the bus round that costs more than the fixed wait's 13 us
+ *   of margin; polling only wins with a faster MCLK or a controller quicker
+ *   than the datasheet.
+ *
+ * The 4-bit bus sends every byte, and reads every busy flag, as two nibbles:
+ * 2.6 ms with LCD_TIMING_FIXED and 3.2 ms with LCD_TIMING_BUSY_FLAG, 1.24x and
+ * 1.37x the 8-bit bus.
+ */
+#ifndef LCD_H
+#define LCD_H
+
+/** Use the 4-bit bus on P2.4-P2.7 instead of the 8-bit bus on P2 */
+#ifndef LCD_BUS_4BIT
+#define LCD_BUS_4BIT 0
+#endif
+
+/** Wait by polling the busy flag */
+#define LCD_TIMING_BUSY_FLAG 0
+
+/** Wait the worst-case instruction time from the datasheet */
+#define LCD_TIMING_FIXED 1
+
+#ifndef LCD_TIMING
+#define LCD_TIMING LCD_TIMING_FIXED
+#endif
+
+/** CPU clock used to convert instruction times to __delay_cycles counts */
+#ifndef LCD_MCLK_HZ
+#define LCD_MCLK_HZ 1000000UL
+#endif
+
+/** DDRAM address of the first cell of the bottom row */
+#define LCD_ROW2_ADDR 0x40
+
+/**
+ * Configure the pins and initialize the controller: 2 lines, display on,
+ * cursor off, cursor increments after each write.
+ */
+void lcd_init(void);
+
+/**
+ * Write an instruction to the controller.
+ *
+ * @param: cmd HD44780 instruction.
+ */
+void lcd_write_command(unsigned char cmd);
+
+/**
+ * Write a character at the cursor.
+ *
+ * @param: data Character code.
+ */
+void lcd_write_data(unsigned char data);
+
+/**
+ * Move the cursor.
+ *
+ * @param: address DDRAM address; the bottom row starts at LCD_ROW2_ADDR.
+ */
+void lcd_set_cursor(unsigned char address);
+
+/**
+ * Write a NUL-terminated string at the cursor.
+ *
+ * @param: str String to write.
+ */
+void lcd_display_string(char *str);
+
+/**
+ * Clear the display and return the cursor home.
+ */
+void lcd_clear(void);
+
+#endif // LCD_H
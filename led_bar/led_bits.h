@@ -0,0 +1,22 @@
+/**
+ * @file
+ * @brief Mapping of the LED bar's logical bits onto its port pins.
+ *
+ * Bit 0 is the first LED. The LEDs are on P1.1, P1.0, P2.7, P2.6, P1.4,
+ * P1.5, P1.6 and P1.7, so a set of bits is split into the values to write to
+ * P1OUT and P2OUT once per step rather than bit by bit in the ISR.
+ */
+#ifndef LED_BITS_H
+#define LED_BITS_H
+
+/** Pins the LEDs use on each port */
+#define LED_P1_PINS 0xF3
+#define LED_P2_PINS 0xC0
+
+/** P1OUT value for bits: 0 to P1.1, 1 to P1.0, 4-7 to P1.4-P1.7 */
+#define LED_P1OUT(b) ((((b) << 1) & 0x02) | (((b) >> 1) & 0x01) | ((b) & 0xF0))
+
+/** P2OUT value for bits: 2 to P2.7, 3 to P2.6 */
+#define LED_P2OUT(b) ((((b) << 5) & 0x80) | (((b) << 3) & 0x40))
+
+#endif // LED_BITS_H
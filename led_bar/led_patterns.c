@@ -0,0 +1,53 @@
+/**
+ * @file
+ * @brief Generators for the LED bar's numbered on/off patterns.
+ */
+#include "led_patterns.h"
+
+unsigned char bits_static(unsigned int step)
+{
+    (void)step;
+    return 0b10101010;
+}
+
+unsigned char bits_toggle(unsigned int step)
+{
+    return step ? 0b01010101 : 0b10101010;
+}
+
+unsigned char bits_up_counter(unsigned int step)
+{
+    return step;
+}
+
+unsigned char bits_in_and_out(unsigned int step)
+{
+    unsigned char k = (step < 4) ? step : 6 - step;
+    return (0b00010000 << k) | (0b00001000 >> k);
+}
+
+unsigned char bits_down_counter(unsigned int step)
+{
+    return 255 - step;
+}
+
+unsigned char bits_rotate_one_left(unsigned int step)
+{
+    return 1 << step;
+}
+
+unsigned char bits_rotate_seven_right(unsigned int step)
+{
+    return ~(0b10000000 >> step);
+}
+
+unsigned char bits_fill_left(unsigned int step)
+{
+    return (2 << step) - 1;
+}
+
+unsigned char bits_off(unsigned int step)
+{
+    (void)step;
+    return 0;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file
+ * @brief Generators for the LED bar's numbered on/off patterns.
+ *
+ * Each generator works out the LED bits for one step of its pattern (bit 0
+ * on the first LED) from the step number, for steps 0 to the pattern's
+ * length - 1, so a pattern costs a few instructions rather than a table row
+ * per step.
+ */
+#ifndef LED_PATTERNS_H
+#define LED_PATTERNS_H
+
+/** Pattern 0: alternate LEDs, 1 step */
+unsigned char bits_static(unsigned int step);
+
+/** Pattern 1: alternate LEDs swapping, 2 steps */
+unsigned char bits_toggle(unsigned int step);
+
+/** Pattern 2: binary count up, 256 steps */
+unsigned char bits_up_counter(unsigned int step);
+
+/** Pattern 3: a pair of LEDs moving out from the middle and back in, 6 steps */
+unsigned char bits_in_and_out(unsigned int step);
+
+/** Pattern 4: binary count down, 256 steps */
+unsigned char bits_down_counter(unsigned int step);
+
+/** Pattern 5: one LED moving along the bar, 8 steps */
+unsigned char bits_rotate_one_left(unsigned int step);
+
+/** Pattern 6: one dark LED moving back along the bar, 8 steps */
+unsigned char bits_rotate_seven_right(unsigned int step);
+
+/** Pattern 7: the bar filling up, 8 steps */
+unsigned char bits_fill_left(unsigned int step);
+
+/** All LEDs off, 1 step */
+unsigned char bits_off(unsigned int step);
+
+#endif // LED_PATTERNS_H
@@ -0,0 +1,78 @@
+/**
+ * @file
+ * @brief Interpreter for the LED bar's animation programs (see led_protocol.h).
+ */
+#include "led_vm.h"
+#include "led_protocol.h"
+
+void led_vm_reset(struct led_vm *vm)
+{
+    vm->pc = 0;
+    vm->bits = 0;
+    vm->count = 0;
+    vm->wait = 0;
+}
+
+bool led_vm_tick(struct led_vm *vm, const unsigned char *program, unsigned char length)
+{
+    unsigned char budget = LED_VM_BUDGET;
+
+    if (vm->wait)
+    {
+        vm->wait--;
+        return false;
+    }
+
+    while (budget--)
+    {
+        const unsigned char *ins = &program[vm->pc * LED_SEQ_FRAME_LEN];
+        unsigned char arg = ins[1];
+
+        if (++vm->pc >= length)
+        {
+            vm->pc = 0;
+        }
+        switch (ins[0])
+        {
+            case LED_VM_SET:
+                vm->bits = arg;
+                break;
+
+            case LED_VM_SHL:
+                vm->bits <<= arg & 7;
+                break;
+
+            case LED_VM_SHR:
+                vm->bits >>= arg & 7;
+                break;
+
+            case LED_VM_ROL:
+                arg &= 7;
+                vm->bits = (vm->bits << arg) | (vm->bits >> (8 - arg));
+                break;
+
+            case LED_VM_XOR:
+                vm->bits ^= arg;
+                break;
+
+            case LED_VM_WAIT:
+                vm->wait = arg ? arg - 1 : 0;
+                return true;
+
+            case LED_VM_LOOP:
+                vm->count = arg;
+                break;
+
+            case LED_VM_BRANCH:
+                if ((--vm->count != 0) && (arg < length))
+                {
+                    vm->pc = arg;
+                }
+                break;
+
+            default:
+                break;      // unknown opcodes do nothing
+        }
+    }
+    return true;            // out of budget: show bits as they stand and carry on next tick
+}
@@ -0,0 +1,51 @@
+/**
+ * @file
+ * @brief Interpreter for the LED bar's animation programs (see led_protocol.h).
+ *
+ * A program is an uploaded slot's frames read as [opcode][argument]
+ * instructions. The interpreter only touches its registers, so the step ISR
+ * decides what to do with the bits, and the host tests can run it against
+ * tools/led_asm.py's simulator.
+ */
+#ifndef LED_VM_H
+#define LED_VM_H
+
+#include <stdbool.h>
+
+/**
+ * VM registers
+ */
+struct led_vm
+{
+    /** Next instruction */
+    unsigned char pc;
+
+    /** LED states, bit 0 the first LED */
+    unsigned char bits;
+
+    /** LOOP/BRANCH counter */
+    unsigned char count;
+
+    /** Ticks left of a WAIT */
+    unsigned char wait;
+};
+
+/**
+ * Clear the registers, to start a program from its first instruction.
+ *
+ * @param: vm Registers to clear.
+ */
+void led_vm_reset(struct led_vm *vm);
+
+/**
+ * Run a program for one tick: up to LED_VM_BUDGET instructions, stopping at a WAIT.
+ *
+ * @param: vm Registers.
+ * @param: program Instructions, LED_SEQ_FRAME_LEN bytes each.
+ * @param: length Number of instructions, at least 1.
+ *
+ * @return: true if vm->bits should be shown; false while a WAIT holds the last ones.
+ */
+bool led_vm_tick(struct led_vm *vm, const unsigned char *program, unsigned char length);
+
+#endif // LED_VM_H
@@ -1,68 +1,113 @@
 #include "intrinsics.h"
 #include <msp430fr2310.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "led_protocol.h"
+#include "led_bits.h"
+#include "led_patterns.h"
+#include "led_vm.h"
 
 //-- I2C
-int received_data;
+unsigned char rx_buffer[LED_MAX_TRANSACTION_LEN];  // bytes of the current transaction
+unsigned char rx_len = 0;
+unsigned char rx_overflow = 0;                      // transaction too long, dropped at STOP
 void i2c_slave_setup();
+void handleTransaction();
+void selectPattern(unsigned char);
+void savePosition();
 
 //-- I2C HEARTBEAT INDICATOR
 int delay = 30000;      // delay for heartbeat
 int count = 0;          // how long heartbeat has been fast
 
 //-- LED BAR
-int stepIndex = 0;                                  // Current step index
-int stepOldIndex[] = {0, 0, 0, 0, 0, 0, 0, 0};      // Last index for each pattern
-int prev_pattern = 0;                               // Previously displayed pattern
-int stepStart = 0;                                  // Start of the selected pattern
-int seqLength = 1;                                  // Length of selected sequence
-int basePeriod = 128;                               // Default base period
-int patternMultiplier = 1;                          // Multiplier to change base period
-unsigned char stepSequence[] = {
-                // Pattern 0
-                0b10101010,
-                0b10101010,
-                // Pattern 1
-                0b10101010,
-                0b01010101,
-                // Pattern 3
-                0b00011000,
-                0b00100100,
-                0b01000010,
-                0b10000001,
-                0b01000010,
-                0b00100100,
-                // Pattern 5
-                0b00000001,
-                0b00000010,
-                0b00000100,
-                0b00001000,
-                0b00010000,
-                0b00100000,
-                0b01000000,
-                0b10000000,
-                // Pattern 6
-                0b01111111,
-                0b10111111,
-                0b11011111,
-                0b11101111,
-                0b11110111,
-                0b11111011,
-                0b11111101,
-                0b11111110,
-                // Pattern 7
-                0b1,
-                0b11,
-                0b111,
-                0b1111,
-                0b11111,
-                0b111111,
-                0b1111111,
-                0b11111111,
-                // Pattern NULL
-                0b0,
-                0b0
-            };
+// A frame holds the values to write to P1OUT and P2OUT (see led_bits.h)
+struct ledFrame {
+    unsigned char p1;
+    unsigned char p2;
+};
+
+// Brightness by binary code modulation on Timer_B0: each refresh shows BCM_BITS bit planes in
+// turn, plane k for BCM_LSB_TICKS << k SMCLK ticks, so an LED lit in the planes of the bits set in
+// its duty is on for duty / (2^BCM_BITS - 1) of the time. An on/off step puts the same frame
+// in every plane.
+#define MCLK_HZ 8000000UL                   // MCLK and SMCLK from the DCO
+#ifndef BCM_BITS
+#define BCM_BITS 6                          // brightness resolution, 4-8 bits, build-time configurable
+#endif
+#define BCM_REFRESH_HZ 400                  // full refreshes per second
+#define BCM_LSB_TICKS (MCLK_HZ / BCM_REFRESH_HZ / ((1 << BCM_BITS) - 1))
+#define BCM_ISR_CYCLES 64                   // generous bound on ISR entry, body and exit
+#if (BCM_BITS < 4) || (BCM_BITS > 8)
+#error "BCM_BITS must be 4-8"
+#endif
+#if BCM_LSB_TICKS < BCM_ISR_CYCLES
+#error "BCM_LSB_TICKS too short for the ISR; lower BCM_REFRESH_HZ or BCM_BITS"
+#endif
+struct ledFrame bcmPlanes[BCM_BITS];        // frame for each bit plane, LSB first
+unsigned char bcmPlane = 0;                 // plane being shown
+unsigned int bcmTicks = BCM_LSB_TICKS;      // how long it is shown
+
+// Gamma 2.2 brightness ramp for fades, 16 perceptually even levels as BCM duties
+#define GAMMA(v) ((v) >> (8 - BCM_BITS))
+const unsigned char fadeLevels[16] = {
+    GAMMA(0), GAMMA(1), GAMMA(3), GAMMA(7), GAMMA(14), GAMMA(23), GAMMA(34), GAMMA(48),
+    GAMMA(64), GAMMA(83), GAMMA(105), GAMMA(129), GAMMA(156), GAMMA(186), GAMMA(219), GAMMA(255)
+};
+
+// Patterns are generators: bits(step) works out step's on/off LEDs (see led_patterns.h), or, for
+// patterns that need more than that, show(step) loads step's frame into the bit planes itself
+struct pattern {
+    unsigned char (*bits)(unsigned int step);
+    void (*show)(unsigned int step);        // used when bits is 0
+    unsigned int length;                    // steps before the pattern repeats
+    unsigned char multiplier;               // step period in base periods
+};
+void showBits(unsigned char bits);
+void showFade(unsigned int step);
+unsigned char bitsRaw(unsigned int step);
+void showSequence(unsigned int step);
+void showProgram(unsigned int step);
+#define PATTERN_COUNT 9                     // patterns 0-8; anything else is off or a period step
+const struct pattern patterns[PATTERN_COUNT] = {
+    {bits_static, 0, 1, 4},
+    {bits_toggle, 0, 2, 4},
+    {bits_up_counter, 0, 256, 1},
+    {bits_in_and_out, 0, 6, 2},
+    {bits_down_counter, 0, 256, 1},
+    {bits_rotate_one_left, 0, 8, 6},
+    {bits_rotate_seven_right, 0, 8, 2},
+    {bits_fill_left, 0, 8, 4},
+    {0, showFade, 32, 1},
+};
+const struct pattern offPattern = {bits_off, 0, 1, 4};
+const struct pattern rawPattern = {bitsRaw, 0, 1, 4};   // bits from LED_CMD_SET_RAW
+unsigned char rawBits = 0;
+
+// Uploaded sequences, kept in FRAM across resets (see led_protocol.h). Program FRAM is write
+// protected except while a command is storing into it.
+#define FRAM_WRITE_ENABLE()  (SYSCFG0 = FRWPPW | DFWP)
+#define FRAM_WRITE_DISABLE() (SYSCFG0 = FRWPPW | DFWP | PFWP)
+struct seqSlot {
+    unsigned char count;                    // frames, 0 until committed
+    unsigned int crc;                       // CRC of the committed frames
+    unsigned char frames[LED_SEQ_MAX_FRAMES * LED_SEQ_FRAME_LEN];
+};
+#pragma PERSISTENT(seqSlots)
+struct seqSlot seqSlots[LED_SEQ_SLOTS] = {0};
+struct pattern seqPattern = {0, showSequence, 1, 1};    // length set when a slot is played
+const struct pattern vmPattern = {0, showProgram, 1, 1};
+const struct seqSlot *seqPlaying;                   // slot played by seqPattern or run by vmPattern
+
+struct led_vm vm;                           // animation VM registers (see led_vm.h)
+unsigned char seqCommand(unsigned char *cmd, unsigned char avail);
+
+const struct pattern *pattern = &offPattern;        // Selected pattern
+unsigned int stepIndex = 0;                         // Current step index
+unsigned int stepOldIndex[PATTERN_COUNT] = {0};     // Last index for each pattern
+unsigned char prev_pattern = 0;                     // Previously displayed pattern
+unsigned int basePeriod = LED_PERIOD_DEFAULT;       // Default base period, in ACLK/64 ticks
+void setupClock();
 void setupLeds();
 void setPattern(int);
 
@@ -73,6 +118,7 @@ int main(void)
     PM5CTL0 &= ~LOCKLPM5;                // Enable GPIOs
 
     __delay_cycles(50000);               // Power-on delay
+    setupClock();                        // 8 MHz for the brightness modulation
 
     i2c_slave_setup();                  // Setup I2C master
 
@@ -82,7 +128,7 @@ int main(void)
 
     //-- Setup patterns
     setupLeds(); // NOTE: this doesn't seem to work if the LED bar is hooked up, so just pull it out, let it setup the pins, the drop it back in
-    setPattern(9);
+    setPattern(LED_PATTERN_OFF);
 
      // enable interrupts
     __enable_interrupt();
@@ -93,6 +139,7 @@ int main(void)
         P2OUT ^= BIT0;
         while(n < delay) {
             n++;
+            __delay_cycles(42);         // delay counts were tuned at 1 MHz
         }
         n = 0;
         if (count < 50) {
@@ -124,120 +171,330 @@ void i2c_slave_setup() {
 
     UCB0CTLW0 &= ~UCSWRST;      // Exit reset
 
-    UCB0IE |= UCRXIE0;          // Enable receive interrupt
+    UCB0IE |= UCRXIE0 | UCSTPIE;    // Enable receive and STOP interrupts
 }
 
 // I2C Interrupt Service Routine
 #pragma vector=EUSCI_B0_VECTOR
 __interrupt void EUSCI_B0_I2C_ISR(void) {
-    received_data = UCB0RXBUF; // Read received byte
+    switch (__even_in_range(UCB0IV, USCI_I2C_UCBIT9IFG)) {
+        case USCI_I2C_UCRXIFG0: {
+            unsigned char c = UCB0RXBUF;
+            if (rx_len < LED_MAX_TRANSACTION_LEN) {
+                rx_buffer[rx_len++] = c;
+            } else {
+                rx_overflow = 1;
+            }
+            break;
+        }
 
-    // if a pattern is received...
-    if (received_data < 8) {
-        // save previous state
-        stepOldIndex[prev_pattern] = stepIndex;
-        if (prev_pattern != received_data) {
-            stepIndex = stepOldIndex[received_data];
-        } else {
-            stepIndex = 0;
+        case USCI_I2C_UCSTPIFG:
+            // STOP received - act on the whole transaction
+            if (!rx_overflow) {
+                handleTransaction();
+            }
+            rx_len = 0;     // Always reset
+            rx_overflow = 0;
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Apply a legacy opcode or a checked frame (see led_protocol.h)
+void handleTransaction() {
+    unsigned char i;
+    unsigned char len;
+    unsigned char *cmd;
+    unsigned char *end;
+
+    if (rx_len == 1 && rx_buffer[0] != LED_FRAME_START) {
+        selectPattern(rx_buffer[0]);    // legacy single-byte opcode
+    } else {
+        len = rx_buffer[1];
+        if (rx_len < LED_FRAME_HEADER_LEN + LED_FRAME_CRC_LEN || rx_buffer[0] != LED_FRAME_START ||
+            len > LED_MAX_PAYLOAD || rx_len != LED_FRAME_HEADER_LEN + len + LED_FRAME_CRC_LEN) {
+            return;
+        }
+
+        CRCINIRES = LED_CRC_SEED;
+        for (i = 0; i < LED_FRAME_HEADER_LEN + len; i++) {
+            CRCDI_L = rx_buffer[i];
+        }
+        if (CRCINIRES != ((rx_buffer[i] << 8) | rx_buffer[i + 1])) {
+            return;         // corrupted - drop the whole frame
+        }
+
+        cmd = &rx_buffer[LED_FRAME_HEADER_LEN];
+        end = cmd + len;
+        while (cmd < end) {
+            if (cmd[0] == LED_CMD_SET_PATTERN && end - cmd >= 2) {
+                selectPattern(cmd[1]);
+                cmd += 2;
+            } else if (cmd[0] == LED_CMD_SET_PERIOD && end - cmd >= 3) {
+                basePeriod = (cmd[1] << 8) | cmd[2];
+                if (basePeriod < LED_PERIOD_MIN) {
+                    basePeriod = LED_PERIOD_MIN;
+                } else if (basePeriod > LED_PERIOD_MAX) {
+                    basePeriod = LED_PERIOD_MAX;
+                }
+                TB1CCR0 = basePeriod * pattern->multiplier; // re-time the current pattern
+                cmd += 3;
+            } else if (cmd[0] == LED_CMD_SET_RAW && end - cmd >= 2) {
+                rawBits = cmd[1];                       // hold the bits until the next pattern
+                savePosition();
+                pattern = &rawPattern;
+                stepIndex = 0;
+                cmd += 2;
+            } else if ((i = seqCommand(cmd, end - cmd)) != 0) {
+                cmd += i;
+            } else {
+                break;      // unknown or truncated command
+            }
         }
-        // update prev pattern
-        prev_pattern = received_data;
     }
-    setPattern(received_data);
     delay = 10000;
     count = 0;
 }
 
+//---------------------------------------------LED BAR SEQUENCES---------------------------------------------
+
+// CRC of the first count frames of a slot
+unsigned int seqCrc(const struct seqSlot *slot, unsigned char count) {
+    unsigned char i;
+
+    CRCINIRES = LED_CRC_SEED;
+    for (i = 0; i < count * LED_SEQ_FRAME_LEN; i++) {
+        CRCDI_L = slot->frames[i];
+    }
+    return CRCINIRES;
+}
+
+// Apply a sequence command at cmd, with avail bytes left in the frame; returns the bytes it
+// used, or 0 if it isn't a valid sequence command
+unsigned char seqCommand(unsigned char *cmd, unsigned char avail) {
+    struct seqSlot *slot;
+    unsigned char i;
+    unsigned char len;
+
+    if (avail < 2 || cmd[1] >= LED_SEQ_SLOTS) {
+        return 0;
+    }
+    slot = &seqSlots[cmd[1]];
+
+    switch (cmd[0]) {
+        case LED_CMD_SEQ_WRITE:
+            if (avail < 4) {
+                return 0;
+            }
+            len = 4 + cmd[3] * LED_SEQ_FRAME_LEN;
+            if (avail < len || cmd[2] + cmd[3] > LED_SEQ_MAX_FRAMES) {
+                return 0;
+            }
+            if ((pattern == &seqPattern || pattern == &vmPattern) && seqPlaying == slot) {
+                pattern = &offPattern;      // don't play or run a half-written slot
+            }
+            FRAM_WRITE_ENABLE();
+            slot->count = 0;
+            for (i = 4; i < len; i++) {
+                slot->frames[cmd[2] * LED_SEQ_FRAME_LEN + i - 4] = cmd[i];
+            }
+            FRAM_WRITE_DISABLE();
+            return len;
+
+        case LED_CMD_SEQ_COMMIT:
+            if (avail < 5 || cmd[2] == 0 || cmd[2] > LED_SEQ_MAX_FRAMES) {
+                return 0;
+            }
+            if (seqCrc(slot, cmd[2]) == (unsigned int)((cmd[3] << 8) | cmd[4])) {
+                FRAM_WRITE_ENABLE();
+                slot->crc = (cmd[3] << 8) | cmd[4];
+                slot->count = cmd[2];
+                FRAM_WRITE_DISABLE();
+            }
+            return 5;
+
+        case LED_CMD_SEQ_PLAY:
+        case LED_CMD_PROG_RUN:
+            // check the stored frames again, in case the upload never finished or FRAM was disturbed
+            if (slot->count != 0 && seqCrc(slot, slot->count) == slot->crc) {
+                savePosition();
+                seqPlaying = slot;
+                seqPattern.length = slot->count;
+                pattern = (cmd[0] == LED_CMD_SEQ_PLAY) ? &seqPattern : &vmPattern;
+                stepIndex = 0;
+                led_vm_reset(&vm);
+                TB1CCR0 = basePeriod;
+            }
+            return 2;
+    }
+    return 0;
+}
+
+// Show a frame of the playing sequence and hold it for its duration
+void showSequence(unsigned int step) {
+    const unsigned char *frame = &seqPlaying->frames[step * LED_SEQ_FRAME_LEN];
+    unsigned char duration = frame[1];
+
+    if (duration == 0) {
+        duration = 1;
+    } else if (duration > LED_SEQ_MAX_DURATION) {
+        duration = LED_SEQ_MAX_DURATION;
+    }
+    showBits(frame[0]);
+    TB1CCR0 = basePeriod * duration;
+}
+
+// Run the program in seqPlaying for one tick
+void showProgram(unsigned int step) {
+    (void)step;
+    if (led_vm_tick(&vm, seqPlaying->frames, seqPlaying->count)) {
+        showBits(vm.bits);
+    }
+}
+
 //---------------------------------------------LED BAR PATTERNS---------------------------------------------
 
+// Remember where the running pattern is, if it is a numbered one, for when it is selected again
+void savePosition() {
+    if (pattern == &patterns[prev_pattern]) {
+        stepOldIndex[prev_pattern] = stepIndex;
+    }
+}
+
+// Switch patterns, resuming a pattern where it left off, or restarting it if it is already running
+void selectPattern(unsigned char a) {
+    savePosition();
+    if (a < PATTERN_COUNT) {
+        stepIndex = (pattern == &patterns[a]) ? 0 : stepOldIndex[a];
+        prev_pattern = a;
+    }
+    setPattern(a);
+}
+
+void setupClock() {
+    // DCO at 8 MHz locked to REFO by the FLL; no FRAM wait states needed up to 8 MHz
+    __bis_SR_register(SCG0);                // disable FLL
+    CSCTL3 |= SELREF__REFOCLK;              // FLL reference is REFO
+    CSCTL0 = 0;                             // clear DCO and MOD
+    CSCTL1 = DCORSEL_3;                     // 8 MHz range
+    CSCTL2 = FLLD_0 + 243;                  // (243 + 1) * 32768 Hz
+    __delay_cycles(3);
+    __bic_SR_register(SCG0);                // enable FLL
+    while (CSCTL7 & (FLLUNLOCK0 | FLLUNLOCK1));
+    CSCTL4 = SELMS__DCOCLKDIV | SELA__REFOCLK;  // MCLK and SMCLK from the DCO, ACLK from REFO
+}
+
 void setupLeds() {
     // Configure Leds (P1.1, P1.0, P2.7, P2.6, P1.4, P1.5, P1.6, P1.7)
-    P1DIR |= BIT1 | BIT0 | BIT4 | BIT5 |BIT6 | BIT7;
-    P2DIR |= BIT7 | BIT6;
-    P1OUT &= ~(BIT1 | BIT0 | BIT4 | BIT5 |BIT6 | BIT7);
-    P2OUT &= ~(BIT7 | BIT6);
+    P1DIR |= LED_P1_PINS;
+    P2DIR |= LED_P2_PINS;
+    P1OUT &= ~LED_P1_PINS;
+    P2OUT &= ~LED_P2_PINS;
 
     // Setup Timer 0 B3
     TB1CTL = TBSSEL__ACLK | MC__UP | TBCLR | ID__8; // SMCLK (1Mhz), Stop mode, clear timer, divide by 8
     TB1EX0 = TBIDEX__8 ;   // Extra division by 4
     TB1CCR0 = basePeriod;  // Set initial speed
     TB1CCTL0 |= CCIE;      // Enable compare interrupt
+
+    // Timer_B0 paces the bit planes
+    TB0CTL = TBSSEL__SMCLK | MC__CONTINUOUS | TBCLR;
+    TB0CCR0 = BCM_LSB_TICKS;
+    TB0CCTL0 = CCIE;
 }
 
 void setPattern(int a) {
-    switch (a) {
-        case 10:    // dec base period
-            if (basePeriod > 32) {
-                basePeriod -= 32;
-            }
-            break;
+    if (a == 10) {              // dec base period
+        if (basePeriod > 32) {
+            basePeriod -= 32;
+        }
+    } else if (a == 11) {       // inc base period
+        if (basePeriod < 608) {
+            basePeriod += 32;
+        }
+    } else if (a >= 0 && a < PATTERN_COUNT) {
+        pattern = &patterns[a];
+    } else {
+        pattern = &offPattern;
+    }
 
-        case 11:    // inc base period
-            if (basePeriod < 608) {
-                basePeriod += 32;
-            }
-            break;
+    TB1CCR0 = basePeriod * pattern->multiplier;
+}
 
-        case 0:
-            stepStart = 0;
-            seqLength = 2;
-            patternMultiplier = 4;
-        break;
-        
-        case 1:
-            stepStart = 2;
-            seqLength = 2;
-            patternMultiplier = 4;
-        break;
-        
-        case 3:
-            stepStart = 4;
-            seqLength = 6;
-            patternMultiplier = 2;
-        break;
-        
-        case 5:
-            stepStart = 10;
-            seqLength = 8;
-            patternMultiplier = 6;
-        
-        case 6:
-            stepStart = 18;
-            seqLength = 8;
-            patternMultiplier = 2;
-        break;
-
-        case 7:
-            stepStart = 26;
-            seqLength = 8;
-            patternMultiplier = 4;
-        break;
+// Show an on/off frame at full brightness
+void showBits(unsigned char bits) {
+    struct ledFrame f = {LED_P1OUT(bits), LED_P2OUT(bits)};
+    unsigned char k;
 
-        default:
-            stepStart = 34;
-            seqLength = 2;
-            patternMultiplier = 4;
-        break;
+    for (k = 0; k < BCM_BITS; k++) {
+        bcmPlanes[k] = f;
     }
+}
 
-    TB1CCR0 = basePeriod * patternMultiplier;
-    
+unsigned char bitsRaw(unsigned int step) {
+    (void)step;
+    return rawBits;
+}
+
+// Show step phase of the fade: each LED follows a gamma-corrected triangle ramp, two steps
+// behind the one before it, so a wave of brightness runs along the bar
+void showFade(unsigned int phase) {
+    unsigned char bits[BCM_BITS] = {0};
+    unsigned char led = 1;
+    unsigned char k;
+    unsigned char plane;
+
+    while (led) {
+        unsigned char x = phase & 31;
+        unsigned char duty = fadeLevels[x < 16 ? x : 31 - x];
+        for (k = 0, plane = 1; k < BCM_BITS; k++, plane <<= 1) {
+            if (duty & plane) {
+                bits[k] |= led;
+            }
+        }
+        led <<= 1;
+        phase += 2;
+    }
+    for (k = 0; k < BCM_BITS; k++) {
+        bcmPlanes[k].p1 = LED_P1OUT(bits[k]);
+        bcmPlanes[k].p2 = LED_P2OUT(bits[k]);
+    }
 }
 
 #pragma vector = TIMER1_B0_VECTOR
 __interrupt void ISR_TB3_CCR0(void)
 {
-    // Update Leds (P1.1, P1.0, P2.7, P2.6, P1.4, P1.5, P1.6, P1.7)
-    P1OUT = ((stepSequence[stepIndex + stepStart] <<1 ) & 0b10) |
-            ((stepSequence[stepIndex + stepStart] >>1 ) & 0b1) |
-            ((stepSequence[stepIndex + stepStart]) & 0b10000) |
-            ((stepSequence[stepIndex + stepStart]) & 0b100000) |
-            ((stepSequence[stepIndex + stepStart]) & 0b1000000) |
-            ((stepSequence[stepIndex + stepStart]) & 0b10000000); // LSB (0) to P1.1 | 1 to P1.0 | 4 to P1.4 | 5 to P1.5 | 6 to P1.6 | 7 to P1.7
-    P2OUT = ((stepSequence[stepIndex + stepStart] <<5 ) & 0b10000000) |
-            ((stepSequence[stepIndex + stepStart] <<3 ) & 0b1000000);  // 2 to P2.7 | 3 to P2.6
-
-    stepIndex = (stepIndex + 1) % seqLength; // Update step index
+    // Load the next step into the bit planes; the BCM ISR puts them on the pins
+    if (pattern->bits) {
+        showBits(pattern->bits(stepIndex));
+    } else {
+        pattern->show(stepIndex);
+    }
+
+    if (++stepIndex >= pattern->length) {   // Update step index, no division
+        stepIndex = 0;
+    }
     TB1CCTL0 &= ~CCIFG;  // clear CCR0 IFG
-}
\ No newline at end of file
+}
+
+#pragma vector = TIMER0_B0_VECTOR
+__interrupt void ISR_TB0_CCR0(void)
+{
+    // Show the next bit plane for its weight; P2.0 is the heartbeat
+    const struct ledFrame *plane = &bcmPlanes[bcmPlane];
+    P1OUT = plane->p1;
+    P2OUT = (P2OUT & BIT0) | plane->p2;
+
+    TB0CCR0 += bcmTicks;
+    if ((int16_t)(TB0CCR0 - TB0R) < BCM_ISR_CYCLES) {   // held off by another ISR: don't wait out a timer wrap
+        TB0CCR0 = TB0R + BCM_ISR_CYCLES;
+    }
+    if (++bcmPlane < BCM_BITS) {
+        bcmTicks <<= 1;
+    } else {
+        bcmPlane = 0;
+        bcmTicks = BCM_LSB_TICKS;
+    }
+}
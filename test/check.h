@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @brief Minimal assertion helpers for the host tests.
+ *
+ * A failed check prints its location and the values involved and is counted;
+ * the test keeps going so one run reports every failure. Each test's main
+ * returns check_finish(), which is nonzero if anything failed.
+ */
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+static unsigned long check_failures;
+
+/** Check that cond holds */
+#define CHECK(cond)                                                                  \
+    do                                                                               \
+    {                                                                                \
+        if (!(cond))                                                                 \
+        {                                                                            \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            check_failures++;                                                        \
+        }                                                                            \
+    } while (0)
+
+/** Check that two integers are equal */
+#define CHECK_EQ(actual, expected)                                                                                \
+    do                                                                                                            \
+    {                                                                                                             \
+        long long check_a = (long long)(actual);                                                                  \
+        long long check_e = (long long)(expected);                                                                \
+        if (check_a != check_e)                                                                                   \
+        {                                                                                                         \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, check_a, check_e); \
+            check_failures++;                                                                                     \
+        }                                                                                                         \
+    } while (0)
+
+/**
+ * Report the result of a test.
+ *
+ * @param: name Test name for the summary line.
+ *
+ * @return: Exit status: 0 if every check passed.
+ */
+static int check_finish(const char *name)
+{
+    if (check_failures)
+    {
+        fprintf(stderr, "%s: %lu check(s) failed\n", name, check_failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+#endif // CHECK_H
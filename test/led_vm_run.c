@@ -0,0 +1,59 @@
+/**
+ * @file
+ * @brief Run an LED bar animation program on the host VM, printing what the bar shows.
+ *
+ * Usage: led_vm_run <ticks> <opcode><argument> ...
+ * with each instruction as four hex digits, e.g. 0005 for SET 5. The output
+ * has the same format as tools/led_asm.py --simulate, so the two can be
+ * compared line for line (see test_led_vm.py).
+ */
+#include "led_protocol.h"
+#include "led_vm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+    unsigned char program[LED_SEQ_MAX_FRAMES * LED_SEQ_FRAME_LEN];
+    unsigned char length = 0;
+    unsigned char shown = 0;
+    struct led_vm vm;
+    long ticks;
+    long tick;
+    int i;
+
+    if ((argc < 3) || (argc - 2 > LED_SEQ_MAX_FRAMES))
+    {
+        fprintf(stderr, "usage: %s <ticks> <opcode><argument> ...\n", argv[0]);
+        return 2;
+    }
+
+    ticks = strtol(argv[1], NULL, 10);
+    for (i = 2; i < argc; i++)
+    {
+        unsigned long ins = strtoul(argv[i], NULL, 16);
+        program[length * LED_SEQ_FRAME_LEN] = (unsigned char)(ins >> 8);
+        program[length * LED_SEQ_FRAME_LEN + 1] = (unsigned char)ins;
+        length++;
+    }
+
+    led_vm_reset(&vm);
+    for (tick = 0; tick < ticks; tick++)
+    {
+        // the bit planes keep the last bits shown through a WAIT
+        if (led_vm_tick(&vm, program, length))
+        {
+            shown = vm.bits;
+        }
+
+        // first LED on the left, as bit 0
+        printf("%4ld  ", tick);
+        for (i = 0; i < 8; i++)
+        {
+            putchar(((shown >> i) & 1) ? '#' : '.');
+        }
+        putchar('\n');
+    }
+    return 0;
+}
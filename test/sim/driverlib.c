@@ -0,0 +1,139 @@
+/**
+ * @file
+ * @brief driverlib functions on the simulated registers, as TI implements them.
+ */
+#include "driverlib.h"
+
+#define HWREG8(addr) SIM_SFR8(addr)
+#define HWREG16(addr) SIM_SFR16(addr)
+
+#define OFS_ADCCTL0 0x00
+#define OFS_ADCCTL1 0x02
+#define OFS_ADCCTL2 0x04
+#define OFS_ADCLO 0x06
+#define OFS_ADCHI 0x08
+#define OFS_ADCMCTL0 0x0A
+#define OFS_ADCIE 0x1A
+#define OFS_ADCIFG 0x1C
+#define OFS_CRCDI_L 0x00
+#define OFS_CRCINIRES 0x04
+#define OFS_MPY 0x00
+#define OFS_OP2 0x08
+#define OFS_MPY32CTL0_L 0x2C
+#define OFS_WDTCTL 0x00
+
+void ADC_init(uint16_t baseAddress, uint16_t sampleHoldSignalSourceSelect, uint8_t clockSourceSelect,
+              uint16_t clockSourceDivider)
+{
+    HWREG16(baseAddress + OFS_ADCCTL0) &= ~(ADCON + ADCENC + ADCSC);
+    HWREG16(baseAddress + OFS_ADCIE) &= 0x0000;
+    HWREG16(baseAddress + OFS_ADCIFG) &= 0x0000;
+
+    HWREG16(baseAddress + OFS_ADCCTL1) = sampleHoldSignalSourceSelect + (clockSourceDivider & ADCDIV_7) +
+                                         clockSourceSelect;
+    HWREG16(baseAddress + OFS_ADCCTL2) = (clockSourceDivider & ADCPDIV_3) + ADCRES_1;
+}
+
+void ADC_enable(uint16_t baseAddress)
+{
+    HWREG16(baseAddress + OFS_ADCCTL0) |= ADCON;
+}
+
+void ADC_setupSamplingTimer(uint16_t baseAddress, uint16_t clockCycleHoldCount, uint16_t multipleSamplesEnabled)
+{
+    HWREG16(baseAddress + OFS_ADCCTL1) |= ADCSHP;
+    HWREG16(baseAddress + OFS_ADCCTL0) &= ~(ADCSHT_15 + ADCMSC);
+    HWREG16(baseAddress + OFS_ADCCTL0) |= clockCycleHoldCount + multipleSamplesEnabled;
+}
+
+void ADC_setResolution(uint16_t baseAddress, uint8_t resolutionSelect)
+{
+    HWREG16(baseAddress + OFS_ADCCTL2) &= ~(ADCRES);
+    HWREG16(baseAddress + OFS_ADCCTL2) |= resolutionSelect;
+}
+
+void ADC_configureMemory(uint16_t baseAddress, uint8_t inputSourceSelect, uint8_t positiveRefVoltageSourceSelect,
+                         uint8_t negativeRefVoltageSourceSelect)
+{
+    if (!(HWREG16(baseAddress + OFS_ADCCTL0) & ADCENC))
+    {
+        HWREG16(baseAddress + OFS_ADCMCTL0) = inputSourceSelect + positiveRefVoltageSourceSelect +
+                                              negativeRefVoltageSourceSelect;
+    }
+}
+
+void ADC_enableInterrupt(uint16_t baseAddress, uint8_t interruptMask)
+{
+    HWREG16(baseAddress + OFS_ADCIE) |= interruptMask;
+}
+
+void ADC_disableInterrupt(uint16_t baseAddress, uint8_t interruptMask)
+{
+    HWREG16(baseAddress + OFS_ADCIE) &= ~(interruptMask);
+}
+
+void ADC_clearInterrupt(uint16_t baseAddress, uint8_t interruptFlagMask)
+{
+    HWREG16(baseAddress + OFS_ADCIFG) &= ~(interruptFlagMask);
+}
+
+void ADC_startConversion(uint16_t baseAddress, uint8_t conversionSequenceModeSelect)
+{
+    HWREG16(baseAddress + OFS_ADCCTL0) &= ~(ADCENC);
+    HWREG16(baseAddress + OFS_ADCCTL1) &= ~ADCCONSEQ;
+    HWREG16(baseAddress + OFS_ADCCTL1) |= conversionSequenceModeSelect;
+    HWREG16(baseAddress + OFS_ADCCTL0) |= ADCENC | ADCSC;
+}
+
+void ADC_setWindowComp(uint16_t baseAddress, uint16_t highThreshold, uint16_t lowThreshold)
+{
+    HWREG16(baseAddress + OFS_ADCHI) = highThreshold;
+    HWREG16(baseAddress + OFS_ADCLO) = lowThreshold;
+}
+
+void CRC_setSeed(uint16_t baseAddress, uint16_t seed)
+{
+    HWREG16(baseAddress + OFS_CRCINIRES) = seed;
+}
+
+void CRC_set8BitData(uint16_t baseAddress, uint8_t dataIn)
+{
+    HWREG8(baseAddress + OFS_CRCDI_L) = dataIn;
+}
+
+uint16_t CRC_getResult(uint16_t baseAddress)
+{
+    return HWREG16(baseAddress + OFS_CRCINIRES);
+}
+
+void MPY32_enableSaturationMode(void)
+{
+    HWREG8(MPY32_BASE + OFS_MPY32CTL0_L) |= MPYSAT;
+}
+
+void MPY32_enableFractionalMode(void)
+{
+    HWREG8(MPY32_BASE + OFS_MPY32CTL0_L) |= MPYFRAC;
+}
+
+void MPY32_setOperandOne16Bit(uint8_t multiplicationType, uint16_t operand)
+{
+    HWREG16(MPY32_BASE + OFS_MPY + multiplicationType) = operand;
+}
+
+void MPY32_setOperandTwo16Bit(uint16_t operand)
+{
+    HWREG16(MPY32_BASE + OFS_OP2) = operand;
+}
+
+void PMM_unlockLPM5(void)
+{
+    PM5CTL0 &= ~LOCKLPM5;
+}
+
+void WDT_A_hold(uint16_t baseAddress)
+{
+    uint8_t newWDTStatus = ((HWREG16(baseAddress + OFS_WDTCTL) & 0x00FF) | WDTHOLD);
+
+    HWREG16(baseAddress + OFS_WDTCTL) = WDTPW + newWDTStatus;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file
+ * @brief The driverlib API the firmware uses, on the simulated registers.
+ *
+ * TI's driverlib reaches registers through HWREG16(base + offset), which
+ * hw_memmap.h defines as a dereference of the device address, so it can't
+ * be built for the host. driverlib.c reimplements the functions the
+ * firmware calls with the same register writes, in the same order, against
+ * the simulated register file. Constants have driverlib's values.
+ */
+#ifndef DRIVERLIB_H
+#define DRIVERLIB_H
+
+#include "sim_sfr.h"
+#include <stdint.h>
+
+//-- Module base addresses
+#define ADC_BASE 0x0700
+#define CRC_BASE 0x01C0
+#define MPY32_BASE 0x04C0
+#define WDT_A_BASE 0x01CC
+
+//-- ADC
+#define ADC_SAMPLEHOLDSOURCE_SC (ADCSHS_0)
+#define ADC_SAMPLEHOLDSOURCE_2 (ADCSHS_2)
+#define ADC_CLOCKSOURCE_ADCOSC (ADCSSEL_0)
+#define ADC_CLOCKDIVIDER_1 (ADCDIV_0 + ADCPDIV_0)
+#define ADC_MULTIPLESAMPLESDISABLE (!(ADCMSC))
+#define ADC_CYCLEHOLD_16_CYCLES (ADCSHT_2)
+#define ADC_VREFPOS_AVCC (!(ADCSREF0 + ADCSREF1))
+#define ADC_VREFNEG_AVSS (!(ADCSREF2))
+#define ADC_ABOVETHRESHOLD_INTERRUPT (ADCHIIE)
+#define ADC_BELOWTHRESHOLD_INTERRUPT (ADCLOIE)
+#define ADC_INSIDEWINDOW_INTERRUPT (ADCINIE)
+#define ADC_COMPLETED_INTERRUPT (ADCIE0)
+#define ADC_ABOVETHRESHOLD_INTERRUPT_FLAG (ADCHIIFG)
+#define ADC_BELOWTHRESHOLD_INTERRUPT_FLAG (ADCLOIFG)
+#define ADC_INSIDEWINDOW_INTERRUPT_FLAG (ADCINIFG)
+#define ADC_COMPLETED_INTERRUPT_FLAG (ADCIFG0)
+#define ADC_SINGLECHANNEL (ADCCONSEQ_0)
+#define ADC_REPEATED_SINGLECHANNEL (ADCCONSEQ_2)
+#define ADC_RESOLUTION_12BIT (0x20)
+
+void ADC_init(uint16_t baseAddress, uint16_t sampleHoldSignalSourceSelect, uint8_t clockSourceSelect,
+              uint16_t clockSourceDivider);
+void ADC_enable(uint16_t baseAddress);
+void ADC_setupSamplingTimer(uint16_t baseAddress, uint16_t clockCycleHoldCount, uint16_t multipleSamplesEnabled);
+void ADC_setResolution(uint16_t baseAddress, uint8_t resolutionSelect);
+void ADC_configureMemory(uint16_t baseAddress, uint8_t inputSourceSelect, uint8_t positiveRefVoltageSourceSelect,
+                         uint8_t negativeRefVoltageSourceSelect);
+void ADC_enableInterrupt(uint16_t baseAddress, uint8_t interruptMask);
+void ADC_disableInterrupt(uint16_t baseAddress, uint8_t interruptMask);
+void ADC_clearInterrupt(uint16_t baseAddress, uint8_t interruptFlagMask);
+void ADC_startConversion(uint16_t baseAddress, uint8_t conversionSequenceModeSelect);
+void ADC_setWindowComp(uint16_t baseAddress, uint16_t highThreshold, uint16_t lowThreshold);
+
+//-- CRC
+void CRC_setSeed(uint16_t baseAddress, uint16_t seed);
+void CRC_set8BitData(uint16_t baseAddress, uint8_t dataIn);
+uint16_t CRC_getResult(uint16_t baseAddress);
+
+//-- MPY32
+#define MPY32_MULTIPLY_SIGNED (0x02)
+#define MPY32_MULTIPLYACCUMULATE_SIGNED (0x06)
+
+void MPY32_enableSaturationMode(void);
+void MPY32_enableFractionalMode(void);
+void MPY32_setOperandOne16Bit(uint8_t multiplicationType, uint16_t operand);
+void MPY32_setOperandTwo16Bit(uint16_t operand);
+
+//-- PMM and WDT_A
+void PMM_unlockLPM5(void);
+void WDT_A_hold(uint16_t baseAddress);
+
+#endif // DRIVERLIB_H
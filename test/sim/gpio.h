@@ -0,0 +1,10 @@
+/**
+ * @file
+ * @brief driverlib's gpio.h; the firmware drives its pins through the port registers.
+ */
+#ifndef GPIO_H
+#define GPIO_H
+
+#include "driverlib.h"
+
+#endif // GPIO_H
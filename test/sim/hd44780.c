@@ -0,0 +1,223 @@
+/**
+ * @file
+ * @brief HD44780 model: bus protocol, execution times and DDRAM of a 16x2 display.
+ *
+ * The controller latches a write on the falling edge of E, taking RS and RW
+ * from P3 and the data from P2; on the 4-bit bus each byte is two nibbles on
+ * D4-D7, high first, once a function set has selected 4-bit mode. Reads put
+ * the busy flag and address counter on the data pins while E is high. Times
+ * are the datasheet's at the nominal 270 kHz oscillator: 37 us per
+ * instruction or character and 1.52 ms for clear display and return home,
+ * after a 40 ms power-on reset. Only the instructions the driver uses are
+ * modelled beyond their busy time; display shift and CGRAM are not.
+ */
+#include "hd44780.h"
+
+#include "sim_internal.h"
+#include <string.h>
+
+#define RS BIT0
+#define RW BIT1
+#define E BIT2
+
+#define EXEC_TIME SIM_US(37)
+#define HOME_TIME SIM_US(1520)
+#define POWER_ON_TIME SIM_MS(40)
+
+// DDRAM of a 2-line display: 0x00-0x27 and 0x40-0x67
+#define LINE_LEN 0x28
+#define LINE2 0x40
+
+static bool wired_4bit;         // only D4-D7 are connected
+static bool mode_4bit;          // interface set to 4 bits by a function set
+static bool low_nibble;         // next 4-bit transfer is the low nibble
+static uint8_t high_nibble;     // high nibble of a 4-bit write
+static bool increment;
+static uint8_t ac;              // address counter
+static uint8_t ddram[0x80];
+static sim_time busy_until;
+static uint8_t p3;              // last levels on RS, RW and E
+static struct hd44780_stats stats;
+
+static bool busy(void)
+{
+    return sim_clock < busy_until;
+}
+
+static void ac_step(void)
+{
+    if (increment)
+    {
+        ac++;
+        if (ac == LINE_LEN)
+        {
+            ac = LINE2;
+        }
+        else if (ac == LINE2 + LINE_LEN)
+        {
+            ac = 0;
+        }
+    }
+    else
+    {
+        if (ac == 0)
+        {
+            ac = LINE2 + LINE_LEN - 1;
+        }
+        else if (ac == LINE2)
+        {
+            ac = LINE_LEN - 1;
+        }
+        else
+        {
+            ac--;
+        }
+    }
+}
+
+static void execute(bool rs, uint8_t value)
+{
+    sim_time time = EXEC_TIME;
+
+    if (busy())
+    {
+        stats.busy_writes++;
+        return;
+    }
+
+    if (rs)
+    {
+        ddram[ac] = value;
+        ac_step();
+        stats.data_writes++;
+    }
+    else
+    {
+        stats.instructions++;
+        if (value & 0x80)
+        {
+            ac = value & 0x7F;          // set DDRAM address
+        }
+        else if (value & 0x40)
+        {
+            // set CGRAM address: not modelled
+        }
+        else if (value & 0x20)
+        {
+            mode_4bit = !(value & 0x10);    // function set; lines and font are taken as 2 and 5x8
+            low_nibble = false;
+        }
+        else if ((value & 0x1C) == 0x04)
+        {
+            increment = value & 0x02;   // entry mode set
+        }
+        else if (value == 0x01)
+        {
+            memset(ddram, ' ', sizeof(ddram));
+            ac = 0;
+            increment = true;
+            time = HOME_TIME;
+        }
+        else if ((value & 0xFE) == 0x02)
+        {
+            ac = 0;
+            time = HOME_TIME;
+        }
+    }
+    busy_until = sim_clock + time;
+    stats.last_done = busy_until;
+}
+
+static uint8_t bus_value(void)
+{
+    return (busy() ? 0x80 : 0) | ac;
+}
+
+// The levels the controller drives on P2 while a read has E high
+static uint8_t data_pins(unsigned port, uint8_t *driven)
+{
+    uint8_t value = bus_value();
+
+    (void)port;
+    *driven = 0;
+    if ((p3 & (RW | E)) != (RW | E))
+    {
+        return 0;
+    }
+    if (wired_4bit)
+    {
+        *driven = 0xF0;
+        return low_nibble ? (uint8_t)(value << 4) : (value & 0xF0);
+    }
+    *driven = 0xFF;
+    return value;
+}
+
+// E, RS and RW on P3
+static void control(unsigned port, uint8_t out, uint8_t dir)
+{
+    uint8_t old = p3;
+    uint8_t data;
+
+    (void)port;
+    (void)dir;
+    p3 = out & (RS | RW | E);
+    if (!(old & E) || (p3 & E))
+    {
+        return;         // only the falling edge of E does anything
+    }
+
+    if (old & RW)
+    {
+        stats.reads++;
+        if (mode_4bit)
+        {
+            low_nibble = !low_nibble;
+        }
+        return;
+    }
+
+    // the bus as the controller sees it: unconnected data pins read low
+    data = sim_port_out(2) & (wired_4bit ? 0xF0 : 0xFF);
+
+    if (!mode_4bit)
+    {
+        execute(old & RS, data);
+    }
+    else if (!low_nibble)
+    {
+        high_nibble = data & 0xF0;
+        low_nibble = true;
+    }
+    else
+    {
+        low_nibble = false;
+        execute(old & RS, high_nibble | (data >> 4));
+    }
+}
+
+void hd44780_attach(bool four_bit)
+{
+    wired_4bit = four_bit;
+    mode_4bit = false;
+    low_nibble = false;
+    increment = true;
+    ac = 0;
+    memset(ddram, ' ', sizeof(ddram));
+    busy_until = sim_now() + POWER_ON_TIME;
+    p3 = 0;
+    memset(&stats, 0, sizeof(stats));
+    sim_port_wire(2, data_pins, 0);
+    sim_port_wire(3, 0, control);
+}
+
+void hd44780_row(unsigned row, char text[17])
+{
+    memcpy(text, &ddram[row ? LINE2 : 0], 16);
+    text[16] = '\0';
+}
+
+const struct hd44780_stats *hd44780_stats(void)
+{
+    return &stats;
+}
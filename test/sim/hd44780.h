@@ -0,0 +1,56 @@
+/**
+ * @file
+ * @brief HD44780 character LCD on the LCD node's bus: RS, RW and E on P3.0-P3.2, data on P2.
+ */
+#ifndef HD44780_H
+#define HD44780_H
+
+#include "sim.h"
+#include <stdbool.h>
+
+/**
+ * Counts of what the controller was sent
+ */
+struct hd44780_stats
+{
+    /** Instructions executed */
+    unsigned long instructions;
+
+    /** Characters written to DDRAM */
+    unsigned long data_writes;
+
+    /** Bus reads (busy flag and address) */
+    unsigned long reads;
+
+    /** Writes that arrived while the controller was busy, and were lost */
+    unsigned long busy_writes;
+
+    /** When the last instruction or data write finished executing */
+    sim_time last_done;
+};
+
+/**
+ * Power the controller on and wire it to ports 2 and 3. It stays busy for
+ * its 40 ms power-on reset.
+ *
+ * @param: four_bit true if only D4-D7 are connected, to P2.4-P2.7; otherwise
+ *         D0-D7 are on P2.0-P2.7.
+ */
+void hd44780_attach(bool four_bit);
+
+/**
+ * The characters a row of a 16x2 display shows.
+ *
+ * @param: row 0 for the top row, 1 for the bottom.
+ * @param: text Filled in with the 16 characters and a NUL.
+ */
+void hd44780_row(unsigned row, char text[17]);
+
+/**
+ * What the controller has been sent since hd44780_attach().
+ *
+ * @return: The counts.
+ */
+const struct hd44780_stats *hd44780_stats(void);
+
+#endif // HD44780_H
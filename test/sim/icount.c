@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief Instruction counts of host code by single-stepping it under ptrace.
+ */
+#define _GNU_SOURCE     // ptrace requests
+
+#include "icount.h"
+
+#include <signal.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int availability = -1;           // -1 until checked
+static unsigned long overhead = 0;      // steps counted around an empty call
+
+// Steps from one SIGSTOP of the child to the next, or -1 if the child can't be traced
+static long steps(void (*fn)(void *arg), void *arg)
+{
+    pid_t pid = fork();
+    long count = 0;
+    int status;
+
+    if (pid < 0)
+    {
+        return -1;
+    }
+    if (pid == 0)
+    {
+        if (ptrace(PTRACE_TRACEME, 0, 0, 0) != 0)
+        {
+            _exit(1);
+        }
+        raise(SIGSTOP);
+        fn(arg);
+        raise(SIGSTOP);
+        _exit(0);
+    }
+
+    if ((waitpid(pid, &status, 0) != pid) || !WIFSTOPPED(status))
+    {
+        return -1;
+    }
+    for (;;)
+    {
+        if ((ptrace(PTRACE_SINGLESTEP, pid, 0, 0) != 0) || (waitpid(pid, &status, 0) != pid) ||
+            !WIFSTOPPED(status))
+        {
+            count = -1;
+            break;
+        }
+        if (WSTOPSIG(status) == SIGSTOP)
+        {
+            break;
+        }
+        if (WSTOPSIG(status) != SIGTRAP)
+        {
+            count = -1;
+            break;
+        }
+        count++;
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, &status, 0);
+    return count;
+}
+
+static void empty(void *arg)
+{
+    (void)arg;
+}
+
+bool icount_available(void)
+{
+    if (availability < 0)
+    {
+        long base = steps(empty, 0);
+
+        availability = (base >= 0);
+        overhead = (base >= 0) ? (unsigned long)base : 0;
+    }
+    return availability;
+}
+
+unsigned long icount(void (*fn)(void *arg), void *arg)
+{
+    long count;
+
+    if (!icount_available())
+    {
+        return 0;
+    }
+    count = steps(fn, arg);
+    return ((count < 0) || ((unsigned long)count < overhead)) ? 0 : (unsigned long)count - overhead;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file
+ * @brief Instruction counts of host code, for cost checks that don't depend on timing.
+ *
+ * The function is run in a forked copy of the test under ptrace and
+ * single-stepped, so the count is exact and the same on every run, whatever
+ * else the machine is doing. It counts the host's instructions, not MSP430
+ * cycles: a check built on it shows how a cost scales (flat as a window
+ * grows, a fraction of another implementation's) rather than what it is on
+ * the device. Tests link with -z now so that no lazy symbol binding lands in
+ * a count.
+ */
+#ifndef ICOUNT_H
+#define ICOUNT_H
+
+#include <stdbool.h>
+
+/**
+ * Whether instructions can be counted here; ptrace may be forbidden, as in
+ * some containers, and a test then skips its cost checks.
+ *
+ * @return: true if icount() works.
+ */
+bool icount_available(void);
+
+/**
+ * Count the instructions a call executes.
+ *
+ * @param: fn Function to call; it runs in a child process, so nothing it
+ *         changes is seen by the caller.
+ * @param: arg Passed to fn.
+ *
+ * @return: User-space instructions executed by fn(arg), or 0 if they can't be counted.
+ */
+unsigned long icount(void (*fn)(void *arg), void *arg);
+
+#endif // ICOUNT_H
@@ -0,0 +1,46 @@
+/**
+ * @file
+ * @brief Compiler intrinsics of the MSP430 toolchains, on the simulated CPU.
+ *
+ * The status register is the simulator's: setting CPUOFF sleeps until an
+ * ISR clears it on exit, and __delay_cycles lets simulated time pass with
+ * interrupts serviced as they come due.
+ */
+#ifndef INTRINSICS_H
+#define INTRINSICS_H
+
+#include "sim_sfr.h"
+
+/** @see __delay_cycles */
+void sim_delay_cycles(unsigned long cycles);
+
+/** @see __bis_SR_register */
+void sim_bis_sr(uint16_t bits);
+
+/** @see __bic_SR_register */
+void sim_bic_sr(uint16_t bits);
+
+/** @see __bis_SR_register_on_exit */
+void sim_bis_sr_on_exit(uint16_t bits);
+
+/** @see __bic_SR_register_on_exit */
+void sim_bic_sr_on_exit(uint16_t bits);
+
+/** @see __get_SR_register */
+uint16_t sim_get_sr(void);
+
+#define __interrupt
+#define __delay_cycles(cycles) sim_delay_cycles(cycles)
+#define __bis_SR_register(bits) sim_bis_sr(bits)
+#define __bic_SR_register(bits) sim_bic_sr(bits)
+#define __bis_SR_register_on_exit(bits) sim_bis_sr_on_exit(bits)
+#define __bic_SR_register_on_exit(bits) sim_bic_sr_on_exit(bits)
+#define __get_SR_register() sim_get_sr()
+#define __enable_interrupt() sim_bis_sr(GIE)
+#define __disable_interrupt() sim_bic_sr(GIE)
+#define __get_interrupt_state() ((unsigned short)(sim_get_sr() & GIE))
+#define __set_interrupt_state(state) ((state) ? sim_bis_sr(GIE) : sim_bic_sr(GIE))
+#define __even_in_range(value, bound) (value)
+#define __no_operation() sim_delay_cycles(1)
+
+#endif // INTRINSICS_H
@@ -0,0 +1,119 @@
+/**
+ * @file
+ * @brief The central board's 4x4 key matrix, on P1.4-P1.7 (columns) and P2.0-P2.3 (rows).
+ *
+ * A pressed key connects its column to its row, so a row reads the level of
+ * the column driving it and is otherwise left to its pull resistor. Only
+ * the direct paths are modelled, not the ghost keys of three held corners.
+ */
+#include "key_matrix.h"
+
+#include "sim_internal.h"
+#include <string.h>
+
+#define CHANGES 64
+
+// Key k is column k / 4 (P1.4 + k / 4) and row k % 4 (P2.0 + k % 4), as in keypad.c
+static const char keys[] = "123A456B789C*0#D";
+
+static uint16_t down = 0;
+
+/**
+ * A key change waiting for its time
+ */
+struct change
+{
+    /** Key index */
+    unsigned key;
+
+    /** Press or release */
+    bool down;
+
+    /** Slot in use */
+    bool used;
+};
+
+static struct change changes[CHANGES];
+
+static unsigned key_index(char key)
+{
+    const char *p = strchr(keys, key);
+
+    if (!key || !p)
+    {
+        sim_fail("no key '%c'", key);
+    }
+    return (unsigned)(p - keys);
+}
+
+static uint8_t rows(unsigned port, uint8_t *driven)
+{
+    uint8_t cols = sim_port_out(1);
+    uint8_t col_dir = sim_port_dir(1);
+    uint8_t level = 0;
+    unsigned k;
+
+    (void)port;
+    *driven = 0;
+    for (k = 0; k < 16; k++)
+    {
+        uint8_t col = BIT4 << (k / 4);
+
+        if ((down & (1u << k)) && (col_dir & col))
+        {
+            *driven |= 1 << (k % 4);
+            if (cols & col)
+            {
+                level |= 1 << (k % 4);
+            }
+        }
+    }
+    return level;
+}
+
+void key_matrix_attach(void)
+{
+    down = 0;
+    memset(changes, 0, sizeof(changes));
+    sim_port_wire(2, rows, 0);
+}
+
+void key_matrix_set(char key, bool pressed)
+{
+    unsigned k = key_index(key);
+
+    if (pressed)
+    {
+        down |= 1u << k;
+    }
+    else
+    {
+        down &= ~(1u << k);
+    }
+}
+
+static void apply(void *arg)
+{
+    struct change *c = arg;
+
+    key_matrix_set(keys[c->key], c->down);
+    c->used = false;
+}
+
+void key_matrix_set_at(sim_time when, char key, bool pressed)
+{
+    unsigned i;
+
+    for (i = 0; i < CHANGES; i++)
+    {
+        if (!changes[i].used)
+        {
+            changes[i].key = key_index(key);
+            changes[i].down = pressed;
+            changes[i].used = true;
+            sim_at(when, apply, &changes[i]);
+            return;
+        }
+    }
+    sim_fail("more than %d key changes scheduled", CHANGES);
+}
@@ -0,0 +1,33 @@
+/**
+ * @file
+ * @brief The central board's 4x4 key matrix, on P1.4-P1.7 (columns) and P2.0-P2.3 (rows).
+ */
+#ifndef KEY_MATRIX_H
+#define KEY_MATRIX_H
+
+#include "sim.h"
+#include <stdbool.h>
+
+/**
+ * Wire the matrix to port 2, with every key up.
+ */
+void key_matrix_attach(void);
+
+/**
+ * Press or release a key now.
+ *
+ * @param: key Key character, as keypad.h names it.
+ * @param: down true to press it.
+ */
+void key_matrix_set(char key, bool down);
+
+/**
+ * Press or release a key at a point in simulated time.
+ *
+ * @param: when Time of the change.
+ * @param: key Key character.
+ * @param: down true to press it.
+ */
+void key_matrix_set_at(sim_time when, char key, bool down);
+
+#endif // KEY_MATRIX_H
@@ -0,0 +1,14 @@
+/**
+ * @file
+ * @brief Simulated device header, selected as msp430.h selects TI's.
+ */
+#ifndef MSP430_H
+#define MSP430_H
+
+#if defined(__MSP430FR2310__)
+#include "msp430fr2310.h"
+#else
+#include "msp430fr2355.h"
+#endif
+
+#endif // MSP430_H
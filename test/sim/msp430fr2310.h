@@ -0,0 +1,15 @@
+/**
+ * @file
+ * @brief Simulated MSP430FR2310: the LED bar MCU. It has no MPY32.
+ */
+#ifndef MSP430FR2310_H
+#define MSP430FR2310_H
+
+#ifndef __MSP430FR2310__
+#define __MSP430FR2310__
+#endif
+
+#include "intrinsics.h"
+#include "sim_sfr.h"
+
+#endif // MSP430FR2310_H
@@ -0,0 +1,16 @@
+/**
+ * @file
+ * @brief Simulated MSP430FR2355: the central and LCD node MCU.
+ */
+#ifndef MSP430FR2355_H
+#define MSP430FR2355_H
+
+#ifndef __MSP430FR2355__
+#define __MSP430FR2355__
+#endif
+#define __MSP430_HAS_MPY32__
+
+#include "intrinsics.h"
+#include "sim_sfr.h"
+
+#endif // MSP430FR2355_H
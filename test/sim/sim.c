@@ -0,0 +1,827 @@
+/**
+ * @file
+ * @brief Simulator core: register file, clock, CPU status register, interrupts and ports.
+ */
+#define _GNU_SOURCE     // ucontext
+
+#include "sim_internal.h"
+
+#include "intrinsics.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#define PORTS 6
+#define EVENTS 64
+#define IMAGE_STACK_SIZE (256 * 1024)
+
+// Vectors are kept by their offset below the top of the vector table
+#define VECTOR_INDEX(vector) ((0xFFFE - (vector)) >> 1)
+#define VECTORS 64
+
+// Port registers: ports pair up in 0x20-byte blocks from 0x0200, odd ports at the even address
+#define PORT_REG(port, offset) REG8(0x0200 + (((port) - 1) >> 1) * 0x20 + (((port) - 1) & 1) + (offset))
+#define PORT_IN 0x00
+#define PORT_OUT 0x02
+#define PORT_DIR 0x04
+#define PORT_REN 0x06
+#define PORT_SEL0 0x0A
+#define PORT_SEL1 0x0C
+#define PORT_IES 0x18
+#define PORT_IE 0x1A
+#define PORT_IFG 0x1C
+#define PORT_IV_ADDR(port) (0x0200 + (((port) - 1) >> 1) * 0x20 + 0x0E + (((port) - 1) & 1) * 0x10)
+
+// Registers a write to which is an action rather than a value: the models act on each write
+#define ADDR_CRCDI 0x01C0
+#define ADDR_CRCDIRB 0x01C2
+#define ADDR_CRCINIRES 0x01C4
+#define ADDR_CRCRESR 0x01C6
+#define ADDR_MPY 0x04C0
+#define ADDR_OP2 0x04C8
+#define ADDR_UCB0TXBUF 0x054E
+
+#define CRC_POLY 0x1021
+
+union sim_regs sim_regs;
+sim_time sim_clock;
+
+/**
+ * A call scheduled with sim_at()
+ */
+struct event
+{
+    /** When to call it */
+    sim_time when;
+
+    /** Function, 0 for a free slot */
+    void (*fn)(void *arg);
+
+    /** Its argument */
+    void *arg;
+};
+
+/**
+ * Board connections and the last state the models were told about for one port
+ */
+struct port
+{
+    /** External drivers, or 0 */
+    uint8_t (*pins)(unsigned port, uint8_t *driven);
+
+    /** Output watcher, or 0 */
+    void (*outputs)(unsigned port, uint8_t out, uint8_t dir);
+
+    /** PxOUT & PxDIR last passed to outputs */
+    uint8_t out;
+
+    /** PxDIR last passed to outputs */
+    uint8_t dir;
+};
+
+static bool powered = false;
+static uint16_t sr = 0;
+static uint16_t isr_frames[8];              // SR saved by each ISR being run, innermost last
+static unsigned isr_depth = 0;
+static void (*vectors[VECTORS])(void);
+static unsigned long isr_counts[VECTORS];
+static sim_time isr_times[VECTORS];
+static unsigned long wakeups = 0;
+static sim_time active_time = 0;
+static unsigned long accesses = 0;
+static struct event events[EVENTS];
+static struct port ports[PORTS + 1];
+static uint16_t pending_addr = 0;           // action register written by the last access, 0 for none
+static unsigned pending_width = 0;
+
+// MPY32 operand one and the operation its address selected
+static uint16_t mpy_operand;
+static uint16_t mpy_operation;
+
+// The image and the test each run on their own stack
+static ucontext_t test_context;
+static ucontext_t image_context;
+static void *image_stack = 0;
+static int (*image_main)(void) = 0;
+static bool image_running = false;          // executing on the image's stack
+static bool image_returned = false;
+static sim_time run_deadline = 0;
+
+void sim_fail(const char *format, ...)
+{
+    va_list args;
+
+    fprintf(stderr, "sim: at %.3f ms: ", sim_clock / 1e9);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+    abort();
+}
+
+sim_time sim_mclk_period(void)
+{
+    uint32_t hz = ((REG16(0x0184) & FLLN) + 1) * SIM_ACLK_HZ;
+
+    return 1000000000000ULL / hz;
+}
+
+sim_time sim_smclk_period(void)
+{
+    return (sr & SCG1) ? 0 : sim_mclk_period();
+}
+
+//-- Ports
+
+// Recompute the inputs from the board and the pull resistors, and flag edges
+static void ports_refresh(void)
+{
+    unsigned port;
+
+    for (port = 1; port <= PORTS; port++)
+    {
+        uint8_t dir = PORT_REG(port, PORT_DIR);
+        uint8_t out = PORT_REG(port, PORT_OUT);
+        uint8_t driven = 0;
+        uint8_t ext = ports[port].pins ? ports[port].pins(port, &driven) : 0;
+        uint8_t pulled = ~dir & ~driven & PORT_REG(port, PORT_REN);
+        uint8_t old = PORT_REG(port, PORT_IN);
+        uint8_t in = (out & dir) | (ext & driven & ~dir) | (out & pulled);
+
+        PORT_REG(port, PORT_IN) = in;
+        if (port <= 4)
+        {
+            uint8_t ies = PORT_REG(port, PORT_IES);
+            uint8_t gpio = ~(PORT_REG(port, PORT_SEL0) | PORT_REG(port, PORT_SEL1));
+            uint8_t rising = ~old & in & ~ies;
+            uint8_t falling = old & ~in & ies;
+
+            PORT_REG(port, PORT_IFG) |= (rising | falling) & gpio;
+        }
+    }
+}
+
+// Tell the board about changed outputs
+static void ports_sync(void)
+{
+    unsigned port;
+
+    for (port = 1; port <= PORTS; port++)
+    {
+        uint8_t dir = PORT_REG(port, PORT_DIR);
+        uint8_t out = PORT_REG(port, PORT_OUT) & dir;
+
+        if ((out != ports[port].out) || (dir != ports[port].dir))
+        {
+            ports[port].out = out;
+            ports[port].dir = dir;
+            if (ports[port].outputs)
+            {
+                ports[port].outputs(port, out, dir);
+            }
+        }
+    }
+    ports_refresh();
+}
+
+// Highest pending enabled port flag, as PxIV reads it, which it clears
+static void port_iv_read(unsigned port)
+{
+    uint8_t pending = PORT_REG(port, PORT_IFG) & PORT_REG(port, PORT_IE);
+    uint16_t iv = 0;
+    unsigned pin;
+
+    for (pin = 0; pin < 8; pin++)
+    {
+        if (pending & (1 << pin))
+        {
+            iv = 2 * (pin + 1);
+            PORT_REG(port, PORT_IFG) &= ~(1 << pin);
+            break;
+        }
+    }
+    REG16(PORT_IV_ADDR(port)) = iv;
+}
+
+void sim_port_wire(unsigned port, uint8_t (*pins)(unsigned port, uint8_t *driven),
+                   void (*outputs)(unsigned port, uint8_t out, uint8_t dir))
+{
+    if ((port < 1) || (port > PORTS))
+    {
+        sim_fail("no port %u", port);
+    }
+    ports[port].pins = pins;
+    ports[port].outputs = outputs;
+    if (outputs)
+    {
+        outputs(port, ports[port].out, ports[port].dir);
+    }
+    ports_refresh();
+}
+
+uint8_t sim_port_out(unsigned port)
+{
+    return PORT_REG(port, PORT_OUT) & PORT_REG(port, PORT_DIR);
+}
+
+uint8_t sim_port_dir(unsigned port)
+{
+    return PORT_REG(port, PORT_DIR);
+}
+
+//-- CRC16 and MPY32, which act on each write
+
+static uint16_t crc_bit(uint16_t crc, unsigned bit)
+{
+    unsigned feedback = ((crc >> 15) ^ bit) & 1;
+
+    crc <<= 1;
+    return feedback ? crc ^ CRC_POLY : crc;
+}
+
+// CRCDI feeds each byte LSB first, CRCDIRB MSB first, into the CCITT shift register
+static uint16_t crc_byte(uint16_t crc, uint8_t byte, bool reversed)
+{
+    unsigned i;
+
+    for (i = 0; i < 8; i++)
+    {
+        crc = crc_bit(crc, reversed ? byte >> (7 - i) : byte >> i);
+    }
+    return crc;
+}
+
+static uint16_t bit_reverse16(uint16_t x)
+{
+    uint16_t r = 0;
+    unsigned i;
+
+    for (i = 0; i < 16; i++)
+    {
+        r = (r << 1) | ((x >> i) & 1);
+    }
+    return r;
+}
+
+uint16_t sim_crc16(uint16_t seed, const uint8_t *data, unsigned len)
+{
+    while (len--)
+    {
+        seed = crc_byte(seed, *data++, false);
+    }
+    return seed;
+}
+
+static void crc_write(uint16_t addr, unsigned width)
+{
+    uint16_t crc = REG16(ADDR_CRCINIRES);
+    bool reversed = (addr == ADDR_CRCDIRB);
+
+    crc = crc_byte(crc, REG8(addr), reversed);
+    if (width == 2)
+    {
+        crc = crc_byte(crc, REG8(addr + 1), reversed);
+    }
+    REG16(ADDR_CRCINIRES) = crc;
+    REG16(ADDR_CRCRESR) = bit_reverse16(crc);
+}
+
+// Follows the MPY32 chapter of the FR2xx user's guide for the signed 16 x 16 operations: writing
+// OP2 starts the operation; fractional mode doubles the product; multiply-accumulate adds it to
+// the 32-bit RESHI:RESLO; with saturation on, a result that overflowed reads as the nearest 32-bit
+// limit. The device clips on read and keeps the raw sum, while this model clips the registers
+// themselves, which reads the same as long as nothing is accumulated after an overflow.
+static void mpy_op2_write(void)
+{
+    uint16_t ctl = REG16(0x04EC);
+    int64_t result = (int64_t)(int16_t)mpy_operand * (int16_t)REG16(ADDR_OP2);
+
+    if ((mpy_operation != 0x02) && (mpy_operation != 0x06))
+    {
+        sim_fail("MPY32: only signed 16-bit MPYS and MACS are modelled");
+    }
+    if (ctl & MPYFRAC)
+    {
+        result *= 2;
+    }
+    if (mpy_operation == 0x06)
+    {
+        result += (int32_t)(((uint32_t)REG16(0x04CC) << 16) | REG16(0x04CA));
+    }
+    if (ctl & MPYSAT)
+    {
+        if (result > INT32_MAX)
+        {
+            result = INT32_MAX;
+        }
+        else if (result < INT32_MIN)
+        {
+            result = INT32_MIN;
+        }
+    }
+    REG16(0x04CA) = (uint16_t)result;
+    REG16(0x04CC) = (uint16_t)((uint64_t)result >> 16);
+}
+
+// Act on the action register the last access wrote, now that the write has happened
+static void flush_pending(void)
+{
+    uint16_t addr = pending_addr;
+
+    pending_addr = 0;
+    switch (addr)
+    {
+        case 0:
+            break;
+
+        case ADDR_CRCDI:
+        case ADDR_CRCDIRB:
+            crc_write(addr, pending_width);
+            break;
+
+        case ADDR_OP2:
+            mpy_op2_write();
+            break;
+
+        case ADDR_UCB0TXBUF:
+            sim_i2c_tx_written();
+            break;
+
+        default:
+            mpy_operand = REG16(addr);
+            mpy_operation = addr - ADDR_MPY;
+            break;
+    }
+}
+
+//-- Time and interrupts
+
+static void sync(void)
+{
+    flush_pending();
+    sim_timer_sync();
+    sim_adc_sync();
+    sim_i2c_sync();
+    ports_sync();
+}
+
+// Vector of the highest-priority enabled pending interrupt, 0 for none
+static uint16_t pending_vector(void)
+{
+    unsigned n;
+    unsigned port;
+
+    for (n = 0; n < 4; n++)
+    {
+        uint16_t base = 0x0380 + 0x40 * n;
+        unsigned ccrs = (n == 3) ? 7 : 3;
+        unsigned k;
+
+        if ((REG16(base + 2) & (CCIE | CCIFG)) == (CCIE | CCIFG))
+        {
+            return TIMER0_B0_VECTOR - 4 * n;
+        }
+        if ((REG16(base) & (TBIE | TBIFG)) == (TBIE | TBIFG))
+        {
+            return TIMER0_B1_VECTOR - 4 * n;
+        }
+        for (k = 1; k < ccrs; k++)
+        {
+            if ((REG16(base + 2 + 2 * k) & (CCIE | CCIFG)) == (CCIE | CCIFG))
+            {
+                return TIMER0_B1_VECTOR - 4 * n;
+            }
+        }
+    }
+    if (REG16(0x056A) & REG16(0x056C))
+    {
+        return EUSCI_B0_VECTOR;
+    }
+    for (port = 1; port <= 4; port++)
+    {
+        if (PORT_REG(port, PORT_IE) & PORT_REG(port, PORT_IFG))
+        {
+            return PORT1_VECTOR - 2 * (port - 1);
+        }
+    }
+    if (REG16(0x071A) & REG16(0x071C) & 0x003F)
+    {
+        return ADC_VECTOR;
+    }
+    return 0;
+}
+
+static sim_time min_time(sim_time a, sim_time b)
+{
+    return (a < b) ? a : b;
+}
+
+static void yield_to_test(void)
+{
+    image_running = false;
+    swapcontext(&image_context, &test_context);
+    image_running = true;
+}
+
+// Move time to the next event, or to until if none comes first, and handle what is due
+static void advance_one(sim_time until)
+{
+    sim_time next = until;
+    unsigned i;
+
+    if (image_running)
+    {
+        next = min_time(next, run_deadline);
+    }
+    next = min_time(next, sim_timer_next());
+    next = min_time(next, sim_adc_next());
+    next = min_time(next, sim_i2c_next());
+    for (i = 0; i < EVENTS; i++)
+    {
+        if (events[i].fn)
+        {
+            next = min_time(next, events[i].when);
+        }
+    }
+    if (next < sim_clock)
+    {
+        next = sim_clock;
+    }
+
+    if (!(sr & CPUOFF))
+    {
+        active_time += next - sim_clock;
+    }
+    sim_clock = next;
+    sim_timer_advance(sim_clock);
+    sim_adc_advance(sim_clock);
+    sim_i2c_advance(sim_clock);
+    for (i = 0; i < EVENTS; i++)
+    {
+        if (events[i].fn && (events[i].when <= sim_clock))
+        {
+            void (*fn)(void *arg) = events[i].fn;
+
+            events[i].fn = 0;
+            fn(events[i].arg);
+        }
+    }
+    ports_sync();
+
+    if (image_running && (sim_clock >= run_deadline))
+    {
+        yield_to_test();
+    }
+}
+
+static void step(sim_time until);
+
+// Run the ISRs of pending interrupts while interrupts are enabled
+static void dispatch(void)
+{
+    uint16_t vector;
+
+    while ((sr & GIE) && ((vector = pending_vector()) != 0))
+    {
+        unsigned index = VECTOR_INDEX(vector);
+        void (*isr)(void) = vectors[index];
+        sim_time start = sim_clock;
+        uint16_t saved = sr;
+
+        if (!isr)
+        {
+            sim_fail("interrupt 0x%04X is pending but has no ISR", vector);
+        }
+        if (isr_depth == sizeof(isr_frames) / sizeof(isr_frames[0]))
+        {
+            sim_fail("ISRs nested too deeply");
+        }
+
+        // single-source CCR0 vectors clear their flag on entry
+        if ((vector <= TIMER0_B0_VECTOR) && (vector >= TIMER3_B0_VECTOR) && !((TIMER0_B0_VECTOR - vector) & 2))
+        {
+            REG16(0x0382 + 0x40 * ((TIMER0_B0_VECTOR - vector) / 4)) &= ~CCIFG;
+        }
+
+        isr_frames[isr_depth++] = saved;
+        sr &= SCG0;
+        isr_counts[index]++;
+        step(sim_clock + SIM_ISR_ENTRY_CYCLES * sim_mclk_period());
+        isr();
+        sync();
+        step(sim_clock + SIM_ISR_EXIT_CYCLES * sim_mclk_period());
+        sr = isr_frames[--isr_depth];
+        isr_times[index] += sim_clock - start;
+        if ((saved & CPUOFF) && !(sr & CPUOFF))
+        {
+            wakeups++;
+        }
+    }
+}
+
+// Run with the CPU awake until the given time
+static void step(sim_time until)
+{
+    dispatch();
+    while (sim_clock < until)
+    {
+        advance_one(until);
+        dispatch();
+    }
+}
+
+// Sleep until an ISR clears CPUOFF, or until the given time
+static void sleep_while_off(sim_time until)
+{
+    dispatch();
+    while ((sr & CPUOFF) && (sim_clock < until))
+    {
+        advance_one(until);
+        dispatch();
+    }
+}
+
+// Bring the models up to date at a call from the firmware
+static void enter(void)
+{
+    if (!powered)
+    {
+        sim_reset();
+    }
+    sync();
+}
+
+static void access(uint16_t addr, unsigned width)
+{
+    if ((addr >= SIM_REGS_SIZE) || ((width == 2) && (addr & 1)))
+    {
+        sim_fail("no SFR at 0x%04X", addr);
+    }
+    enter();
+    accesses++;
+    step(sim_clock + SIM_ACCESS_CYCLES * sim_mclk_period());
+    sync();
+
+    // read side effects, on the registers the firmware only reads
+    if ((addr >= 0x0200) && (addr < 0x0260) && ((addr & 0x1F) < 2))
+    {
+        ports_refresh();
+    }
+    else if ((addr >= 0x0200) && (addr < 0x0260) && (((addr & 0x1F) == 0x0E) || ((addr & 0x1F) == 0x1E)))
+    {
+        port_iv_read(((addr - 0x0200) >> 5) * 2 + (((addr & 0x1F) == 0x1E) ? 2 : 1));
+    }
+    sim_timer_read(addr);
+    sim_adc_read(addr);
+    sim_i2c_read(addr);
+
+    // action registers take effect at the next call, once the firmware has written them
+    if ((addr == ADDR_CRCDI) || (addr == ADDR_CRCDIRB) || (addr == ADDR_UCB0TXBUF) ||
+        ((addr >= ADDR_MPY) && (addr <= ADDR_OP2)))
+    {
+        pending_addr = addr;
+        pending_width = width;
+    }
+}
+
+volatile uint8_t *sim_sfr8(uint16_t addr)
+{
+    access(addr, 1);
+    return &REG8(addr);
+}
+
+volatile uint16_t *sim_sfr16(uint16_t addr)
+{
+    access(addr, 2);
+    return &REG16(addr);
+}
+
+//-- Intrinsics
+
+void sim_delay_cycles(unsigned long cycles)
+{
+    enter();
+    step(sim_clock + cycles * sim_mclk_period());
+}
+
+void sim_bis_sr(uint16_t bits)
+{
+    enter();
+    sr |= bits;
+    sleep_while_off(SIM_NEVER);
+}
+
+void sim_bic_sr(uint16_t bits)
+{
+    enter();
+    sr &= ~bits;
+}
+
+void sim_bis_sr_on_exit(uint16_t bits)
+{
+    if (isr_depth == 0)
+    {
+        sim_fail("__bis_SR_register_on_exit outside an ISR");
+    }
+    isr_frames[isr_depth - 1] |= bits;
+}
+
+void sim_bic_sr_on_exit(uint16_t bits)
+{
+    if (isr_depth == 0)
+    {
+        sim_fail("__bic_SR_register_on_exit outside an ISR");
+    }
+    isr_frames[isr_depth - 1] &= ~bits;
+}
+
+uint16_t sim_get_sr(void)
+{
+    return sr;
+}
+
+//-- Test interface
+
+void sim_reset(void)
+{
+    unsigned port;
+
+    if (image_running)
+    {
+        sim_fail("sim_reset from the image");
+    }
+    free(image_stack);
+    image_stack = 0;
+    image_main = 0;
+    image_returned = false;
+
+    powered = true;
+    memset(&sim_regs, 0, sizeof(sim_regs));
+    REG16(0x0130) = LOCKLPM5;
+    REG16(0x0160) = DFWP | PFWP;
+    REG16(0x01CC) = 0x6904;
+    REG16(0x0182) = 0x0033;
+    REG16(0x0184) = 0x101F;
+    REG16(0x0540) = 0x01C1;
+
+    sim_clock = 0;
+    sr = 0;
+    isr_depth = 0;
+    memset(vectors, 0, sizeof(vectors));
+    memset(isr_counts, 0, sizeof(isr_counts));
+    memset(isr_times, 0, sizeof(isr_times));
+    wakeups = 0;
+    active_time = 0;
+    accesses = 0;
+    memset(events, 0, sizeof(events));
+    for (port = 0; port <= PORTS; port++)
+    {
+        ports[port].pins = 0;
+        ports[port].outputs = 0;
+        ports[port].out = 0;
+        ports[port].dir = 0;
+    }
+    pending_addr = 0;
+    mpy_operand = 0;
+    mpy_operation = 0;
+
+    sim_timer_reset();
+    sim_adc_reset();
+    sim_i2c_reset();
+}
+
+void sim_vector(uint16_t vector, void (*isr)(void))
+{
+    if (!powered)
+    {
+        sim_reset();
+    }
+    if ((vector < 0xFFFE - 2 * (VECTORS - 1)) || (vector & 1))
+    {
+        sim_fail("no vector 0x%04X", vector);
+    }
+    vectors[VECTOR_INDEX(vector)] = isr;
+}
+
+sim_time sim_now(void)
+{
+    return sim_clock;
+}
+
+unsigned long sim_mclk_hz(void)
+{
+    return ((REG16(0x0184) & FLLN) + 1) * SIM_ACLK_HZ;
+}
+
+void sim_at(sim_time when, void (*fn)(void *arg), void *arg)
+{
+    unsigned i;
+
+    if (!powered)
+    {
+        sim_reset();
+    }
+    for (i = 0; i < EVENTS; i++)
+    {
+        if (!events[i].fn)
+        {
+            events[i].when = when;
+            events[i].fn = fn;
+            events[i].arg = arg;
+            return;
+        }
+    }
+    sim_fail("more than %d events scheduled", EVENTS);
+}
+
+void sim_sleep(uint16_t lpm_bits, sim_time duration)
+{
+    sim_time until;
+    uint16_t saved;
+
+    enter();
+    until = sim_clock + duration;
+    saved = sr;
+    while (sim_clock < until)
+    {
+        sr |= lpm_bits | GIE;
+        sleep_while_off(until);
+    }
+    sr = saved;
+}
+
+static void image_entry(void)
+{
+    image_running = true;
+    image_main();
+    image_returned = true;
+    image_running = false;
+}
+
+void sim_boot(int (*main_fn)(void))
+{
+    if (!powered)
+    {
+        sim_reset();
+    }
+    if (image_main)
+    {
+        sim_fail("an image is already loaded");
+    }
+    image_stack = malloc(IMAGE_STACK_SIZE);
+    if (!image_stack)
+    {
+        sim_fail("out of memory");
+    }
+    getcontext(&image_context);
+    image_context.uc_stack.ss_sp = image_stack;
+    image_context.uc_stack.ss_size = IMAGE_STACK_SIZE;
+    image_context.uc_link = &test_context;
+    makecontext(&image_context, image_entry, 0);
+    image_main = main_fn;
+}
+
+void sim_run(sim_time duration)
+{
+    if (!image_main)
+    {
+        sim_fail("sim_run with no image loaded");
+    }
+    if (image_returned)
+    {
+        sim_fail("the image's main returned");
+    }
+    run_deadline = sim_clock + duration;
+    swapcontext(&test_context, &image_context);
+    if (image_returned)
+    {
+        sim_fail("the image's main returned");
+    }
+}
+
+unsigned long sim_wakeups(void)
+{
+    return wakeups;
+}
+
+sim_time sim_active_time(void)
+{
+    return active_time;
+}
+
+unsigned long sim_isr_count(uint16_t vector)
+{
+    return isr_counts[VECTOR_INDEX(vector)];
+}
+
+sim_time sim_isr_time(uint16_t vector)
+{
+    return isr_times[VECTOR_INDEX(vector)];
+}
+
+unsigned long sim_sfr_accesses(void)
+{
+    return accesses;
+}
@@ -0,0 +1,279 @@
+/**
+ * @file
+ * @brief Host simulator for the MSP430 firmware: register file, clock and interrupts.
+ *
+ * Firmware built with test/sim first on the include path gets the
+ * simulator's msp430fr2355.h, msp430fr2310.h, intrinsics.h and driverlib.h
+ * instead of TI's. Their registers live in a simulated register file (see
+ * sim_sfr.h) backed by models of the peripherals the firmware uses:
+ *
+ * - Timer_B0-B3: up and continuous modes from ACLK or SMCLK, compare flags,
+ *   and the TBn.1 reset/set output as an ADC trigger;
+ * - the ADC: timer- or software-triggered conversions of a board input, the
+ *   window comparator and ADCIV;
+ * - eUSCI_B0 in I2C mode: master transmit with automatic STOP, NACKs and a
+ *   log of every transfer, or slave receive from transfers the test sends;
+ * - digital I/O: pin levels from board models, pull resistors and edge
+ *   interrupts;
+ * - the CRC16 and MPY32 modules and the DCO frequency set through CSCTL2.
+ *
+ * Time is kept in picoseconds. The CPU's own instructions take no time,
+ * except that each SFR access costs SIM_ACCESS_CYCLES, each interrupt
+ * SIM_ISR_ENTRY_CYCLES plus SIM_ISR_EXIT_CYCLES, and __delay_cycles what it
+ * asks for; everything else is driven by peripheral events. A CPU in a
+ * low-power mode jumps straight to the next event, so seconds of sleep cost
+ * microseconds of host time. LPM3 and deeper stop SMCLK, and with it the
+ * I2C master and any SMCLK timer (peripheral clock requests are not
+ * modelled).
+ *
+ * ISRs are plain functions: `#pragma vector` means nothing to the host
+ * compiler, so each test attaches the ones it needs with sim_vector(). A
+ * whole firmware image runs on its own stack: sim_boot() takes its main (built
+ * with -Dmain=<name>) and sim_run() lets it run for a stretch of simulated
+ * time. Tests that call firmware functions directly instead use sim_sleep()
+ * to let time pass with the CPU asleep.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Simulated time in picoseconds */
+typedef uint64_t sim_time;
+
+#define SIM_NS(ns) ((sim_time)(ns) * 1000ULL)
+#define SIM_US(us) ((sim_time)(us) * 1000000ULL)
+#define SIM_MS(ms) ((sim_time)(ms) * 1000000000ULL)
+
+/** ACLK from REFO */
+#define SIM_ACLK_HZ 32768UL
+
+/** MCLK cycles charged for each SFR access, about one instruction with an absolute operand */
+#define SIM_ACCESS_CYCLES 3
+
+/** MCLK cycles to take an interrupt, from the FR2xx user's guide */
+#define SIM_ISR_ENTRY_CYCLES 6
+
+/** MCLK cycles of RETI */
+#define SIM_ISR_EXIT_CYCLES 5
+
+/** Largest transfer the I2C log keeps the bytes of */
+#define SIM_I2C_MAX_LEN 64
+
+/**
+ * Power on: registers take their reset values, the clock restarts at 0,
+ * every model, board connection, vector and scheduled event is cleared and
+ * any booted image is dropped.
+ */
+void sim_reset(void);
+
+/**
+ * Attach an ISR to an interrupt vector.
+ *
+ * @param: vector A *_VECTOR value from sim_sfr.h.
+ * @param: isr Function to call, or 0 to detach.
+ */
+void sim_vector(uint16_t vector, void (*isr)(void));
+
+/**
+ * Current simulated time.
+ *
+ * @return: Picoseconds since sim_reset().
+ */
+sim_time sim_now(void);
+
+/**
+ * MCLK frequency, set by CSCTL2 as the FLL would lock it.
+ *
+ * @return: MCLK (and SMCLK) in Hz.
+ */
+unsigned long sim_mclk_hz(void);
+
+/**
+ * Call fn(arg) at a point in simulated time, between CPU steps, so board
+ * models can change inputs on a schedule.
+ *
+ * @param: when Time to call it; a time already past calls it at the next step.
+ * @param: fn Function to call.
+ * @param: arg Passed to fn.
+ */
+void sim_at(sim_time when, void (*fn)(void *arg), void *arg);
+
+/**
+ * Let time pass with the CPU in a low-power mode and interrupts enabled,
+ * for tests that drive firmware modules directly. ISRs run as they come due;
+ * one that wakes the CPU is counted by sim_wakeups() and the CPU goes back
+ * to sleep.
+ *
+ * @param: lpm_bits LPM0_bits, LPM3_bits, ...
+ * @param: duration How long.
+ */
+void sim_sleep(uint16_t lpm_bits, sim_time duration);
+
+/**
+ * Load a firmware image to run on its own stack. It starts on the first
+ * sim_run(). The test must not touch SFRs itself while an image is loaded.
+ *
+ * @param: image_main The image's main, built with -Dmain=<name>.
+ */
+void sim_boot(int (*image_main)(void));
+
+/**
+ * Run the booted image until duration of simulated time has passed.
+ *
+ * @param: duration How long.
+ */
+void sim_run(sim_time duration);
+
+/**
+ * Number of times an ISR returned to a CPU it had woken from a low-power mode.
+ *
+ * @return: Wake-ups since sim_reset().
+ */
+unsigned long sim_wakeups(void);
+
+/**
+ * Time the CPU was running rather than in a low-power mode, ISRs included.
+ *
+ * @return: Active time since sim_reset().
+ */
+sim_time sim_active_time(void);
+
+/**
+ * Number of times a vector's ISR has run.
+ *
+ * @param: vector A *_VECTOR value.
+ *
+ * @return: Count since sim_reset().
+ */
+unsigned long sim_isr_count(uint16_t vector);
+
+/**
+ * Time spent in a vector's ISR, entry and exit included.
+ *
+ * @param: vector A *_VECTOR value.
+ *
+ * @return: Total since sim_reset().
+ */
+sim_time sim_isr_time(uint16_t vector);
+
+/**
+ * Number of SFR accesses so far, to count the register traffic of a piece
+ * of firmware.
+ *
+ * @return: Count since sim_reset().
+ */
+unsigned long sim_sfr_accesses(void);
+
+/**
+ * Connect a board model to a port.
+ *
+ * @param: port Port number, 1-6.
+ * @param: pins Returns the levels external circuits drive on the port's
+ *         pins and sets *driven to the pins they drive; undriven input pins
+ *         read their pull resistor, or 0. May be 0.
+ * @param: outputs Told the port's output levels (PxOUT & PxDIR) and PxDIR
+ *         whenever the firmware changes either. May be 0.
+ */
+void sim_port_wire(unsigned port, uint8_t (*pins)(unsigned port, uint8_t *driven),
+                   void (*outputs)(unsigned port, uint8_t out, uint8_t dir));
+
+/**
+ * Levels the firmware drives on a port, for board models.
+ *
+ * @param: port Port number, 1-6.
+ *
+ * @return: PxOUT & PxDIR.
+ */
+uint8_t sim_port_out(unsigned port);
+
+/**
+ * Direction of a port's pins, for board models.
+ *
+ * @param: port Port number, 1-6.
+ *
+ * @return: PxDIR.
+ */
+uint8_t sim_port_dir(unsigned port);
+
+/**
+ * Connect the analog input the ADC converts.
+ *
+ * @param: input Returns the 12-bit code the ideal converter would give for
+ *         an input channel at the current time; called at the start of each
+ *         conversion.
+ */
+void sim_adc_wire(uint16_t (*input)(unsigned channel));
+
+/**
+ * One transfer on the I2C bus
+ */
+struct sim_i2c_transfer
+{
+    /** 7-bit slave address */
+    uint8_t addr;
+
+    /** true if the address was not acknowledged; no data followed */
+    bool nacked;
+
+    /** Data bytes sent */
+    uint16_t len;
+
+    /** The first SIM_I2C_MAX_LEN of them */
+    uint8_t data[SIM_I2C_MAX_LEN];
+
+    /** When the STOP completed, 0 while in progress */
+    sim_time end;
+};
+
+/**
+ * Number of transfers the firmware's I2C master has started.
+ *
+ * @return: Count since sim_reset().
+ */
+unsigned sim_i2c_count(void);
+
+/**
+ * A transfer from the firmware's I2C master.
+ *
+ * @param: n Index, 0 for the first since sim_reset().
+ *
+ * @return: The transfer; valid until sim_reset().
+ */
+const struct sim_i2c_transfer *sim_i2c_transfer(unsigned n);
+
+/**
+ * Make the next address phases to a slave go unacknowledged, as if it
+ * were missing or busy.
+ *
+ * @param: addr 7-bit slave address.
+ * @param: count Number of address phases to NACK.
+ */
+void sim_i2c_nack(uint8_t addr, unsigned count);
+
+/**
+ * As an external 100 kHz master, write bytes to the firmware's I2C slave
+ * and run the booted image until the STOP has been sent.
+ *
+ * @param: addr 7-bit slave address.
+ * @param: data Bytes to write.
+ * @param: len Number of bytes: [1, SIM_I2C_MAX_LEN].
+ *
+ * @return: false if the slave didn't acknowledge its address.
+ */
+bool sim_i2c_send(uint8_t addr, const uint8_t *data, uint8_t len);
+
+/**
+ * The CRC16 module's result for a buffer fed through CRCDI_L, computed
+ * without touching the module.
+ *
+ * @param: seed Value written to CRCINIRES first.
+ * @param: data Bytes to feed.
+ * @param: len Number of bytes.
+ *
+ * @return: CRCINIRES after the last byte.
+ */
+uint16_t sim_crc16(uint16_t seed, const uint8_t *data, unsigned len);
+
+#endif // SIM_H
@@ -0,0 +1,158 @@
+/**
+ * @file
+ * @brief ADC model: triggered single-channel conversions, the window comparator and ADCIV.
+ *
+ * A conversion starts on ADCSC (ADCSHS 0) or on a rising edge of the timer
+ * output ADCSHS selects, samples the board's input for the channel in
+ * ADCMCTL0 and completes SHT_2 plus 14 ADC clocks later, on a 4.8 MHz MODOSC.
+ * Only the single-channel sequences are modelled: single conversion needs
+ * ADCENC toggled before the next, repeat single channel takes every trigger.
+ */
+#include "sim_internal.h"
+
+#define ADC_CTL0 REG16(0x0700)
+#define ADC_CTL1 REG16(0x0702)
+#define ADC_CTL2 REG16(0x0704)
+#define ADC_LO REG16(0x0706)
+#define ADC_HI REG16(0x0708)
+#define ADC_MCTL0 REG16(0x070A)
+#define ADC_MEM0 REG16(0x0712)
+#define ADC_IE REG16(0x071A)
+#define ADC_IFG REG16(0x071C)
+#define ADC_IV REG16(0x071E)
+
+// 16 ADC clocks of sampling and 14 of conversion at 4.8 MHz
+#define CONVERSION_TIME SIM_NS(6250)
+
+static uint16_t (*input)(unsigned channel) = 0;
+static bool converting = false;
+static sim_time done = 0;
+static uint16_t result = 0;
+static bool single_done = false;    // a single conversion has run since ADCENC was set
+
+static void start(void)
+{
+    unsigned shift = 4 - 2 * ((ADC_CTL2 & ADCRES) >> 4);
+    uint16_t code = input ? input(ADC_MCTL0 & ADCINCH) : 0;
+
+    if ((ADC_CTL1 & ADCCONSEQ) != ADCCONSEQ_0 && (ADC_CTL1 & ADCCONSEQ) != ADCCONSEQ_2)
+    {
+        sim_fail("ADC: only single-channel sequences are modelled");
+    }
+    if (code > 4095)
+    {
+        code = 4095;
+    }
+    result = code >> shift;
+    converting = true;
+    done = sim_clock + CONVERSION_TIME;
+    ADC_CTL1 |= ADCBUSY;
+    if ((ADC_CTL1 & ADCCONSEQ) == ADCCONSEQ_0)
+    {
+        single_done = true;
+    }
+}
+
+static void complete(void)
+{
+    converting = false;
+    ADC_CTL1 &= ~ADCBUSY;
+    ADC_MEM0 = result;
+    if (ADC_IFG & ADCIFG0)
+    {
+        ADC_IFG |= ADCOVIFG;
+    }
+    ADC_IFG |= ADCIFG0;
+    if (result > ADC_HI)
+    {
+        ADC_IFG |= ADCHIIFG;
+    }
+    else if (result < ADC_LO)
+    {
+        ADC_IFG |= ADCLOIFG;
+    }
+    else
+    {
+        ADC_IFG |= ADCINIFG;
+    }
+}
+
+void sim_adc_wire(uint16_t (*fn)(unsigned channel))
+{
+    input = fn;
+}
+
+void sim_adc_trigger(unsigned source)
+{
+    if (!(ADC_CTL0 & ADCON) || !(ADC_CTL0 & ADCENC) || converting || single_done)
+    {
+        return;
+    }
+    if (((ADC_CTL1 & ADCSHS) >> 10) == source)
+    {
+        start();
+    }
+}
+
+void sim_adc_reset(void)
+{
+    input = 0;
+    converting = false;
+    single_done = false;
+}
+
+void sim_adc_sync(void)
+{
+    if (!(ADC_CTL0 & ADCON))
+    {
+        converting = false;
+        ADC_CTL1 &= ~ADCBUSY;
+    }
+    if (!(ADC_CTL0 & ADCENC))
+    {
+        single_done = false;
+    }
+    if (ADC_CTL0 & ADCSC)
+    {
+        ADC_CTL0 &= ~ADCSC;
+        sim_adc_trigger(0);
+    }
+}
+
+sim_time sim_adc_next(void)
+{
+    return converting ? done : SIM_NEVER;
+}
+
+void sim_adc_advance(sim_time t)
+{
+    if (converting && (done <= t))
+    {
+        complete();
+    }
+}
+
+void sim_adc_read(uint16_t addr)
+{
+    if (addr == 0x0712)
+    {
+        ADC_IFG &= ~ADCIFG0;
+    }
+    else if (addr == 0x071E)
+    {
+        static const uint16_t order[] = {ADCOVIFG, ADCTOVIFG, ADCHIIFG, ADCLOIFG, ADCINIFG, ADCIFG0};
+        uint16_t pending = ADC_IE & ADC_IFG;
+        unsigned i;
+
+        ADC_IV = ADCIV_NONE;
+        for (i = 0; i < sizeof(order) / sizeof(order[0]); i++)
+        {
+            if (pending & order[i])
+            {
+                ADC_IV = 2 * (i + 1);
+                ADC_IFG &= ~order[i];
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,455 @@
+/**
+ * @file
+ * @brief eUSCI_B0 I2C model: master transmitter with automatic STOP, and slave receiver.
+ *
+ * Master: UCTXSTT sends START and the address from UCB0I2CSA at SMCLK /
+ * UCB0BRW per bit, setting UCTXIFG0 straight away so the first byte can be
+ * loaded. A slave set up with sim_i2c_nack() doesn't acknowledge: UCNACKIFG
+ * is set and the bus is held until the firmware sets UCTXSTP. Otherwise each
+ * byte takes nine bit times, with UCTXIFG0 set as it moves out of UCB0TXBUF
+ * while more are to come, and SCL held low while UCB0TXBUF is empty. With
+ * UCASTP_2 a STOP follows byte UCB0TBCNT, setting UCSTPIFG and UCBCNTIFG;
+ * the firmware relies on UCSTPIFG after its own STOP, as the device sets it
+ * once the STOP is on the bus. Every transfer is logged.
+ *
+ * Slave: sim_i2c_send() plays an external 100 kHz master. An address
+ * matching UCB0I2COA0 with UCOAEN is acknowledged and sets UCSTTIFG; each
+ * byte then sets UCRXIFG0, with SCL held low while the previous byte is
+ * still unread, and the STOP sets UCSTPIFG.
+ *
+ * UCSWRST clears the flags and abandons a transfer. Reading UCB0IV returns
+ * the highest-priority enabled flag and clears it.
+ */
+#include "sim_internal.h"
+
+#define UCB_CTLW0 REG16(0x0540)
+#define UCB_CTLW1 REG16(0x0542)
+#define UCB_BRW REG16(0x0546)
+#define UCB_STATW REG16(0x0548)
+#define UCB_TBCNT REG16(0x054A)
+#define UCB_RXBUF REG16(0x054C)
+#define UCB_TXBUF REG16(0x054E)
+#define UCB_I2COA0 REG16(0x0554)
+#define UCB_I2CSA REG16(0x0560)
+#define UCB_IE REG16(0x056A)
+#define UCB_IFG REG16(0x056C)
+#define UCB_IV REG16(0x056E)
+
+#define UCASTP_MASK 0x000C
+#define EXTERNAL_BIT_TIME SIM_US(10)
+#define LOG_LEN 4096
+#define NACK_SLOTS 8
+
+enum i2c_state
+{
+    IDLE,
+    MASTER_ADDR,        // START and address on the bus
+    MASTER_BYTE,        // a data byte on the bus
+    MASTER_HOLD,        // waiting for UCB0TXBUF
+    MASTER_NACKED,      // address NACKed, waiting for UCTXSTP
+    MASTER_STOP,        // STOP on the bus
+    SLAVE_ADDR,
+    SLAVE_BYTE,
+    SLAVE_HOLD,         // byte received, waiting for UCB0RXBUF to be read
+    SLAVE_STOP,
+};
+
+static enum i2c_state state = IDLE;
+static sim_time phase_end = 0;              // when the bus phase in progress ends
+static sim_time last_advance = 0;
+static bool tx_full = false;                // UCB0TXBUF written and not yet on the bus
+static uint8_t shift = 0;                   // byte on the bus
+static unsigned sent = 0;                   // bytes sent in the current master transfer
+static struct sim_i2c_transfer log[LOG_LEN];
+static unsigned log_count = 0;
+static struct sim_i2c_transfer *current = 0;
+static struct
+{
+    uint8_t addr;
+    unsigned count;
+} nacks[NACK_SLOTS];
+
+// external master's transfer, for sim_i2c_send
+static struct sim_i2c_transfer incoming;
+static bool incoming_queued = false;
+static bool incoming_done = false;
+static unsigned rx_index = 0;
+static bool rx_released = false;            // UCB0RXBUF read while holding
+
+static sim_time bit_time(void)
+{
+    return UCB_BRW * sim_smclk_period();
+}
+
+static bool is_master(void)
+{
+    return (state >= MASTER_ADDR) && (state <= MASTER_STOP);
+}
+
+static bool auto_stop(void)
+{
+    return (UCB_CTLW1 & UCASTP_MASK) == UCASTP_2;
+}
+
+static bool take_nack(uint8_t addr)
+{
+    unsigned i;
+
+    for (i = 0; i < NACK_SLOTS; i++)
+    {
+        if ((nacks[i].count != 0) && (nacks[i].addr == addr))
+        {
+            nacks[i].count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Move UCB0TXBUF onto the bus, or hold SCL until it is written
+static void load_byte(void)
+{
+    if (!tx_full)
+    {
+        state = MASTER_HOLD;
+        return;
+    }
+    shift = (uint8_t)UCB_TXBUF;
+    tx_full = false;
+    state = MASTER_BYTE;
+    phase_end = sim_clock + 9 * bit_time();
+    if (!auto_stop() || (sent + 1 < UCB_TBCNT))
+    {
+        UCB_IFG |= UCTXIFG0;
+    }
+}
+
+static void master_stop(void)
+{
+    state = MASTER_STOP;
+    phase_end = sim_clock + 2 * bit_time();
+}
+
+static void slave_deliver(void)
+{
+    UCB_RXBUF = incoming.data[rx_index++];
+    UCB_IFG |= UCRXIFG0;
+    if (rx_index < incoming.len)
+    {
+        state = SLAVE_BYTE;
+        phase_end = sim_clock + 9 * EXTERNAL_BIT_TIME;
+    }
+    else
+    {
+        state = SLAVE_STOP;
+        phase_end = sim_clock + 2 * EXTERNAL_BIT_TIME;
+    }
+}
+
+static void finish_incoming(void)
+{
+    incoming.end = sim_clock;
+    incoming_done = true;
+    state = IDLE;
+}
+
+// Handle the end of the bus phase in progress
+static void phase_done(void)
+{
+    switch (state)
+    {
+        case MASTER_ADDR:
+            UCB_CTLW0 &= ~UCTXSTT;
+            if (take_nack(current->addr))
+            {
+                current->nacked = true;
+                UCB_IFG = (UCB_IFG & ~UCTXIFG0) | UCNACKIFG;
+                tx_full = false;
+                state = MASTER_NACKED;
+            }
+            else
+            {
+                load_byte();
+            }
+            break;
+
+        case MASTER_BYTE:
+            if (current->len < SIM_I2C_MAX_LEN)
+            {
+                current->data[current->len] = shift;
+            }
+            current->len++;
+            sent++;
+            if ((auto_stop() && (sent == UCB_TBCNT)) || (UCB_CTLW0 & UCTXSTP))
+            {
+                master_stop();
+            }
+            else
+            {
+                load_byte();
+            }
+            break;
+
+        case MASTER_STOP:
+            UCB_IFG |= UCSTPIFG;
+            if (auto_stop() && (sent == UCB_TBCNT))
+            {
+                UCB_IFG |= UCBCNTIFG;
+            }
+            UCB_CTLW0 &= ~UCTXSTP;
+            UCB_STATW &= ~UCBBUSY;
+            current->end = sim_clock;
+            state = IDLE;
+            break;
+
+        case SLAVE_ADDR:
+            if ((UCB_CTLW0 & UCSWRST) || (UCB_CTLW0 & UCMST) || !(UCB_I2COA0 & UCOAEN) ||
+                ((UCB_I2COA0 & 0x7F) != incoming.addr))
+            {
+                incoming.nacked = true;
+                finish_incoming();
+                break;
+            }
+            UCB_IFG |= UCSTTIFG;
+            state = SLAVE_BYTE;
+            phase_end = sim_clock + 9 * EXTERNAL_BIT_TIME;
+            break;
+
+        case SLAVE_BYTE:
+            if (UCB_IFG & UCRXIFG0)
+            {
+                state = SLAVE_HOLD;
+            }
+            else
+            {
+                slave_deliver();
+            }
+            break;
+
+        case SLAVE_STOP:
+            UCB_IFG |= UCSTPIFG;
+            finish_incoming();
+            break;
+
+        default:
+            break;
+    }
+}
+
+void sim_i2c_reset(void)
+{
+    unsigned i;
+
+    state = IDLE;
+    tx_full = false;
+    log_count = 0;
+    current = 0;
+    last_advance = 0;
+    incoming_queued = false;
+    incoming_done = false;
+    rx_released = false;
+    for (i = 0; i < NACK_SLOTS; i++)
+    {
+        nacks[i].count = 0;
+    }
+}
+
+void sim_i2c_sync(void)
+{
+    uint16_t ctl = UCB_CTLW0;
+
+    if (ctl & UCSWRST)
+    {
+        UCB_IFG = 0;
+        tx_full = false;
+        if (is_master())
+        {
+            current->end = sim_clock;
+            UCB_STATW &= ~UCBBUSY;
+            state = IDLE;
+        }
+        UCB_CTLW0 &= ~(UCTXSTT | UCTXSTP);
+        return;
+    }
+
+    if (rx_released)
+    {
+        rx_released = false;
+        if (state == SLAVE_HOLD)
+        {
+            slave_deliver();
+        }
+    }
+
+    if (!(ctl & UCMST))
+    {
+        return;
+    }
+    if ((state == IDLE) && (ctl & UCTXSTT))
+    {
+        if (!(ctl & UCTR))
+        {
+            sim_fail("I2C: only the master transmitter is modelled");
+        }
+        if (log_count == LOG_LEN)
+        {
+            sim_fail("I2C: more than %d transfers", LOG_LEN);
+        }
+        current = &log[log_count++];
+        current->addr = UCB_I2CSA & 0x7F;
+        current->nacked = false;
+        current->len = 0;
+        current->end = 0;
+        sent = 0;
+        state = MASTER_ADDR;
+        phase_end = sim_clock + 10 * bit_time();
+        last_advance = sim_clock;
+        UCB_STATW |= UCBBUSY;
+        UCB_IFG |= UCTXIFG0;
+    }
+    if ((ctl & UCTXSTP) && ((state == MASTER_NACKED) || (state == MASTER_HOLD)))
+    {
+        master_stop();
+    }
+}
+
+void sim_i2c_tx_written(void)
+{
+    tx_full = true;
+    UCB_IFG &= ~UCTXIFG0;
+    if (state == MASTER_HOLD)
+    {
+        load_byte();
+    }
+}
+
+sim_time sim_i2c_next(void)
+{
+    if ((state == IDLE) && incoming_queued)
+    {
+        return sim_clock;
+    }
+    if ((state == IDLE) || (state == MASTER_HOLD) || (state == MASTER_NACKED) || (state == SLAVE_HOLD))
+    {
+        return SIM_NEVER;
+    }
+    if (is_master() && (bit_time() == 0))
+    {
+        return SIM_NEVER;   // SMCLK stopped
+    }
+    return phase_end;
+}
+
+void sim_i2c_advance(sim_time t)
+{
+    // the master's bus phases stand still while SMCLK is stopped
+    if (is_master() && (bit_time() == 0))
+    {
+        phase_end += t - last_advance;
+    }
+    last_advance = t;
+
+    if ((state == IDLE) && incoming_queued)
+    {
+        incoming_queued = false;
+        rx_index = 0;
+        state = SLAVE_ADDR;
+        phase_end = sim_clock + 10 * EXTERNAL_BIT_TIME;
+    }
+    while ((sim_i2c_next() <= t) && (state != IDLE))
+    {
+        phase_done();
+    }
+}
+
+void sim_i2c_read(uint16_t addr)
+{
+    if (addr == 0x054C)
+    {
+        UCB_IFG &= ~UCRXIFG0;
+        if (state == SLAVE_HOLD)
+        {
+            rx_released = true;
+        }
+    }
+    else if (addr == 0x056E)
+    {
+        static const struct
+        {
+            uint16_t flag;
+            uint16_t iv;
+        } order[] = {
+            {UCALIFG, USCI_I2C_UCALIFG},   {UCNACKIFG, USCI_I2C_UCNACKIFG}, {UCSTTIFG, USCI_I2C_UCSTTIFG},
+            {UCSTPIFG, USCI_I2C_UCSTPIFG}, {UCRXIFG0, USCI_I2C_UCRXIFG0},   {UCTXIFG0, USCI_I2C_UCTXIFG0},
+            {UCBCNTIFG, USCI_I2C_UCBCNTIFG},
+        };
+        uint16_t pending = UCB_IE & UCB_IFG;
+        unsigned i;
+
+        UCB_IV = USCI_NONE;
+        for (i = 0; i < sizeof(order) / sizeof(order[0]); i++)
+        {
+            if (pending & order[i].flag)
+            {
+                UCB_IV = order[i].iv;
+                UCB_IFG &= ~order[i].flag;
+                break;
+            }
+        }
+    }
+}
+
+unsigned sim_i2c_count(void)
+{
+    return log_count;
+}
+
+const struct sim_i2c_transfer *sim_i2c_transfer(unsigned n)
+{
+    if (n >= log_count)
+    {
+        sim_fail("no I2C transfer %u", n);
+    }
+    return &log[n];
+}
+
+void sim_i2c_nack(uint8_t addr, unsigned count)
+{
+    unsigned i;
+
+    for (i = 0; i < NACK_SLOTS; i++)
+    {
+        if ((nacks[i].count == 0) || (nacks[i].addr == addr))
+        {
+            nacks[i].addr = addr;
+            nacks[i].count += count;
+            return;
+        }
+    }
+    sim_fail("NACKs set up for more than %d slaves", NACK_SLOTS);
+}
+
+bool sim_i2c_send(uint8_t addr, const uint8_t *data, uint8_t len)
+{
+    unsigned i;
+
+    if ((len == 0) || (len > SIM_I2C_MAX_LEN))
+    {
+        sim_fail("sim_i2c_send: bad length %u", len);
+    }
+    incoming.addr = addr;
+    incoming.nacked = false;
+    incoming.len = len;
+    incoming.end = 0;
+    for (i = 0; i < len; i++)
+    {
+        incoming.data[i] = data[i];
+    }
+    incoming_queued = true;
+    incoming_done = false;
+    while (!incoming_done)
+    {
+        sim_run(SIM_US(100));
+    }
+    return !incoming.nacked;
+}
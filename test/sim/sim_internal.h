@@ -0,0 +1,110 @@
+/**
+ * @file
+ * @brief Interface between the simulator core and its peripheral models.
+ *
+ * The core (sim.c) owns the register file, the clock and the CPU. Each
+ * model keeps its own state and reaches the registers directly through
+ * REG8/REG16, which have no side effects. The core calls, for each model:
+ *
+ * - sync() before anything else happens at an SFR access, so the model can
+ *   act on what the firmware wrote since the last one (a start bit, TBCLR, a
+ *   new mode);
+ * - next() for the time of the model's next event, or SIM_NEVER;
+ * - advance(t) to bring the model up to time t, handling every event due
+ *   by then.
+ */
+#ifndef SIM_INTERNAL_H
+#define SIM_INTERNAL_H
+
+#include "sim.h"
+#include "sim_sfr.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Size of the register file: the peripheral space 0x0000-0x0FFF */
+#define SIM_REGS_SIZE 0x1000
+
+/** A time after every event */
+#define SIM_NEVER UINT64_MAX
+
+/** ACLK period, in picoseconds */
+#define SIM_ACLK_PERIOD (1000000000000ULL / SIM_ACLK_HZ)
+
+/**
+ * The register file
+ */
+union sim_regs
+{
+    /** Byte view */
+    uint8_t b[SIM_REGS_SIZE];
+
+    /** Word view, at half the address */
+    uint16_t w[SIM_REGS_SIZE / 2];
+};
+
+extern union sim_regs sim_regs;
+
+#define REG8(addr) (sim_regs.b[(addr)])
+#define REG16(addr) (sim_regs.w[(addr) >> 1])
+
+/**
+ * Current simulated time, for models.
+ */
+extern sim_time sim_clock;
+
+/**
+ * Print a simulator error and abort: the firmware did something the
+ * simulator can't model, or the test misused it.
+ *
+ * @param: format printf format, then its arguments.
+ */
+void sim_fail(const char *format, ...) __attribute__((noreturn, format(printf, 1, 2)));
+
+/**
+ * MCLK period at the current CSCTL2 setting.
+ *
+ * @return: Picoseconds.
+ */
+sim_time sim_mclk_period(void);
+
+/**
+ * SMCLK period: MCLK's, or 0 while the CPU's low-power mode stops it.
+ *
+ * @return: Picoseconds, or 0.
+ */
+sim_time sim_smclk_period(void);
+
+//-- Timer_B, sim_timer.c
+void sim_timer_reset(void);
+void sim_timer_sync(void);
+sim_time sim_timer_next(void);
+void sim_timer_advance(sim_time t);
+void sim_timer_read(uint16_t addr);
+
+//-- ADC, sim_adc.c
+void sim_adc_reset(void);
+void sim_adc_sync(void);
+sim_time sim_adc_next(void);
+void sim_adc_advance(sim_time t);
+void sim_adc_read(uint16_t addr);
+
+/**
+ * A timer output the ADC can be triggered from has risen.
+ *
+ * @param: source The ADCSHS value of the output: 1 = TB0.1, 2 = TB1.1, 3 = TB2.1.
+ */
+void sim_adc_trigger(unsigned source);
+
+//-- eUSCI_B0 in I2C mode, sim_i2c.c
+void sim_i2c_reset(void);
+void sim_i2c_sync(void);
+sim_time sim_i2c_next(void);
+void sim_i2c_advance(sim_time t);
+void sim_i2c_read(uint16_t addr);
+
+/**
+ * The firmware wrote UCB0TXBUF.
+ */
+void sim_i2c_tx_written(void);
+
+#endif // SIM_INTERNAL_H
@@ -0,0 +1,369 @@
+/**
+ * @file
+ * @brief Special function registers of the simulated MSP430FR2xx.
+ *
+ * Each SFR is an lvalue in the simulator's register file at its device
+ * address, reached through sim_sfr8() or sim_sfr16(). Every access first
+ * brings the peripheral models up to date with what the firmware wrote,
+ * advances the simulated clock by SIM_ACCESS_CYCLES and takes any pending
+ * interrupt, so firmware built against these definitions sees its
+ * peripherals and interrupts in the order the device would show them.
+ *
+ * Addresses and bit values follow msp430fr2355.h. The FR2310 has the same
+ * registers at the same addresses for the peripherals it shares with the
+ * FR2355, so both device headers use this file. Only the registers and bits
+ * the firmware in this repository uses are defined.
+ */
+#ifndef SIM_SFR_H
+#define SIM_SFR_H
+
+#include <stdint.h>
+
+/**
+ * Register-file access to an 8-bit SFR; see the file comment.
+ *
+ * @param: addr Device address of the register.
+ *
+ * @return: The register's storage in the register file.
+ */
+volatile uint8_t *sim_sfr8(uint16_t addr);
+
+/**
+ * Register-file access to a 16-bit SFR; see the file comment.
+ *
+ * @param: addr Device address of the register, even.
+ *
+ * @return: The register's storage in the register file.
+ */
+volatile uint16_t *sim_sfr16(uint16_t addr);
+
+#define SIM_SFR8(addr) (*sim_sfr8(addr))
+#define SIM_SFR16(addr) (*sim_sfr16(addr))
+
+//-- Bits
+#define BIT0 0x0001
+#define BIT1 0x0002
+#define BIT2 0x0004
+#define BIT3 0x0008
+#define BIT4 0x0010
+#define BIT5 0x0020
+#define BIT6 0x0040
+#define BIT7 0x0080
+#define BIT8 0x0100
+#define BIT9 0x0200
+#define BITA 0x0400
+#define BITB 0x0800
+#define BITC 0x1000
+#define BITD 0x2000
+#define BITE 0x4000
+#define BITF 0x8000
+
+//-- Status register
+#define GIE 0x0008
+#define CPUOFF 0x0010
+#define OSCOFF 0x0020
+#define SCG0 0x0040
+#define SCG1 0x0080
+#define LPM0_bits (CPUOFF)
+#define LPM1_bits (SCG0 | CPUOFF)
+#define LPM3_bits (SCG1 | SCG0 | CPUOFF)
+#define LPM4_bits (SCG1 | SCG0 | OSCOFF | CPUOFF)
+
+//-- Interrupt vectors, at their FR2355 vector table addresses; a higher address has the higher priority
+#define TIMER0_B0_VECTOR 0xFFF8
+#define TIMER0_B1_VECTOR 0xFFF6
+#define TIMER1_B0_VECTOR 0xFFF4
+#define TIMER1_B1_VECTOR 0xFFF2
+#define TIMER2_B0_VECTOR 0xFFF0
+#define TIMER2_B1_VECTOR 0xFFEE
+#define TIMER3_B0_VECTOR 0xFFEC
+#define TIMER3_B1_VECTOR 0xFFEA
+#define EUSCI_B0_VECTOR 0xFFE0
+#define PORT1_VECTOR 0xFFDA
+#define PORT2_VECTOR 0xFFD8
+#define PORT3_VECTOR 0xFFD6
+#define PORT4_VECTOR 0xFFD4
+#define ADC_VECTOR 0xFFCE
+
+//-- Digital I/O
+#define P1IN SIM_SFR8(0x0200)
+#define P2IN SIM_SFR8(0x0201)
+#define P1OUT SIM_SFR8(0x0202)
+#define P2OUT SIM_SFR8(0x0203)
+#define P1DIR SIM_SFR8(0x0204)
+#define P2DIR SIM_SFR8(0x0205)
+#define P1REN SIM_SFR8(0x0206)
+#define P2REN SIM_SFR8(0x0207)
+#define P1SEL0 SIM_SFR8(0x020A)
+#define P2SEL0 SIM_SFR8(0x020B)
+#define P1SEL1 SIM_SFR8(0x020C)
+#define P2SEL1 SIM_SFR8(0x020D)
+#define P1IES SIM_SFR8(0x0218)
+#define P2IES SIM_SFR8(0x0219)
+#define P1IE SIM_SFR8(0x021A)
+#define P2IE SIM_SFR8(0x021B)
+#define P1IFG SIM_SFR8(0x021C)
+#define P2IFG SIM_SFR8(0x021D)
+#define P3IN SIM_SFR8(0x0220)
+#define P4IN SIM_SFR8(0x0221)
+#define P3OUT SIM_SFR8(0x0222)
+#define P4OUT SIM_SFR8(0x0223)
+#define P3DIR SIM_SFR8(0x0224)
+#define P4DIR SIM_SFR8(0x0225)
+#define P3REN SIM_SFR8(0x0226)
+#define P4REN SIM_SFR8(0x0227)
+#define P3SEL0 SIM_SFR8(0x022A)
+#define P4SEL0 SIM_SFR8(0x022B)
+#define P3SEL1 SIM_SFR8(0x022C)
+#define P4SEL1 SIM_SFR8(0x022D)
+#define P3IES SIM_SFR8(0x0238)
+#define P4IES SIM_SFR8(0x0239)
+#define P3IE SIM_SFR8(0x023A)
+#define P4IE SIM_SFR8(0x023B)
+#define P3IFG SIM_SFR8(0x023C)
+#define P4IFG SIM_SFR8(0x023D)
+#define P5IN SIM_SFR8(0x0240)
+#define P6IN SIM_SFR8(0x0241)
+#define P5OUT SIM_SFR8(0x0242)
+#define P6OUT SIM_SFR8(0x0243)
+#define P5DIR SIM_SFR8(0x0244)
+#define P6DIR SIM_SFR8(0x0245)
+#define P5REN SIM_SFR8(0x0246)
+#define P6REN SIM_SFR8(0x0247)
+#define P5SEL0 SIM_SFR8(0x024A)
+#define P6SEL0 SIM_SFR8(0x024B)
+#define P5SEL1 SIM_SFR8(0x024C)
+#define P6SEL1 SIM_SFR8(0x024D)
+
+//-- Power management, system configuration and watchdog
+#define PM5CTL0 SIM_SFR16(0x0130)
+#define LOCKLPM5 0x0001
+#define SYSCFG0 SIM_SFR16(0x0160)
+#define PFWP 0x0001
+#define DFWP 0x0002
+#define FRWPPW 0xA500
+#define WDTCTL SIM_SFR16(0x01CC)
+#define WDTPW 0x5A00
+#define WDTHOLD 0x0080
+
+//-- Clock system
+#define CSCTL0 SIM_SFR16(0x0180)
+#define CSCTL1 SIM_SFR16(0x0182)
+#define CSCTL2 SIM_SFR16(0x0184)
+#define CSCTL3 SIM_SFR16(0x0186)
+#define CSCTL4 SIM_SFR16(0x0188)
+#define CSCTL7 SIM_SFR16(0x018E)
+#define DCORSEL_3 0x0006
+#define FLLD_0 0x0000
+#define FLLN 0x03FF
+#define SELREF__REFOCLK 0x0010
+#define SELMS__DCOCLKDIV 0x0000
+#define SELA__REFOCLK 0x0100
+#define FLLUNLOCK0 0x0100
+#define FLLUNLOCK1 0x0200
+
+//-- CRC16
+#define CRCDI SIM_SFR16(0x01C0)
+#define CRCDI_L SIM_SFR8(0x01C0)
+#define CRCDIRB SIM_SFR16(0x01C2)
+#define CRCDIRB_L SIM_SFR8(0x01C2)
+#define CRCINIRES SIM_SFR16(0x01C4)
+#define CRCRESR SIM_SFR16(0x01C6)
+
+//-- MPY32
+#define MPY SIM_SFR16(0x04C0)
+#define MPYS SIM_SFR16(0x04C2)
+#define MAC SIM_SFR16(0x04C4)
+#define MACS SIM_SFR16(0x04C6)
+#define OP2 SIM_SFR16(0x04C8)
+#define RESLO SIM_SFR16(0x04CA)
+#define RESHI SIM_SFR16(0x04CC)
+#define SUMEXT SIM_SFR16(0x04CE)
+#define MPY32CTL0 SIM_SFR16(0x04EC)
+#define MPYC 0x0001
+#define MPYSAT 0x0040
+#define MPYFRAC 0x0080
+
+//-- Timer_B: TBn at 0x0380 + 0x40 * n
+#define TB0CTL SIM_SFR16(0x0380)
+#define TB0CCTL0 SIM_SFR16(0x0382)
+#define TB0CCTL1 SIM_SFR16(0x0384)
+#define TB0CCTL2 SIM_SFR16(0x0386)
+#define TB0R SIM_SFR16(0x0390)
+#define TB0CCR0 SIM_SFR16(0x0392)
+#define TB0CCR1 SIM_SFR16(0x0394)
+#define TB0CCR2 SIM_SFR16(0x0396)
+#define TB0EX0 SIM_SFR16(0x03A0)
+#define TB0IV SIM_SFR16(0x03AE)
+#define TB1CTL SIM_SFR16(0x03C0)
+#define TB1CCTL0 SIM_SFR16(0x03C2)
+#define TB1CCTL1 SIM_SFR16(0x03C4)
+#define TB1CCTL2 SIM_SFR16(0x03C6)
+#define TB1R SIM_SFR16(0x03D0)
+#define TB1CCR0 SIM_SFR16(0x03D2)
+#define TB1CCR1 SIM_SFR16(0x03D4)
+#define TB1CCR2 SIM_SFR16(0x03D6)
+#define TB1EX0 SIM_SFR16(0x03E0)
+#define TB1IV SIM_SFR16(0x03EE)
+#define TB2CTL SIM_SFR16(0x0400)
+#define TB2CCTL0 SIM_SFR16(0x0402)
+#define TB2CCTL1 SIM_SFR16(0x0404)
+#define TB2CCTL2 SIM_SFR16(0x0406)
+#define TB2R SIM_SFR16(0x0410)
+#define TB2CCR0 SIM_SFR16(0x0412)
+#define TB2CCR1 SIM_SFR16(0x0414)
+#define TB2CCR2 SIM_SFR16(0x0416)
+#define TB2EX0 SIM_SFR16(0x0420)
+#define TB2IV SIM_SFR16(0x042E)
+#define TB3CTL SIM_SFR16(0x0440)
+#define TB3CCTL0 SIM_SFR16(0x0442)
+#define TB3CCTL1 SIM_SFR16(0x0444)
+#define TB3CCTL2 SIM_SFR16(0x0446)
+#define TB3R SIM_SFR16(0x0450)
+#define TB3CCR0 SIM_SFR16(0x0452)
+#define TB3CCR1 SIM_SFR16(0x0454)
+#define TB3CCR2 SIM_SFR16(0x0456)
+#define TB3EX0 SIM_SFR16(0x0460)
+#define TB3IV SIM_SFR16(0x046E)
+#define TBIFG 0x0001
+#define TBIE 0x0002
+#define TBCLR 0x0004
+#define MC_0 0x0000
+#define MC_1 0x0010
+#define MC_2 0x0020
+#define MC_3 0x0030
+#define MC__STOP MC_0
+#define MC__UP MC_1
+#define MC__CONTINUOUS MC_2
+#define MC__UPDOWN MC_3
+#define ID_0 0x0000
+#define ID_1 0x0040
+#define ID_2 0x0080
+#define ID_3 0x00C0
+#define ID__1 ID_0
+#define ID__2 ID_1
+#define ID__4 ID_2
+#define ID__8 ID_3
+#define TBSSEL_0 0x0000
+#define TBSSEL_1 0x0100
+#define TBSSEL_2 0x0200
+#define TBSSEL_3 0x0300
+#define TBSSEL__TBCLK TBSSEL_0
+#define TBSSEL__ACLK TBSSEL_1
+#define TBSSEL__SMCLK TBSSEL_2
+#define TBIDEX_0 0x0000
+#define TBIDEX__8 0x0007
+#define CCIFG 0x0001
+#define OUT 0x0004
+#define CCIE 0x0010
+#define OUTMOD_0 0x0000
+#define OUTMOD_7 0x00E0
+#define CAP 0x0100
+
+//-- eUSCI_B0 in I2C mode
+#define UCB0CTLW0 SIM_SFR16(0x0540)
+#define UCB0CTLW1 SIM_SFR16(0x0542)
+#define UCB0BRW SIM_SFR16(0x0546)
+#define UCB0STATW SIM_SFR16(0x0548)
+#define UCB0TBCNT SIM_SFR16(0x054A)
+#define UCB0RXBUF SIM_SFR16(0x054C)
+#define UCB0TXBUF SIM_SFR16(0x054E)
+#define UCB0I2COA0 SIM_SFR16(0x0554)
+#define UCB0I2CSA SIM_SFR16(0x0560)
+#define UCB0IE SIM_SFR16(0x056A)
+#define UCB0IFG SIM_SFR16(0x056C)
+#define UCB0IV SIM_SFR16(0x056E)
+#define UCSWRST 0x0001
+#define UCTXSTT 0x0002
+#define UCTXSTP 0x0004
+#define UCTXNACK 0x0008
+#define UCTR 0x0010
+#define UCSSEL_3 0x00C0
+#define UCSYNC 0x0100
+#define UCMODE_3 0x0600
+#define UCMST 0x0800
+#define UCASTP_2 0x0008
+#define UCBBUSY 0x0010
+#define UCOAEN 0x0400
+#define UCRXIE0 0x0001
+#define UCTXIE0 0x0002
+#define UCSTTIE 0x0004
+#define UCSTPIE 0x0008
+#define UCNACKIE 0x0020
+#define UCBCNTIE 0x0040
+#define UCRXIFG0 0x0001
+#define UCTXIFG0 0x0002
+#define UCSTTIFG 0x0004
+#define UCSTPIFG 0x0008
+#define UCALIFG 0x0010
+#define UCNACKIFG 0x0020
+#define UCBCNTIFG 0x0040
+#define USCI_NONE 0x00
+#define USCI_I2C_UCALIFG 0x02
+#define USCI_I2C_UCNACKIFG 0x04
+#define USCI_I2C_UCSTTIFG 0x06
+#define USCI_I2C_UCSTPIFG 0x08
+#define USCI_I2C_UCRXIFG0 0x16
+#define USCI_I2C_UCTXIFG0 0x18
+#define USCI_I2C_UCBCNTIFG 0x1A
+#define USCI_I2C_UCCLTOIFG 0x1C
+#define USCI_I2C_UCBIT9IFG 0x1E
+
+//-- ADC
+#define ADCCTL0 SIM_SFR16(0x0700)
+#define ADCCTL1 SIM_SFR16(0x0702)
+#define ADCCTL2 SIM_SFR16(0x0704)
+#define ADCLO SIM_SFR16(0x0706)
+#define ADCHI SIM_SFR16(0x0708)
+#define ADCMCTL0 SIM_SFR16(0x070A)
+#define ADCMEM0 SIM_SFR16(0x0712)
+#define ADCIE SIM_SFR16(0x071A)
+#define ADCIFG SIM_SFR16(0x071C)
+#define ADCIV SIM_SFR16(0x071E)
+#define ADCSC 0x0001
+#define ADCENC 0x0002
+#define ADCON 0x0010
+#define ADCMSC 0x0080
+#define ADCSHT_2 0x0200
+#define ADCSHT_15 0x0F00
+#define ADCBUSY 0x0001
+#define ADCCONSEQ 0x0006
+#define ADCCONSEQ_0 0x0000
+#define ADCCONSEQ_2 0x0004
+#define ADCSSEL_0 0x0000
+#define ADCDIV_0 0x0000
+#define ADCDIV_7 0x00E0
+#define ADCSHP 0x0200
+#define ADCSHS 0x0C00
+#define ADCSHS_0 0x0000
+#define ADCSHS_2 0x0800
+#define ADCPDIV_0 0x0000
+#define ADCPDIV_3 0x0300
+#define ADCRES 0x0030
+#define ADCRES_0 0x0000
+#define ADCRES_1 0x0010
+#define ADCRES_2 0x0020
+#define ADCINCH 0x000F
+#define ADCINCH_10 0x000A
+#define ADCSREF0 0x0010
+#define ADCSREF1 0x0020
+#define ADCSREF2 0x0040
+#define ADCIE0 0x0001
+#define ADCLOIE 0x0002
+#define ADCINIE 0x0004
+#define ADCHIIE 0x0008
+#define ADCIFG0 0x0001
+#define ADCLOIFG 0x0002
+#define ADCINIFG 0x0004
+#define ADCHIIFG 0x0008
+#define ADCOVIFG 0x0010
+#define ADCTOVIFG 0x0020
+#define ADCIV_NONE 0x0000
+#define ADCIV_ADCOVIFG 0x0002
+#define ADCIV_ADCTOVIFG 0x0004
+#define ADCIV_ADCHIIFG 0x0006
+#define ADCIV_ADCLOIFG 0x0008
+#define ADCIV_ADCINIFG 0x000A
+#define ADCIV_ADCIFG 0x000C
+
+#endif // SIM_SFR_H
@@ -0,0 +1,302 @@
+/**
+ * @file
+ * @brief Timer_B0-B3 model: up and continuous modes, compare flags and the reset/set output.
+ *
+ * Rather than stepping every timer clock, the model jumps from one count the
+ * firmware can see to the next: a compare match or the wrap to zero. TBxR
+ * is brought up to date at every SFR access. Up/down mode and capture are
+ * not modelled.
+ */
+#include "sim_internal.h"
+
+#define TIMERS 4
+#define TB_BASE(n) (0x0380 + 0x40 * (n))
+#define TB_CTL(n) REG16(TB_BASE(n))
+#define TB_CCTL(n, k) REG16(TB_BASE(n) + 0x02 + 2 * (k))
+#define TB_R(n) REG16(TB_BASE(n) + 0x10)
+#define TB_CCR(n, k) REG16(TB_BASE(n) + 0x12 + 2 * (k))
+#define TB_EX0(n) REG16(TB_BASE(n) + 0x20)
+#define TB_IV(n) REG16(TB_BASE(n) + 0x2E)
+
+// TB3 has seven capture/compare registers, TB0-TB2 three
+#define TB_CCRS(n) (((n) == 3) ? 7 : 3)
+
+#define OUTMOD_MASK 0x00E0
+
+/**
+ * Model state of one timer
+ */
+struct timer
+{
+    /** Counting: a mode is selected and the clock is running */
+    bool running;
+
+    /** Timer clock period with the dividers, 0 if the clock is stopped */
+    sim_time period;
+
+    /** When the count next changes */
+    sim_time next_tick;
+};
+
+static struct timer timers[TIMERS];
+
+static sim_time clock_period(unsigned n)
+{
+    uint16_t ctl = TB_CTL(n);
+    sim_time source;
+
+    switch (ctl & TBSSEL_3)
+    {
+        case TBSSEL__ACLK:
+            source = SIM_ACLK_PERIOD;
+            break;
+
+        case TBSSEL__SMCLK:
+            source = sim_smclk_period();
+            break;
+
+        default:
+            sim_fail("TB%u: only ACLK and SMCLK are modelled", n);
+    }
+    return source * (1u << ((ctl & ID_3) >> 6)) * ((TB_EX0(n) & 7) + 1);
+}
+
+// Act on TBCLR, a mode change or a clock change
+static void timer_sync(unsigned n)
+{
+    struct timer *t = &timers[n];
+    uint16_t ctl = TB_CTL(n);
+    bool clear = ctl & TBCLR;
+    sim_time period;
+    bool running;
+
+    if (clear)
+    {
+        TB_R(n) = 0;
+        TB_CTL(n) &= ~TBCLR;
+    }
+    if ((ctl & MC_3) == MC__UPDOWN)
+    {
+        sim_fail("TB%u: up/down mode is not modelled", n);
+    }
+    period = (ctl & MC_3) ? clock_period(n) : 0;
+    running = (period != 0) && !(((ctl & MC_3) == MC__UP) && (TB_CCR(n, 0) == 0));    // up mode to 0 halts
+    if (running && (!t->running || clear || (period != t->period)))
+    {
+        t->next_tick = sim_clock + period;
+    }
+    t->running = running;
+    t->period = period;
+}
+
+// Ticks from the count c until the count reaches v
+static uint32_t distance(unsigned n, uint16_t c, uint16_t v)
+{
+    uint16_t top = TB_CCR(n, 0);
+
+    if ((TB_CTL(n) & MC_3) == MC__CONTINUOUS)
+    {
+        return ((uint16_t)(v - c - 1)) + 1UL;
+    }
+    if (c >= top)
+    {
+        return 1UL + v;         // to zero, then up to v
+    }
+    if (v > c)
+    {
+        return v - c;
+    }
+    return (top - c) + 1UL + v;
+}
+
+// The count ticks after c
+static uint16_t count_after(unsigned n, uint16_t c, uint32_t ticks)
+{
+    uint16_t top = TB_CCR(n, 0);
+
+    if ((TB_CTL(n) & MC_3) == MC__CONTINUOUS)
+    {
+        return (uint16_t)(c + ticks);
+    }
+    if (c >= top)
+    {
+        return (uint16_t)(ticks - 1);
+    }
+    if (c + ticks <= top)
+    {
+        return (uint16_t)(c + ticks);
+    }
+    return (uint16_t)(c + ticks - top - 1);
+}
+
+// Whether CCRk is a count the timer reaches
+static bool compare_reached(unsigned n, unsigned k)
+{
+    if (TB_CCTL(n, k) & CAP)
+    {
+        return false;
+    }
+    return ((TB_CTL(n) & MC_3) == MC__CONTINUOUS) || (TB_CCR(n, k) <= TB_CCR(n, 0));
+}
+
+// Ticks until the next count with an effect: a compare match or the wrap to zero
+static uint32_t ticks_to_event(unsigned n)
+{
+    uint16_t c = TB_R(n);
+    uint32_t ticks = distance(n, c, 0);
+    unsigned k;
+
+    for (k = 0; k < TB_CCRS(n); k++)
+    {
+        if (compare_reached(n, k))
+        {
+            uint32_t d = distance(n, c, TB_CCR(n, k));
+            if (d < ticks)
+            {
+                ticks = d;
+            }
+        }
+    }
+    return ticks;
+}
+
+// The count has just changed to TBxR: set the flags and outputs for it
+static void on_count(unsigned n)
+{
+    uint16_t c = TB_R(n);
+    unsigned k;
+
+    if (c == 0)
+    {
+        TB_CTL(n) |= TBIFG;
+    }
+    for (k = 1; k < TB_CCRS(n); k++)
+    {
+        if (compare_reached(n, k) && (TB_CCR(n, k) == c))
+        {
+            TB_CCTL(n, k) |= CCIFG;
+            if ((TB_CCTL(n, k) & OUTMOD_MASK) == OUTMOD_7)
+            {
+                TB_CCTL(n, k) &= ~OUT;      // reset at CCRk
+            }
+        }
+    }
+    if (compare_reached(n, 0) && (TB_CCR(n, 0) == c))
+    {
+        TB_CCTL(n, 0) |= CCIFG;
+        for (k = 1; k < TB_CCRS(n); k++)
+        {
+            if (((TB_CCTL(n, k) & OUTMOD_MASK) == OUTMOD_7) && !(TB_CCTL(n, k) & OUT))
+            {
+                TB_CCTL(n, k) |= OUT;       // set at CCR0
+                if ((k == 1) && (n < 3))
+                {
+                    sim_adc_trigger(n + 1);
+                }
+            }
+        }
+    }
+}
+
+void sim_timer_reset(void)
+{
+    unsigned n;
+
+    for (n = 0; n < TIMERS; n++)
+    {
+        timers[n].running = false;
+        timers[n].period = 0;
+        timers[n].next_tick = 0;
+    }
+}
+
+void sim_timer_sync(void)
+{
+    unsigned n;
+
+    for (n = 0; n < TIMERS; n++)
+    {
+        timer_sync(n);
+    }
+}
+
+sim_time sim_timer_next(void)
+{
+    sim_time next = SIM_NEVER;
+    unsigned n;
+
+    for (n = 0; n < TIMERS; n++)
+    {
+        const struct timer *t = &timers[n];
+
+        timer_sync(n);
+        if (t->running)
+        {
+            sim_time event = t->next_tick + (ticks_to_event(n) - 1) * t->period;
+            if (event < next)
+            {
+                next = event;
+            }
+        }
+    }
+    return next;
+}
+
+void sim_timer_advance(sim_time until)
+{
+    unsigned n;
+
+    for (n = 0; n < TIMERS; n++)
+    {
+        struct timer *t = &timers[n];
+
+        timer_sync(n);
+        while (t->running && (t->next_tick <= until))
+        {
+            uint32_t ticks = ticks_to_event(n);
+            sim_time event = t->next_tick + (ticks - 1) * t->period;
+
+            if (event > until)
+            {
+                // no event on the way: just count
+                uint32_t elapsed = (uint32_t)((until - t->next_tick) / t->period) + 1;
+                TB_R(n) = count_after(n, TB_R(n), elapsed);
+                t->next_tick += elapsed * t->period;
+                break;
+            }
+            TB_R(n) = count_after(n, TB_R(n), ticks);
+            t->next_tick = event + t->period;
+            on_count(n);
+        }
+    }
+}
+
+void sim_timer_read(uint16_t addr)
+{
+    unsigned n;
+
+    for (n = 0; n < TIMERS; n++)
+    {
+        if (addr == TB_BASE(n) + 0x2E)
+        {
+            uint16_t iv = 0;
+            unsigned k;
+
+            for (k = 1; k < TB_CCRS(n); k++)
+            {
+                if ((TB_CCTL(n, k) & (CCIE | CCIFG)) == (CCIE | CCIFG))
+                {
+                    iv = 2 * k;
+                    TB_CCTL(n, k) &= ~CCIFG;
+                    break;
+                }
+            }
+            if ((iv == 0) && ((TB_CTL(n) & (TBIE | TBIFG)) == (TBIE | TBIFG)))
+            {
+                iv = 0x0E;
+                TB_CTL(n) &= ~TBIFG;
+            }
+            TB_IV(n) = iv;
+        }
+    }
+}
@@ -0,0 +1,237 @@
+/**
+ * @file
+ * @brief Tests for the ADC sampler: decimation of synthetic noisy input, then
+ * the sample rate and the monitor window's hysteresis on the simulator.
+ */
+#include "adc_sampler.h"
+#include "check.h"
+#include "sim.h"
+#include <math.h>
+#include <msp430.h>
+
+// Input noise, in 12-bit codes: enough for oversampling to resolve between codes
+#define NOISE_RMS 0.7
+
+// Decimated samples per measurement
+#define OUTPUTS 4000
+
+// Output samples in 12-bit codes
+#define OUTPUT_TO_CODES (1.0 / (1 << (ADC_SAMPLER_OUTPUT_BITS - 12)))
+
+// Monitor window in 12-bit codes
+#define WINDOW_LOW 1000
+#define WINDOW_HIGH 3000
+
+static uint32_t rng_state = 1;
+
+static double uniform(void)
+{
+    rng_state = rng_state * 1103515245UL + 12345UL;
+    return ((rng_state >> 8) + 0.5) / 16777216.0;
+}
+
+static double gaussian(void)
+{
+    return sqrt(-2.0 * log(uniform())) * cos(6.283185307179586 * uniform());
+}
+
+// One conversion of an input at level codes with NOISE_RMS of noise
+static uint16_t convert(double level)
+{
+    long code = lround(level + NOISE_RMS * gaussian());
+
+    return (uint16_t)((code < 0) ? 0 : (code > 4095) ? 4095 : code);
+}
+
+// One decimated sample of a steady input, in 12-bit codes
+static double decimated(double level)
+{
+    uint16_t sample = 0;
+
+    while (!adc_sampler_decimate(convert(level), &sample))
+    {
+    }
+    return sample * OUTPUT_TO_CODES;
+}
+
+// ENOB from an RMS error in 12-bit codes: 12 bits less what the error costs
+// over ideal 12-bit quantisation
+static double enob(double rms)
+{
+    return 12.0 - log2(rms * sqrt(12.0));
+}
+
+static void test_noise(void)
+{
+    double raw_sq = 0;
+    double out_sq = 0;
+    double bias = 0;
+    double sum = 0;
+    double sum_sq = 0;
+    double mean;
+    double variance;
+    double expected;
+    unsigned i;
+    unsigned j;
+
+    // error against random levels, raw conversions and decimated
+    for (i = 0; i < OUTPUTS; i++)
+    {
+        double level = 100.0 + 3895.0 * uniform();
+        double error = decimated(level) - level;
+
+        for (j = 0; j < ADC_SAMPLER_OVERSAMPLE_COUNT; j++)
+        {
+            double raw_error = convert(level) - level;
+            raw_sq += raw_error * raw_error;
+        }
+        out_sq += error * error;
+        bias += error;
+    }
+    raw_sq /= (double)OUTPUTS * ADC_SAMPLER_OVERSAMPLE_COUNT;
+    out_sq /= OUTPUTS;
+    bias /= OUTPUTS;
+
+    // each factor of 4 in conversions buys close to a bit (measured 10.61 to
+    // 12.52 at n = 2). Rounding the sum's exact halves up leaves a bias of
+    // half a step of the 12 + 2n bit sum, 1/32 of a code at n = 2.
+    CHECK(enob(sqrt(out_sq)) - enob(sqrt(raw_sq)) > ADC_SAMPLER_OVERSAMPLE_BITS - 0.25);
+    CHECK(fabs(bias - (ADC_SAMPLER_OVERSAMPLE_BITS ? 0.5 / ADC_SAMPLER_OVERSAMPLE_COUNT : 0)) < 0.01);
+
+    // a steady input: the noise variance falls with the number of conversions,
+    // down to the quantisation of the 12 + n bit result
+    for (i = 0; i < OUTPUTS; i++)
+    {
+        double sample = decimated(2048.3);
+        sum += sample;
+        sum_sq += sample * sample;
+    }
+    mean = sum / OUTPUTS;
+    variance = sum_sq / OUTPUTS - mean * mean;
+    expected = NOISE_RMS * NOISE_RMS / ADC_SAMPLER_OVERSAMPLE_COUNT + 1.0 / (12 << (2 * ADC_SAMPLER_OVERSAMPLE_BITS));
+    CHECK(variance < 1.25 * expected);
+    CHECK(fabs(mean - 2048.3) < 0.05);
+}
+
+//-- on the simulator, with an ISR doing what central's ADC_ISR does
+static double input_level = 2048;
+static double input_noise = 0;          // peak of uniform noise on the input
+static unsigned long conversions = 0;
+static unsigned long outputs = 0;
+static unsigned long threshold_crossings = 0;   // conversions on the other side of a threshold from the one before
+static uint8_t zone = ADC_WINDOW_INSIDE;
+static unsigned long zone_changes = 0;
+
+static uint16_t input(unsigned channel)
+{
+    static bool was_outside = false;
+    long code = lround(input_level + input_noise * (2.0 * uniform() - 1.0));
+    bool outside = (code > WINDOW_HIGH) || (code < WINDOW_LOW);
+
+    (void)channel;
+    threshold_crossings += (outside != was_outside);
+    was_outside = outside;
+    conversions++;
+    return (uint16_t)code;
+}
+
+static void enter(uint8_t entered)
+{
+    adc_sampler_window_enter(entered);
+    zone_changes += (entered != zone);
+    zone = entered;
+}
+
+static void adc_isr(void)
+{
+    uint16_t sample;
+
+    switch (ADCIV)
+    {
+        case ADCIV_ADCIFG:
+            outputs += adc_sampler_decimate(ADCMEM0, &sample);
+            break;
+        case ADCIV_ADCHIIFG:
+            enter(ADC_WINDOW_ABOVE);
+            break;
+        case ADCIV_ADCLOIFG:
+            enter(ADC_WINDOW_BELOW);
+            break;
+        case ADCIV_ADCINIFG:
+            enter(ADC_WINDOW_INSIDE);
+            break;
+        default:
+            break;
+    }
+}
+
+static void sampler_boot(void)
+{
+    sim_reset();
+    sim_vector(ADC_VECTOR, adc_isr);
+    sim_adc_wire(input);
+    adc_sampler_setup();
+    PM5CTL0 &= ~LOCKLPM5;
+    adc_sampler_stream();
+}
+
+static void test_rate(void)
+{
+    uint16_t hz;
+
+    // 4^n conversions per output sample, at every rate the sampler takes
+    for (hz = 1; hz <= ADC_SAMPLER_MAX_HZ; hz *= 2)
+    {
+        sampler_boot();
+        adc_sampler_set_rate(hz);
+        conversions = 0;
+        outputs = 0;
+        sim_sleep(LPM3_bits, SIM_MS(2000));
+        CHECK(outputs + 1 >= 2UL * hz);
+        CHECK(outputs <= 2UL * hz + 1);
+        CHECK(conversions / ADC_SAMPLER_OVERSAMPLE_COUNT == outputs);
+        CHECK_EQ(sim_isr_count(ADC_VECTOR), conversions);
+    }
+}
+
+// Sit on a threshold with noise, then leave it by more than the hysteresis
+static void straddle(double threshold, double away)
+{
+    sampler_boot();
+    adc_sampler_set_rate(ADC_SAMPLER_MAX_HZ);
+    adc_sampler_monitor(WINDOW_LOW << (ADC_SAMPLER_OUTPUT_BITS - 12), WINDOW_HIGH << (ADC_SAMPLER_OUTPUT_BITS - 12));
+    zone = ADC_WINDOW_INSIDE;
+    zone_changes = 0;
+    threshold_crossings = 0;
+
+    // noise of +-2 codes on the threshold crosses it on about every other
+    // conversion; the window reports the way out once and not the way back
+    // (with no hysteresis, about 4850 interrupts in these 5 s)
+    input_level = threshold;
+    input_noise = 2.4;
+    sim_sleep(LPM3_bits, SIM_MS(5000));
+    CHECK(threshold_crossings > 1000);
+    CHECK_EQ(zone_changes, 1);
+    CHECK_EQ(sim_isr_count(ADC_VECTOR), 1);
+
+    // back in by more than ADC_SAMPLER_WINDOW_HYST: one more, then quiet
+    input_level = threshold + away;
+    sim_sleep(LPM3_bits, SIM_MS(5000));
+    CHECK_EQ(zone, ADC_WINDOW_INSIDE);
+    CHECK_EQ(zone_changes, 2);
+    CHECK_EQ(sim_isr_count(ADC_VECTOR), 2);
+}
+
+static void test_window_hysteresis(void)
+{
+    straddle(WINDOW_HIGH, -(ADC_SAMPLER_WINDOW_HYST + 3));
+    straddle(WINDOW_LOW, ADC_SAMPLER_WINDOW_HYST + 3);
+}
+
+int main(void)
+{
+    test_noise();
+    test_rate();
+    test_window_hysteresis();
+    return check_finish("adc_sampler");
+}
@@ -0,0 +1,309 @@
+/**
+ * @file
+ * @brief The central image on the simulator: keypad, sensor and the frames it sends the two nodes.
+ *
+ * The LCD frame the image means to show is rebuilt from the spans in the
+ * I2C log, so the checks read like what the LCD node would draw.
+ */
+#include "adc_sampler.h"
+#include "check.h"
+#include "i2c_master.h"
+#include "key_matrix.h"
+#include "lcd_protocol.h"
+#include "led_protocol.h"
+#include "lm19.h"
+#include "sim.h"
+#include <msp430.h>
+#include <string.h>
+
+int central_main(void);
+void EUSCI_B0_I2C_ISR(void);
+void PORT2_ISR(void);
+void KEYPAD_SCAN_ISR(void);
+void ADC_ISR(void);
+
+static int16_t sensor_centi_c = 2340;
+static unsigned sensor_noise = 0;       // peak noise on the sensor, in 12-bit codes
+static uint32_t rng_state = 1;
+
+static uint16_t sensor(unsigned channel)
+{
+    uint16_t code = lm19_code_at_centi_c(sensor_centi_c) >> 4;
+
+    (void)channel;
+    rng_state = rng_state * 1103515245UL + 12345UL;
+    return code + (rng_state >> 16) % (2 * sensor_noise + 1) - sensor_noise;
+}
+
+static void boot(void)
+{
+    sim_reset();
+    sim_vector(EUSCI_B0_VECTOR, EUSCI_B0_I2C_ISR);
+    sim_vector(PORT2_VECTOR, PORT2_ISR);
+    sim_vector(TIMER2_B0_VECTOR, KEYPAD_SCAN_ISR);
+    sim_vector(ADC_VECTOR, ADC_ISR);
+    key_matrix_attach();
+    sim_adc_wire(sensor);
+    sim_boot(central_main);
+}
+
+// The LCD frame after every update sent so far
+static void lcd_frame(char frame[LCD_FRAME_LEN + 1])
+{
+    unsigned n;
+
+    memset(frame, ' ', LCD_FRAME_LEN);
+    frame[LCD_FRAME_LEN] = '\0';
+    for (n = 0; n < sim_i2c_count(); n++)
+    {
+        const struct sim_i2c_transfer *t = sim_i2c_transfer(n);
+        unsigned i = 0;
+
+        if ((t->addr != I2C_ADDR_LCD) || t->nacked || (t->len < LCD_FRAME_CRC_LEN))
+        {
+            continue;
+        }
+        while (i + LCD_SPAN_HEADER_LEN + LCD_FRAME_CRC_LEN <= t->len)
+        {
+            unsigned offset = t->data[i];
+            unsigned count = t->data[i + 1];
+
+            memcpy(&frame[offset], &t->data[i + LCD_SPAN_HEADER_LEN], count);
+            i += LCD_SPAN_HEADER_LEN + count;
+        }
+    }
+}
+
+static unsigned transfers_to(uint8_t addr)
+{
+    unsigned count = 0;
+    unsigned n;
+
+    for (n = 0; n < sim_i2c_count(); n++)
+    {
+        if (sim_i2c_transfer(n)->addr == addr)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+// The pattern in the last LED_CMD_SET_PATTERN sent to the LED bar
+static int led_pattern(void)
+{
+    static const uint8_t args[] = {
+        [LED_CMD_SET_PATTERN] = 1, [LED_CMD_SET_PERIOD] = 2, [LED_CMD_SET_RAW] = 1, [LED_CMD_SEQ_WRITE] = 3,
+        [LED_CMD_SEQ_COMMIT] = 4, [LED_CMD_SEQ_PLAY] = 1, [LED_CMD_PROG_RUN] = 1,
+    };
+    int pattern = -1;
+    unsigned n;
+
+    for (n = 0; n < sim_i2c_count(); n++)
+    {
+        const struct sim_i2c_transfer *t = sim_i2c_transfer(n);
+        unsigned i = LED_FRAME_HEADER_LEN;
+
+        if ((t->addr != I2C_ADDR_LED_BAR) || t->nacked || (t->data[0] != LED_FRAME_START))
+        {
+            continue;
+        }
+        while (i < LED_FRAME_HEADER_LEN + (unsigned)t->data[1])
+        {
+            uint8_t cmd = t->data[i];
+
+            if (cmd == LED_CMD_SET_PATTERN)
+            {
+                pattern = t->data[i + 1];
+            }
+            i += 1 + args[cmd] + ((cmd == LED_CMD_SEQ_WRITE) ? t->data[i + 3] * LED_SEQ_FRAME_LEN : 0);
+        }
+    }
+    return pattern;
+}
+
+// Whether transfer n carries the whole LCD frame as one span
+static bool full_frame(unsigned n)
+{
+    const struct sim_i2c_transfer *t = sim_i2c_transfer(n);
+
+    return (t->addr == I2C_ADDR_LCD) && !t->nacked && (t->len == LCD_MAX_TRANSACTION_LEN)
+        && (t->data[0] == 0) && (t->data[1] == LCD_FRAME_LEN);
+}
+
+static void press(sim_time at, char key)
+{
+    key_matrix_set_at(at, key, true);
+    key_matrix_set_at(at + SIM_MS(80), key, false);
+}
+
+// Press each key of a string 200 ms apart from at, and return when the last is done
+static sim_time type(sim_time at, const char *keys)
+{
+    for (; *keys; keys++, at += SIM_MS(200))
+    {
+        press(at, *keys);
+    }
+    return at;
+}
+
+static void test_boot(void)
+{
+    char frame[LCD_FRAME_LEN + 1];
+
+    boot();
+    sim_run(SIM_MS(3000));
+    lcd_frame(frame);
+    CHECK(strcmp(frame, "LOCKED          T= 23.4C   N=003") == 0);
+    CHECK(transfers_to(I2C_ADDR_LED_BAR) > 0);
+
+    // sleeping between samples
+    CHECK(sim_active_time() < SIM_MS(3000) / 20);
+}
+
+static void test_unlock(void)
+{
+    char frame[LCD_FRAME_LEN + 1];
+    sim_time t = SIM_MS(500);
+    int i;
+
+    boot();
+    for (i = 0; i < 4; i++, t += SIM_MS(200))
+    {
+        press(t, '1');
+    }
+    sim_run(SIM_MS(1500));
+    lcd_frame(frame);
+    CHECK(strncmp(frame, "UNLOCKED        ", LCD_ROW_LEN) == 0);
+}
+
+// Wake-ups and ADC interrupts over a stretch of time
+static void measure(sim_time duration, unsigned long *wakeups, unsigned long *adc_isrs)
+{
+    unsigned long wakeups_before = sim_wakeups();
+    unsigned long adc_before = sim_isr_count(ADC_VECTOR);
+
+    sim_run(duration);
+    *wakeups = sim_wakeups() - wakeups_before;
+    *adc_isrs = sim_isr_count(ADC_VECTOR) - adc_before;
+}
+
+static void test_monitor_wakeups(void)
+{
+    char frame[LCD_FRAME_LEN + 1];
+    unsigned long stream_wakeups;
+    unsigned long stream_adc;
+    unsigned long monitor_wakeups;
+    unsigned long monitor_adc;
+    unsigned long wakeups;
+    unsigned long adc_isrs;
+    sim_time t;
+
+    // 23.4 C with a code of noise either way, unlocked, streaming for a minute
+    sensor_centi_c = 2340;
+    sensor_noise = 1;
+    boot();
+    t = type(SIM_MS(500), "1111");
+    sim_run(t + SIM_MS(500));
+    measure(SIM_MS(60000), &stream_wakeups, &stream_adc);
+
+    // monitor 18 to 25 C for the same minute
+    t = type(sim_now() + SIM_MS(100), "#18*25*");
+    sim_run(t + SIM_MS(500) - sim_now());
+    lcd_frame(frame);
+    CHECK(strncmp(frame, "Monitoring      ", LCD_ROW_LEN) == 0);
+    measure(SIM_MS(60000), &monitor_wakeups, &monitor_adc);
+
+    // streaming: every conversion interrupts and every display tick wakes
+    // the main loop (128 wake-ups and 1920 interrupts); monitoring in band:
+    // neither
+    CHECK_EQ(stream_adc, 60 * ADC_SAMPLER_DEFAULT_HZ * ADC_SAMPLER_OVERSAMPLE_COUNT);
+    CHECK(stream_wakeups >= 60 * 2);
+    CHECK_EQ(monitor_adc, 0);
+    CHECK_EQ(monitor_wakeups, 0);
+
+    // too hot for ten seconds: one crossing, an alert and the alert pattern
+    sensor_centi_c = 2700;
+    measure(SIM_MS(10000), &wakeups, &adc_isrs);
+    CHECK_EQ(adc_isrs, 1);
+    CHECK(wakeups <= 4);
+    lcd_frame(frame);
+    CHECK(strncmp(frame, "HIGH TEMP ALERT ", LCD_ROW_LEN) == 0);
+    CHECK_EQ(led_pattern(), 1);
+
+    // back in band: one more, and the pattern before the alert
+    sensor_centi_c = 2200;
+    measure(SIM_MS(10000), &wakeups, &adc_isrs);
+    CHECK_EQ(adc_isrs, 1);
+    CHECK(wakeups <= 4);
+    lcd_frame(frame);
+    CHECK(strncmp(frame, "Monitoring      ", LCD_ROW_LEN) == 0);
+    CHECK_EQ(led_pattern(), LED_PATTERN_OFF);
+    sensor_noise = 0;
+}
+
+static void test_limit_rejected(void)
+{
+    char frame[LCD_FRAME_LEN + 1];
+    unsigned long adc_isrs;
+    sim_time t;
+
+    sensor_centi_c = 2340;
+    boot();
+    t = type(SIM_MS(500), "1111");
+
+    // a low limit past 130 C goes back to the unlocked state, which 'A' shows
+    t = type(t, "#131*");
+    sim_run(t + SIM_MS(200));
+    lcd_frame(frame);
+    CHECK(strncmp(frame, "Limit Rejected  ", LCD_ROW_LEN) == 0);
+    t = type(t + SIM_MS(200), "A*");
+    sim_run(t + SIM_MS(200) - sim_now());
+    lcd_frame(frame);
+    CHECK(strncmp(frame, "Set Pattern     ", LCD_ROW_LEN) == 0);
+
+    // a high limit below the low one: rejected, and samples keep streaming
+    t = type(t + SIM_MS(200), "#25*18*");
+    sim_run(t + SIM_MS(200) - sim_now());
+    lcd_frame(frame);
+    CHECK(strncmp(frame, "Limit Rejected  ", LCD_ROW_LEN) == 0);
+    adc_isrs = sim_isr_count(ADC_VECTOR);
+    sim_run(SIM_MS(1000));
+    CHECK(sim_isr_count(ADC_VECTOR) - adc_isrs >= ADC_SAMPLER_DEFAULT_HZ * ADC_SAMPLER_OVERSAMPLE_COUNT - 1);
+}
+
+static void test_resync_period(void)
+{
+    sim_time last = 0;
+    unsigned resends = 0;
+    unsigned n;
+
+    // the whole frame goes again every LCD_LINK_RESYNC_TICKS shown averages: 4 s
+    boot();
+    sim_run(SIM_MS(30000));
+    for (n = 0; n < sim_i2c_count(); n++)
+    {
+        if (!full_frame(n))
+        {
+            continue;
+        }
+        if (last)
+        {
+            sim_time gap = sim_i2c_transfer(n)->end - last;
+            CHECK((gap > SIM_MS(3990)) && (gap < SIM_MS(4010)));
+            resends++;
+        }
+        last = sim_i2c_transfer(n)->end;
+    }
+    CHECK(resends >= 6);
+}
+
+int main(void)
+{
+    test_boot();
+    test_unlock();
+    test_resync_period();
+    test_monitor_wakeups();
+    test_limit_rejected();
+    return check_finish("central");
+}
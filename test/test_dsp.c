@@ -0,0 +1,154 @@
+/**
+ * @file
+ * @brief Tests for the Q15 kernels: the portable model and the MPY32 path against exact arithmetic.
+ *
+ * dsp.c is built twice: as is, which on the host is the portable model, and
+ * on its MPY32 path against the simulator's MPY32 in sim/, renamed to
+ * mpy32_q15_*. Both must match the exact rounded and saturated result.
+ */
+#include "check.h"
+#include "dsp.h"
+#include <msp430.h>
+
+#include <math.h>
+
+int16_t mpy32_q15_scale(int16_t x, int16_t gain);
+int16_t mpy32_q15_dot(const int16_t *a, const int16_t *b, uint8_t n);
+
+#define RANDOM_PAIRS 1000000UL
+#define RANDOM_VECTORS 100000UL
+#define MAX_TAPS 16
+
+static uint32_t rng_state = 1;
+
+static uint16_t next_random(void)
+{
+    rng_state = rng_state * 1103515245UL + 12345UL;
+    return (uint16_t)(rng_state >> 16);
+}
+
+// Sum of products in Q15, rounded to nearest (halves up) and saturated
+static int16_t exact_q15(double products)
+{
+    double q15 = floor(products / 32768.0 + 0.5);
+
+    if (q15 > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+    if (q15 < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+    return (int16_t)q15;
+}
+
+static void check_scale(int16_t x, int16_t gain)
+{
+    int16_t expected = exact_q15((double)x * gain);
+    int16_t model = dsp_q15_scale(x, gain);
+    int16_t mpy32 = mpy32_q15_scale(x, gain);
+
+    if ((model != expected) || (mpy32 != expected))
+    {
+        fprintf(stderr, "scale(%d, %d): model %d, MPY32 %d, expected %d\n", x, gain, model, mpy32, expected);
+        CHECK(0);
+    }
+}
+
+static void check_dot(const int16_t *a, const int16_t *b, uint8_t n)
+{
+    double products = 0;
+    uint8_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        products += (double)a[i] * b[i];
+    }
+
+    int16_t expected = exact_q15(products);
+    int16_t model = dsp_q15_dot(a, b, n);
+    int16_t mpy32 = mpy32_q15_dot(a, b, n);
+
+    if ((model != expected) || (mpy32 != expected))
+    {
+        fprintf(stderr, "dot(n = %u): model %d, MPY32 %d, expected %d\n", n, model, mpy32, expected);
+        CHECK(0);
+    }
+}
+
+static void test_scale(void)
+{
+    static const int16_t gains[] = { 0, 1, -1, 3277, 5898, 16384, -16384, INT16_MAX, INT16_MIN };
+    unsigned i;
+    int32_t x;
+
+    // every input for the gains in use and the corners
+    for (i = 0; i < sizeof gains / sizeof gains[0]; i++)
+    {
+        for (x = INT16_MIN; x <= INT16_MAX; x++)
+        {
+            check_scale((int16_t)x, gains[i]);
+        }
+    }
+
+    for (i = 0; i < RANDOM_PAIRS; i++)
+    {
+        check_scale((int16_t)next_random(), (int16_t)next_random());
+    }
+
+    // -1 * -1 is the one product that saturates
+    CHECK_EQ(dsp_q15_scale(INT16_MIN, INT16_MIN), INT16_MAX);
+    CHECK_EQ(mpy32_q15_scale(INT16_MIN, INT16_MIN), INT16_MAX);
+}
+
+static void test_dot(void)
+{
+    int16_t weights[MAX_TAPS];
+    int16_t samples[MAX_TAPS];
+    unsigned long v;
+    uint8_t i;
+
+    // non-negative weights summing to at most 1.0, as dsp.h requires, and any samples
+    for (v = 0; v < RANDOM_VECTORS; v++)
+    {
+        uint8_t n = next_random() % (MAX_TAPS + 1);
+        int32_t budget = 32768;
+
+        for (i = 0; i < n; i++)
+        {
+            weights[i] = (int16_t)(next_random() % (budget / (n - i) + 1));
+            budget -= weights[i];
+            samples[i] = (int16_t)next_random();
+        }
+        check_dot(weights, samples, n);
+    }
+
+    // the sum saturates once, at the end
+    static const int16_t ones[2] = { INT16_MAX, INT16_MAX };
+    static const int16_t lows[2] = { INT16_MIN, INT16_MIN };
+    check_dot(ones, ones, 2);
+    check_dot(lows, ones, 2);
+    CHECK_EQ(dsp_q15_dot(ones, ones, 2), INT16_MAX);
+    CHECK_EQ(dsp_q15_dot(lows, ones, 2), INT16_MIN);
+    CHECK_EQ(dsp_q15_dot(ones, ones, 0), 0);
+}
+
+static void test_mode_restored(void)
+{
+    static const int16_t a[3] = { 1000, 2000, 3000 };
+
+    MPY32CTL0 = 0x0003;
+    mpy32_q15_scale(100, 3277);
+    CHECK_EQ(MPY32CTL0, 0x0003);
+    mpy32_q15_dot(a, a, 3);
+    CHECK_EQ(MPY32CTL0, 0x0003);
+}
+
+int main(void)
+{
+    test_scale();
+    test_dot();
+    test_mode_restored();
+    return check_finish("dsp");
+}
@@ -0,0 +1,270 @@
+/**
+ * @file
+ * @brief Tests for the selectable smoothing filters.
+ */
+#include "check.h"
+#include "filter.h"
+#include "icount.h"
+#include "rolling_avg.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t rng_state = 1;
+
+static uint16_t next_sample(void)
+{
+    rng_state = rng_state * 1103515245UL + 12345UL;
+    return (uint16_t)(rng_state >> 16);
+}
+
+// Samples the filter needs before it is ready
+static unsigned samples_to_ready(void)
+{
+    unsigned n = 0;
+
+    while (!filter_ready())
+    {
+        filter_push(0x8000);
+        n++;
+    }
+    return n;
+}
+
+static void test_select(void)
+{
+    CHECK(!filter_select(FILTER_COUNT, 10));
+    CHECK(!filter_select(FILTER_BOXCAR, 0));
+    CHECK(!filter_select(FILTER_MEDIAN, ROLLING_AVG_MAX_WINDOW + 1));
+
+    // a rejected selection leaves the running filter alone
+    CHECK(filter_select(FILTER_BOXCAR, 2));
+    filter_push(100);
+    filter_push(200);
+    CHECK(!filter_select(FILTER_EMA, 0));
+    CHECK(filter_ready());
+    CHECK_EQ(filter_output(), 150);
+}
+
+static void test_ready(void)
+{
+    CHECK(filter_select(FILTER_BOXCAR, 10));
+    CHECK_EQ(samples_to_ready(), 10);
+    CHECK(filter_select(FILTER_EMA, 10));
+    CHECK_EQ(samples_to_ready(), 1);
+    CHECK(filter_select(FILTER_MEDIAN, 10));
+    CHECK_EQ(samples_to_ready(), 11);       // rounded up to odd
+    CHECK(filter_select(FILTER_MEDIAN, 100));
+    CHECK_EQ(samples_to_ready(), FILTER_MEDIAN_MAX_WINDOW);
+    CHECK(filter_select(FILTER_FIR, 1));
+    CHECK_EQ(samples_to_ready(), FILTER_FIR_TAPS);
+}
+
+static void test_constant_input(void)
+{
+    static const uint16_t levels[] = { 0, 1, 0x8000, 40000, 0xFFFF };
+    unsigned kind;
+    unsigned i;
+    unsigned n;
+
+    for (kind = 0; kind < FILTER_COUNT; kind++)
+    {
+        for (i = 0; i < sizeof levels / sizeof levels[0]; i++)
+        {
+            CHECK(filter_select((uint8_t)kind, 16));
+            for (n = 0; n < 300; n++)
+            {
+                filter_push(levels[i]);
+            }
+            // the FIR's Q15 taps may round a full-scale input one code down
+            CHECK(abs((int)filter_output() - (int)levels[i]) <= ((kind == FILTER_FIR) ? 1 : 0));
+        }
+    }
+}
+
+static void test_boxcar(void)
+{
+    static uint16_t history[200];
+    unsigned i;
+
+    CHECK(filter_select(FILTER_BOXCAR, 7));
+    for (i = 0; i < 200; i++)
+    {
+        history[i] = next_sample();
+        filter_push(history[i]);
+        if (i >= 6)
+        {
+            uint32_t sum = 0;
+            unsigned j;
+            for (j = i - 6; j <= i; j++)
+            {
+                sum += history[j];
+            }
+            CHECK_EQ(filter_output(), (sum + 3) / 7);
+        }
+    }
+}
+
+static int compare_u16(const void *a, const void *b)
+{
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+static void test_median(void)
+{
+    static uint16_t history[5000];
+    uint16_t window[FILTER_MEDIAN_MAX_WINDOW];
+    unsigned size;
+    unsigned i;
+
+    // small values so the window often holds duplicates
+    for (size = 1; size <= FILTER_MEDIAN_MAX_WINDOW; size += 2)
+    {
+        CHECK(filter_select(FILTER_MEDIAN, (uint8_t)size));
+        for (i = 0; i < 5000; i++)
+        {
+            history[i] = next_sample() % 50;
+            filter_push(history[i]);
+            if (i + 1 >= size)
+            {
+                memcpy(window, &history[i + 1 - size], size * sizeof window[0]);
+                qsort(window, size, sizeof window[0], compare_u16);
+                CHECK_EQ(filter_output(), window[size / 2]);
+            }
+        }
+    }
+
+    // a single spike doesn't get through
+    CHECK(filter_select(FILTER_MEDIAN, 5));
+    for (i = 0; i < 20; i++)
+    {
+        filter_push((i == 10) ? 60000 : 30000);
+        CHECK((i < 4) || (filter_output() == 30000));
+    }
+}
+
+static void test_ema(void)
+{
+    uint16_t last = 0;
+    unsigned i;
+
+    // step response rises steadily towards the new level without overshoot
+    CHECK(filter_select(FILTER_EMA, 16));
+    filter_push(10000);
+    CHECK_EQ(filter_output(), 10000);
+    for (i = 0; i < 400; i++)
+    {
+        filter_push(50000);
+        CHECK(filter_output() >= last);
+        CHECK(filter_output() <= 50000);
+        last = filter_output();
+    }
+    CHECK(last >= 49990);
+}
+
+static void test_fir(void)
+{
+    static const double taps[FILTER_FIR_TAPS] = { 415, 1780, 5417, 8772, 8772, 5417, 1780, 415 };
+    uint16_t history[FILTER_FIR_TAPS] = { 0 };
+    unsigned i;
+    unsigned j;
+
+    CHECK(filter_select(FILTER_FIR, 1));
+    for (i = 0; i < 2000; i++)
+    {
+        double expected = 0;
+
+        for (j = FILTER_FIR_TAPS - 1; j > 0; j--)
+        {
+            history[j] = history[j - 1];
+        }
+        history[0] = next_sample();
+        filter_push(history[0]);
+
+        if (i + 1 >= FILTER_FIR_TAPS)
+        {
+            for (j = 0; j < FILTER_FIR_TAPS; j++)
+            {
+                expected += taps[j] * ((double)history[j] - 0x8000) / 32768.0;
+            }
+            CHECK(fabs(filter_output() - (expected + 0x8000)) <= 1.0);
+        }
+    }
+}
+
+// Per-sample budgets, in host instructions for filter_push plus filter_output
+// (see icount.h: these bound how each filter's cost scales, not its MSP430
+// cycles). Measured worst cases are 64, 34, 294 and 120, the median's at
+// its largest window; only the median's grows with the window.
+static const unsigned long budgets[FILTER_COUNT] = {
+    [FILTER_BOXCAR] = 80,
+    [FILTER_EMA] = 50,
+    [FILTER_MEDIAN] = 360,
+    [FILTER_FIR] = 150,
+};
+
+static volatile uint16_t sink;
+
+// What ADC_ISR does with one decimated sample, and the output the display takes
+static void push_and_output(void *arg)
+{
+    filter_push(*(const uint16_t *)arg);
+    sink = filter_output();
+}
+
+static void test_budgets(void)
+{
+    static const uint8_t sizes[] = {1, 3, FILTER_MEDIAN_MAX_WINDOW, ROLLING_AVG_MAX_WINDOW};
+    uint8_t kind;
+    unsigned i;
+
+    if (!icount_available())
+    {
+        printf("filter: can't count instructions here, budget check skipped\n");
+        return;
+    }
+    for (kind = 0; kind < FILTER_COUNT; kind++)
+    {
+        for (i = 0; i < sizeof(sizes); i++)
+        {
+            unsigned long worst = 0;
+            unsigned n;
+
+            CHECK(filter_select(kind, sizes[i]));
+            for (n = 0; n < 2 * ROLLING_AVG_MAX_WINDOW; n++)
+            {
+                filter_push(next_sample());
+            }
+
+            // full-scale swings alternate ends of the median's window; random samples land anywhere
+            for (n = 0; n < 32; n++)
+            {
+                uint16_t sample = (n < 16) ? ((n & 1) ? 0xFFFF : 0) : next_sample();
+                unsigned long count = icount(push_and_output, &sample);
+
+                worst = (count > worst) ? count : worst;
+                filter_push(sample);
+            }
+            if ((worst == 0) || (worst > budgets[kind]))
+            {
+                fprintf(stderr, "filter %u, size %u: %lu instructions, budget %lu\n", kind, sizes[i], worst,
+                        budgets[kind]);
+                check_failures++;
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    test_select();
+    test_ready();
+    test_constant_input();
+    test_boxcar();
+    test_median();
+    test_ema();
+    test_fir();
+    test_budgets();
+    return check_finish("filter");
+}
@@ -0,0 +1,163 @@
+/**
+ * @file
+ * @brief Tests for the fixed-width formatters against snprintf.
+ */
+#include "check.h"
+#include "fmt.h"
+#include "icount.h"
+
+#include <string.h>
+
+// Field plus a guard byte on each side to catch writes outside it
+#define FIELD_MAX 8
+#define GUARD '~'
+
+static char buffer[FIELD_MAX + 2];
+static char *const field = buffer + 1;
+
+static void clear(void)
+{
+    memset(buffer, GUARD, sizeof buffer);
+}
+
+// The field snprintf would produce, or all '#' if it doesn't fit in width
+static void expected_field(char *expected, const char *printed, uint8_t width)
+{
+    if (strlen(printed) > width)
+    {
+        memset(expected, '#', width);
+    }
+    else
+    {
+        memcpy(expected, printed, width);
+    }
+}
+
+// Check the field matches and nothing outside it was touched
+static int field_is(const char *expected, uint8_t width)
+{
+    return (memcmp(field, expected, width) == 0) && (buffer[0] == GUARD) && (field[width] == GUARD);
+}
+
+static void test_uint(void)
+{
+    char printed[16];
+    char expected[FIELD_MAX];
+    uint32_t value;
+    uint8_t width;
+
+    for (width = 1; width <= 6; width++)
+    {
+        for (value = 0; value <= 0xFFFF; value++)
+        {
+            snprintf(printed, sizeof printed, "%0*lu", width, (unsigned long)value);
+            expected_field(expected, printed, width);
+            clear();
+            fmt_uint(field, (uint16_t)value, width);
+            if (!field_is(expected, width))
+            {
+                fprintf(stderr, "fmt_uint(%lu, %u) gave \"%.*s\"\n", (unsigned long)value, width, width, field);
+                CHECK(0);
+            }
+        }
+    }
+}
+
+static void test_fixed1(void)
+{
+    char printed[16];
+    char expected[FIELD_MAX];
+    int32_t tenths;
+    uint8_t width;
+
+    for (width = 3; width <= FIELD_MAX; width++)
+    {
+        for (tenths = -32768; tenths <= 32767; tenths++)
+        {
+            long magnitude = (tenths < 0) ? -(long)tenths : tenths;
+            char number[16];
+
+            snprintf(number, sizeof number, "%s%ld.%ld", (tenths < 0) ? "-" : "", magnitude / 10, magnitude % 10);
+            snprintf(printed, sizeof printed, "%*s", width, number);
+            expected_field(expected, printed, width);
+            clear();
+            fmt_fixed1(field, (int16_t)tenths, width);
+            if (!field_is(expected, width))
+            {
+                fprintf(stderr, "fmt_fixed1(%ld, %u) gave \"%.*s\"\n", (long)tenths, width, width, field);
+                CHECK(0);
+            }
+        }
+    }
+}
+
+static void test_examples(void)
+{
+    clear();
+    fmt_uint(field, 7, 3);
+    CHECK(field_is("007", 3));
+
+    clear();
+    fmt_uint(field, 1000, 3);
+    CHECK(field_is("###", 3));
+
+    clear();
+    fmt_fixed1(field, 234, 5);
+    CHECK(field_is(" 23.4", 5));
+
+    clear();
+    fmt_fixed1(field, -123, 5);
+    CHECK(field_is("-12.3", 5));
+
+    clear();
+    fmt_fixed1(field, 5, 3);
+    CHECK(field_is("0.5", 3));
+
+    clear();
+    fmt_fixed1(field, -5, 3);
+    CHECK(field_is("###", 3));
+}
+
+// The temperature and window fields as show_average() and the window commit write them
+static void fields_fmt(void *arg)
+{
+    (void)arg;
+    fmt_fixed1(field, -123, 5);
+    fmt_uint(field, 7, 3);
+}
+
+// The same fields with the sprintf calls they replaced
+static void fields_sprintf(void *arg)
+{
+    char printed[16];
+    int average = -123;
+
+    (void)arg;
+    sprintf(printed, "%2d.%1d", average / 10, average % 10);
+    sprintf(printed, "%03d", 7);
+}
+
+static void test_cost(void)
+{
+    unsigned long fmt;
+    unsigned long printf_family;
+
+    if (!icount_available())
+    {
+        printf("fmt: can't count instructions here, cost check skipped\n");
+        return;
+    }
+    fmt = icount(fields_fmt, 0);
+    printf_family = icount(fields_sprintf, 0);
+    CHECK(fmt > 0);
+    CHECK(fmt * 10 < printf_family);
+}
+
+int main(void)
+{
+    test_uint();
+    test_fixed1();
+    test_examples();
+    test_cost();
+    return check_finish("fmt");
+}
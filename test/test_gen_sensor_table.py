@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""Check tools/gen_sensor_table.py.
+
+Regenerating from central/sensors/lm19.json must reproduce the checked-in
+central/lm19_table.c and lm19_table.h. Tables for a polynomial and a
+piecewise sensor are compiled with a small driver, and the lookup at every
+code must stay within the error the generated header states. Malformed
+descriptions must be rejected with a message and write nothing.
+
+Usage: python3 test_gen_sensor_table.py [C compiler]
+"""
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+GENERATOR = os.path.join(ROOT, "tools", "gen_sensor_table.py")
+
+# Prints <name>_lookup() of every code up to 2^adc_bits, one per line
+DRIVER = """
+#include SENSOR_HEADER
+#include <stdio.h>
+
+int main(void)
+{
+    unsigned long code;
+
+    for (code = 0; code <= (1UL << ADC_BITS) && code <= 0xFFFF; code++)
+    {
+        printf("%d\\n", LOOKUP((uint16_t)code));
+    }
+    return 0;
+}
+"""
+
+# A linear sensor at 10 mV per degree, in tenths of a degree, on a 12-bit ADC
+POLYNOMIAL = {
+    "name": "lin10mv",
+    "description": "10 mV/C sensor, 12-bit code to tenths of a degree C.",
+    "model": "polynomial",
+    "params": {"coeffs": [0, 100, 0.5]},
+    "adc_bits": 12,
+    "vref": 1.5,
+    "table_shift": 5,
+    "scale": 10,
+}
+
+# An NTC divider described by its datasheet points, on a 10-bit ADC
+PIECEWISE = {
+    "name": "ntc",
+    "description": "NTC divider, 10-bit code to hundredths of a degree C.",
+    "model": "piecewise",
+    "params": {"points": [[0.0, 125.0], [0.6, 70.0], [1.2, 40.0], [2.0, 15.0], [2.8, -10.0], [3.3, -40.0]]},
+    "adc_bits": 10,
+    "vref": 3.3,
+    "table_shift": 3,
+    "scale": 100,
+}
+
+failures = 0
+
+
+def fail(message):
+    global failures
+    failures += 1
+    sys.stderr.write("gen_sensor_table: %s\n" % message)
+
+
+def generate(desc_path, out_dir):
+    return subprocess.run([sys.executable, "-B", GENERATOR, desc_path, out_dir], capture_output=True, text=True)
+
+
+def write_desc(tmp, name, desc):
+    path = os.path.join(tmp, name + ".json")
+    with open(path, "w") as f:
+        f.write(desc if isinstance(desc, str) else json.dumps(desc))
+    return path
+
+
+def model(desc):
+    params = desc["params"]
+    if desc["model"] == "polynomial":
+        return lambda v: sum(c * v ** n for n, c in enumerate(params["coeffs"]))
+    points = params["points"]
+
+    def piecewise(v):
+        for (v0, y0), (v1, y1) in zip(points, points[1:]):
+            if v < v1 or (v1, y1) == tuple(points[-1]):
+                return y0 + (y1 - y0) * (v - v0) / (v1 - v0)
+
+    return piecewise
+
+
+def test_lm19(tmp):
+    out = os.path.join(tmp, "lm19")
+    os.mkdir(out)
+    result = generate(os.path.join(ROOT, "central", "sensors", "lm19.json"), out)
+    if result.returncode != 0:
+        fail("lm19.json: %s" % result.stderr.strip())
+        return
+    for name in ("lm19_table.c", "lm19_table.h"):
+        with open(os.path.join(out, name)) as f, open(os.path.join(ROOT, "central", name)) as g:
+            if f.read() != g.read():
+                fail("regenerating from lm19.json changes central/%s" % name)
+
+
+def test_lookup(tmp, cc, desc):
+    name = desc["name"]
+    out = os.path.join(tmp, name)
+    os.mkdir(out)
+    result = generate(write_desc(tmp, name, desc), out)
+    if result.returncode != 0:
+        fail("%s: %s" % (name, result.stderr.strip()))
+        return
+
+    with open(os.path.join(out, name + "_table.h")) as f:
+        max_error = float(re.search(r"deviation from the model is ([0-9.]+)", f.read()).group(1))
+    driver = os.path.join(out, "driver.c")
+    with open(driver, "w") as f:
+        f.write(DRIVER)
+    binary = os.path.join(out, "lookup")
+    subprocess.run(cc.split() + ["-std=c99", "-Wall", "-Wextra", "-Werror", "-I" + out,
+                                 '-DSENSOR_HEADER="%s_table.h"' % name, "-DADC_BITS=%d" % desc["adc_bits"],
+                                 "-DLOOKUP=%s_lookup" % name, "-o", binary, driver,
+                                 os.path.join(out, name + "_table.c")], check=True)
+    lookups = [int(line) for line in subprocess.run([binary], check=True, capture_output=True,
+                                                    text=True).stdout.split()]
+
+    # within the stated error plus the rounding of each entry, and clamped past the top code
+    y = model(desc)
+    code_max = (1 << desc["adc_bits"]) - 1
+    worst = max(abs(lookups[code] / desc["scale"] - y(code * desc["vref"] / code_max)) for code in range(code_max + 1))
+    if worst > max_error + 0.5 / desc["scale"]:
+        fail("%s: lookup is %.4f from the model, header says %.4f" % (name, worst, max_error))
+    if lookups[code_max + 1] != lookups[code_max]:
+        fail("%s: code %d is not clamped" % (name, code_max + 1))
+
+
+def test_rejected(tmp):
+    def changed(**fields):
+        desc = dict(POLYNOMIAL, **fields)
+        return {k: v for k, v in desc.items() if v is not None}
+
+    bad = {
+        "syntax": '{"name": "bad", "model": "polynomial",',
+        "not_object": "[1, 2, 3]",
+        "missing_field": changed(vref=None),
+        "bad_name": changed(name="2bad"),
+        "float_bits": changed(adc_bits=12.5),
+        "zero_vref": changed(vref=0),
+        "unknown_model": changed(model="cubic"),
+        "no_coeffs": changed(params={"coeffs": []}),
+        "missing_param": changed(model="sqrt", params={"a": 1, "b": 2, "c": 3}),
+        "sqrt_domain": changed(model="sqrt", params={"a": 0, "b": -1, "c": 0, "d": 1}),
+        "descending": changed(model="piecewise", params={"points": [[0, 0], [2, 1], [1, 2]]}),
+        "one_point": changed(model="piecewise", params={"points": [[0, 0]]}),
+        "zero_shift": changed(table_shift=0),
+        "wide_adc": changed(adc_bits=17),
+        "overflow": changed(scale=10000),
+    }
+    for name, desc in bad.items():
+        out = os.path.join(tmp, "bad_" + name)
+        os.mkdir(out)
+        result = generate(write_desc(tmp, "bad_" + name, desc), out)
+        if result.returncode == 0 or not result.stderr.strip():
+            fail("%s: accepted" % name)
+        elif "Traceback" in result.stderr:
+            fail("%s: crashed instead of rejecting it:\n%s" % (name, result.stderr))
+        if os.listdir(out):
+            fail("%s: wrote %s" % (name, ", ".join(os.listdir(out))))
+
+
+def main():
+    if len(sys.argv) > 2:
+        sys.exit(__doc__)
+    cc = sys.argv[1] if len(sys.argv) == 2 else "cc"
+
+    with tempfile.TemporaryDirectory() as tmp:
+        test_lm19(tmp)
+        test_lookup(tmp, cc, POLYNOMIAL)
+        test_lookup(tmp, cc, PIECEWISE)
+        test_rejected(tmp)
+
+    if failures:
+        sys.exit("gen_sensor_table: %d check(s) failed" % failures)
+    print("gen_sensor_table: ok")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,268 @@
+/**
+ * @file
+ * @brief Tests for the keypad: the debounce integrators fed scan by scan, then the wake-up on the simulator.
+ */
+#include "check.h"
+#include "key_matrix.h"
+#include "keypad.h"
+#include "sim.h"
+#include <msp430.h>
+
+void PORT2_ISR(void);
+void KEYPAD_SCAN_ISR(void);
+
+// keypad_scan_step bits, in keypad order
+#define KEY_1 (1u << 0)
+#define KEY_5 (1u << 5)
+#define ALL_KEYS 0xFFFFu
+
+// Feed the same raw reading for a number of scans
+static bool scans(uint16_t raw, unsigned count)
+{
+    bool busy = true;
+
+    while (count--)
+    {
+        busy = keypad_scan_step(raw);
+    }
+    return busy;
+}
+
+// Number of queued events, emptying the queue
+static unsigned drain(void)
+{
+    struct keypad_event event;
+    unsigned count = 0;
+
+    while (keypad_get_event(&event))
+    {
+        count++;
+    }
+    return count;
+}
+
+// Release everything and empty the queue, so each test starts idle
+static void settle(void)
+{
+    CHECK(!scans(0, KEYPAD_DEBOUNCE_SCANS));
+    drain();
+}
+
+static void expect_event(char key, uint8_t type)
+{
+    struct keypad_event event;
+
+    CHECK(keypad_get_event(&event));
+    CHECK_EQ(event.key, key);
+    CHECK_EQ(event.type, type);
+}
+
+static void test_bounce_rejected(void)
+{
+    unsigned i;
+
+    // contact bounce: never KEYPAD_DEBOUNCE_SCANS down in a row
+    for (i = 0; i < 50; i++)
+    {
+        scans(KEY_1, KEYPAD_DEBOUNCE_SCANS - 1);
+        scans(0, KEYPAD_DEBOUNCE_SCANS - 1);
+    }
+    CHECK(!keypad_has_event());
+
+    // a single glitch, then released: the integrator winds down and scanning can stop
+    CHECK(scans(KEY_1, KEYPAD_DEBOUNCE_SCANS - 1));
+    CHECK(!scans(0, KEYPAD_DEBOUNCE_SCANS - 1));
+    CHECK(!keypad_has_event());
+    settle();
+}
+
+static void test_press_release(void)
+{
+    // the press lands on the scan the integrator fills
+    CHECK(scans(KEY_5, KEYPAD_DEBOUNCE_SCANS - 1));
+    CHECK(!keypad_has_event());
+    CHECK(scans(KEY_5, 1));
+    expect_event('5', KEYPAD_PRESS);
+    CHECK(!keypad_has_event());
+
+    // a short drop-out while held is absorbed
+    scans(0, KEYPAD_DEBOUNCE_SCANS - 1);
+    scans(KEY_5, KEYPAD_DEBOUNCE_SCANS);
+    CHECK(!keypad_has_event());
+
+    // the release lands on the scan it empties
+    CHECK(scans(0, KEYPAD_DEBOUNCE_SCANS - 1));
+    CHECK(!keypad_has_event());
+    CHECK(!scans(0, 1));
+    expect_event('5', KEYPAD_RELEASE);
+    CHECK(!keypad_has_event());
+}
+
+static void test_long_press_and_repeat(void)
+{
+    unsigned repeat;
+
+    scans(KEY_1, KEYPAD_DEBOUNCE_SCANS);
+    expect_event('1', KEYPAD_PRESS);
+
+    // KEYPAD_LONG_PRESS_SCANS after the press, not before
+    scans(KEY_1, KEYPAD_LONG_PRESS_SCANS - 1);
+    CHECK(!keypad_has_event());
+    scans(KEY_1, 1);
+    expect_event('1', KEYPAD_LONG_PRESS);
+
+    // then every KEYPAD_REPEAT_SCANS
+    for (repeat = 0; repeat < 3; repeat++)
+    {
+        scans(KEY_1, KEYPAD_REPEAT_SCANS - 1);
+        CHECK(!keypad_has_event());
+        scans(KEY_1, 1);
+        expect_event('1', KEYPAD_REPEAT);
+    }
+
+    scans(0, KEYPAD_DEBOUNCE_SCANS);
+    expect_event('1', KEYPAD_RELEASE);
+    CHECK(!keypad_has_event());
+}
+
+static void test_rollover(void)
+{
+    // 5 goes down while 1 is held; each is reported on its own
+    scans(KEY_1, KEYPAD_DEBOUNCE_SCANS);
+    scans(KEY_1 | KEY_5, KEYPAD_DEBOUNCE_SCANS);
+    scans(KEY_5, KEYPAD_DEBOUNCE_SCANS);
+    scans(0, KEYPAD_DEBOUNCE_SCANS);
+    expect_event('1', KEYPAD_PRESS);
+    expect_event('5', KEYPAD_PRESS);
+    expect_event('1', KEYPAD_RELEASE);
+    expect_event('5', KEYPAD_RELEASE);
+    CHECK(!keypad_has_event());
+}
+
+static void test_queue_overflow(void)
+{
+    struct keypad_event event;
+
+    // 16 presses fill the queue; the 16 releases after them are dropped
+    scans(ALL_KEYS, KEYPAD_DEBOUNCE_SCANS);
+    scans(0, KEYPAD_DEBOUNCE_SCANS);
+    CHECK(keypad_get_event(&event));
+    CHECK_EQ(event.key, '1');
+    CHECK_EQ(event.type, KEYPAD_PRESS);
+    CHECK_EQ(drain(), KEYPAD_QUEUE_LEN - 1);
+
+    // room again once drained
+    scans(KEY_5, KEYPAD_DEBOUNCE_SCANS);
+    expect_event('5', KEYPAD_PRESS);
+    settle();
+}
+
+// Power on with the keypad wired to the matrix and set up as main() does
+static void keypad_boot(void)
+{
+    sim_reset();
+    sim_vector(PORT2_VECTOR, PORT2_ISR);
+    sim_vector(TIMER2_B0_VECTOR, KEYPAD_SCAN_ISR);
+    key_matrix_attach();
+    keypad_setup();
+    PM5CTL0 &= ~LOCKLPM5;
+}
+
+static void test_edge_wake(void)
+{
+    keypad_boot();
+
+    // idle: no scanning, the CPU sleeps through
+    sim_sleep(LPM3_bits, SIM_MS(500));
+    CHECK_EQ(sim_isr_count(TIMER2_B0_VECTOR), 0);
+    CHECK_EQ(sim_wakeups(), 0);
+    CHECK_EQ(P2IE & 0x0F, 0x0F);
+
+    // a press wakes the scan timer, which reports it and stops once released
+    key_matrix_set_at(SIM_MS(600), '5', true);
+    key_matrix_set_at(SIM_MS(700), '5', false);
+    sim_sleep(LPM3_bits, SIM_MS(300));
+    CHECK_EQ(sim_isr_count(PORT2_VECTOR), 1);
+    CHECK_EQ(sim_wakeups(), 2);
+    expect_event('5', KEYPAD_PRESS);
+    expect_event('5', KEYPAD_RELEASE);
+    CHECK(!keypad_has_event());
+    CHECK_EQ(TB2CTL & MC_3, MC__STOP);
+    CHECK_EQ(P2IE & 0x0F, 0x0F);
+
+    // and stays stopped
+    {
+        unsigned long scans = sim_isr_count(TIMER2_B0_VECTOR);
+        sim_sleep(LPM3_bits, SIM_MS(500));
+        CHECK_EQ(sim_isr_count(TIMER2_B0_VECTOR), scans);
+    }
+}
+
+// Scans run by time t for a press of '5' at 10 ms released at 60 ms: the last
+// one, which re-arms the wake-up, is the (KEYPAD_DEBOUNCE_SCANS)th after the release
+static unsigned long scans_by(sim_time t)
+{
+    keypad_boot();
+    key_matrix_set_at(SIM_MS(10), '5', true);
+    key_matrix_set_at(SIM_MS(60), '5', false);
+    sim_sleep(LPM3_bits, t);
+    return sim_isr_count(TIMER2_B0_VECTOR);
+}
+
+static void test_rearm_race(void)
+{
+    sim_time lo = SIM_MS(60);
+    sim_time hi = SIM_MS(200);
+    unsigned long last = scans_by(hi);
+    sim_time press;
+    unsigned missed = 0;
+
+    // when the last scan starts
+    while (hi - lo > SIM_NS(100))
+    {
+        sim_time mid = lo + (hi - lo) / 2;
+        if (scans_by(mid) == last)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid;
+        }
+    }
+
+    // '1' goes down at every microsecond around it, including between the
+    // scan reading the rows and P2IE being set again. That edge is cleared
+    // with P2IFG and never interrupts; without arm_wake's P2IN check, presses
+    // in a window of about 34 us are lost.
+    for (press = hi - SIM_US(20); press < hi + SIM_US(200); press += SIM_US(1))
+    {
+        struct keypad_event event;
+        bool seen = false;
+
+        keypad_boot();
+        key_matrix_set_at(SIM_MS(10), '5', true);
+        key_matrix_set_at(SIM_MS(60), '5', false);
+        key_matrix_set_at(press, '1', true);
+        sim_sleep(LPM3_bits, press + SIM_MS(100));
+        while (keypad_get_event(&event))
+        {
+            seen |= (event.key == '1') && (event.type == KEYPAD_PRESS);
+        }
+        missed += !seen;
+    }
+    CHECK_EQ(missed, 0);
+}
+
+int main(void)
+{
+    settle();
+    test_bounce_rejected();
+    test_press_release();
+    test_long_press_and_repeat();
+    test_rollover();
+    test_queue_overflow();
+    test_edge_wake();
+    test_rearm_race();
+    return check_finish("keypad");
+}
@@ -0,0 +1,120 @@
+/**
+ * @file
+ * @brief The LCD node image on the simulator: boot, then frames over I2C drawn on an HD44780.
+ */
+#include "check.h"
+#include "hd44780.h"
+#include "lcd_protocol.h"
+#include "sim.h"
+#include <msp430.h>
+#include <string.h>
+
+#define LCD_ADDR 0x40
+
+int lcd_main(void);
+void EUSCI_B0_I2C_ISR(void);
+
+static void boot(void)
+{
+    sim_reset();
+    sim_vector(EUSCI_B0_VECTOR, EUSCI_B0_I2C_ISR);
+    hd44780_attach(false);
+    sim_boot(lcd_main);
+    sim_run(SIM_MS(200));
+}
+
+// Send the whole of frame as one span, as lcd_link does for a first update
+static bool send_frame(const char *frame, uint16_t crc)
+{
+    uint8_t buf[LCD_MAX_TRANSACTION_LEN];
+
+    buf[0] = 0;
+    buf[1] = LCD_FRAME_LEN;
+    memcpy(&buf[LCD_SPAN_HEADER_LEN], frame, LCD_FRAME_LEN);
+    buf[LCD_SPAN_HEADER_LEN + LCD_FRAME_LEN] = crc >> 8;
+    buf[LCD_SPAN_HEADER_LEN + LCD_FRAME_LEN + 1] = crc & 0xFF;
+    return sim_i2c_send(LCD_ADDR, buf, sizeof(buf));
+}
+
+static void test_boot(void)
+{
+    char row[17];
+
+    boot();
+    hd44780_row(0, row);
+    CHECK(strcmp(row, "Ready           ") == 0);
+    CHECK_EQ(hd44780_stats()->busy_writes, 0);
+}
+
+static void test_frame(void)
+{
+    const char *frame = "LOCKED          T= 23.4C   N=003";
+    char row[17];
+
+    boot();
+    CHECK(send_frame(frame, sim_crc16(LCD_CRC_SEED, (const uint8_t *)frame, LCD_FRAME_LEN)));
+    sim_run(SIM_MS(20));
+    hd44780_row(0, row);
+    CHECK(strcmp(row, "LOCKED          ") == 0);
+    hd44780_row(1, row);
+    CHECK(strcmp(row, "T= 23.4C   N=003") == 0);
+    CHECK_EQ(hd44780_stats()->busy_writes, 0);
+}
+
+static void test_bad_crc(void)
+{
+    const char *frame = "UNLOCKED                        ";
+    char row[17];
+
+    boot();
+    CHECK(send_frame(frame, sim_crc16(LCD_CRC_SEED, (const uint8_t *)frame, LCD_FRAME_LEN) ^ 1));
+    sim_run(SIM_MS(20));
+    hd44780_row(0, row);
+    CHECK(strcmp(row, "Ready           ") == 0);
+}
+
+static void test_resync(void)
+{
+    const char *frame = "Avg:  23.4 C    Monitoring      ";
+    const char *drift = "Avg:  23.5 C    Monitoring      ";
+    uint8_t span[] = {9, 1, '5', 0, 0};
+    uint16_t crc = sim_crc16(LCD_CRC_SEED, (const uint8_t *)frame, LCD_FRAME_LEN);
+    unsigned long writes;
+    char row[17];
+
+    boot();
+    CHECK(send_frame(frame, crc));
+    sim_run(SIM_MS(20));
+
+    // a span that arrives corrupted is dropped, leaving the old digit shown
+    crc = sim_crc16(LCD_CRC_SEED, (const uint8_t *)drift, LCD_FRAME_LEN);
+    span[3] = crc >> 8;
+    span[4] = (crc & 0xFF) ^ 1;
+    CHECK(sim_i2c_send(LCD_ADDR, span, sizeof(span)));
+    sim_run(SIM_MS(20));
+    hd44780_row(0, row);
+    CHECK(strcmp(row, "Avg:  23.4 C    ") == 0);
+
+    // the controller's next full-frame resend repairs it
+    writes = hd44780_stats()->data_writes;
+    CHECK(send_frame(drift, crc));
+    sim_run(SIM_MS(20));
+    hd44780_row(0, row);
+    CHECK(strcmp(row, "Avg:  23.5 C    ") == 0);
+    CHECK(hd44780_stats()->data_writes > writes);
+
+    // and a resend with nothing lost draws nothing
+    writes = hd44780_stats()->data_writes;
+    CHECK(send_frame(drift, crc));
+    sim_run(SIM_MS(20));
+    CHECK_EQ(hd44780_stats()->data_writes, writes);
+}
+
+int main(void)
+{
+    test_boot();
+    test_frame();
+    test_bad_crc();
+    test_resync();
+    return check_finish("lcd");
+}
@@ -0,0 +1,164 @@
+/**
+ * @file
+ * @brief The LED bar image on the simulator: frames over I2C, steps and bit-plane refresh.
+ */
+#include "check.h"
+#include "icount.h"
+#include "led_bits.h"
+#include "led_protocol.h"
+#include "sim.h"
+#include <msp430.h>
+
+#define LED_ADDR 0x45
+
+int led_bar_main(void);
+void EUSCI_B0_I2C_ISR(void);
+void ISR_TB3_CCR0(void);
+void ISR_TB0_CCR0(void);
+void setPattern(int a);
+extern unsigned int stepIndex;
+
+static void boot(void)
+{
+    sim_reset();
+    sim_vector(EUSCI_B0_VECTOR, EUSCI_B0_I2C_ISR);
+    sim_vector(TIMER1_B0_VECTOR, ISR_TB3_CCR0);
+    sim_vector(TIMER0_B0_VECTOR, ISR_TB0_CCR0);
+    sim_boot(led_bar_main);
+    sim_run(SIM_MS(100));
+}
+
+// Send commands as one frame, with a CRC that is off by corrupt
+static bool send_frame(const uint8_t *cmds, uint8_t len, uint16_t corrupt)
+{
+    uint8_t buf[LED_MAX_TRANSACTION_LEN];
+    uint16_t crc;
+    uint8_t i;
+
+    buf[0] = LED_FRAME_START;
+    buf[1] = len;
+    for (i = 0; i < len; i++)
+    {
+        buf[LED_FRAME_HEADER_LEN + i] = cmds[i];
+    }
+    crc = sim_crc16(LED_CRC_SEED, buf, LED_FRAME_HEADER_LEN + len) ^ corrupt;
+    buf[LED_FRAME_HEADER_LEN + len] = crc >> 8;
+    buf[LED_FRAME_HEADER_LEN + len + 1] = crc & 0xFF;
+    return sim_i2c_send(LED_ADDR, buf, LED_FRAME_HEADER_LEN + len + LED_FRAME_CRC_LEN);
+}
+
+static void test_boot(void)
+{
+    unsigned long planes;
+
+    boot();
+    CHECK_EQ(sim_mclk_hz(), 244UL * 32768);
+    CHECK_EQ(sim_port_dir(1) & LED_P1_PINS, LED_P1_PINS);
+    CHECK_EQ(sim_port_dir(2) & LED_P2_PINS, LED_P2_PINS);
+    CHECK_EQ(sim_port_out(1) & LED_P1_PINS, 0);
+
+    // 6 bit planes, 400 refreshes a second
+    planes = sim_isr_count(TIMER0_B0_VECTOR);
+    sim_run(SIM_MS(100));
+    planes = sim_isr_count(TIMER0_B0_VECTOR) - planes;
+    CHECK((planes >= 238) && (planes <= 242));
+}
+
+static void test_raw(void)
+{
+    const uint8_t raw[] = {LED_CMD_SET_RAW, 0xA5};
+    const uint8_t other[] = {LED_CMD_SET_RAW, 0x5A};
+
+    boot();
+    CHECK(send_frame(raw, sizeof(raw), 0));
+    sim_run(SIM_MS(1100));      // shown from the next step: 4 base periods, 1 s
+    CHECK_EQ(sim_port_out(1) & LED_P1_PINS, LED_P1OUT(0xA5));
+    CHECK_EQ(sim_port_out(2) & LED_P2_PINS, LED_P2OUT(0xA5));
+
+    // a corrupted frame is dropped whole
+    CHECK(send_frame(other, sizeof(other), 1));
+    sim_run(SIM_MS(1100));
+    CHECK_EQ(sim_port_out(1) & LED_P1_PINS, LED_P1OUT(0xA5));
+}
+
+static void call_isr(void *isr)
+{
+    ((void (*)(void))isr)();
+}
+
+// SFR accesses and simulated MCLK cycles of one call of an ISR, plus its
+// entry and exit
+static unsigned long isr_accesses;
+static unsigned long isr_cycles;
+
+static void measure_isr(void (*isr)(void))
+{
+    unsigned long accesses = sim_sfr_accesses();
+    sim_time start = sim_now();
+
+    isr();
+    isr_accesses = sim_sfr_accesses() - accesses;
+    isr_cycles = SIM_ISR_ENTRY_CYCLES + SIM_ISR_EXIT_CYCLES
+        + (unsigned long)(((sim_now() - start) * sim_mclk_hz() + SIM_MS(500)) / SIM_MS(1000));
+}
+
+static void test_isr_cost(void)
+{
+    int p;
+    int k;
+
+    // called directly, with no image running
+    sim_reset();
+
+    // a bit plane: store P1OUT, read and write P2OUT, move TB0CCR0 on and
+    // check it against TB0R, the same for every plane. The simulator charges
+    // 29 cycles for that and entry and exit; the two loads from the plane
+    // table and the plane count come on top, well inside the 64 the build
+    // allows for with BCM_ISR_CYCLES.
+    for (k = 0; k < 6; k++)
+    {
+        measure_isr(ISR_TB0_CCR0);
+        CHECK_EQ(isr_accesses, 6);
+        CHECK_EQ(isr_cycles, SIM_ISR_ENTRY_CYCLES + SIM_ISR_EXIT_CYCLES + 6 * SIM_ACCESS_CYCLES);
+    }
+
+    // a step: the only register it touches is the flag it clears
+    setPattern(2);
+    measure_isr(ISR_TB3_CCR0);
+    CHECK_EQ(isr_accesses, 1);
+
+    if (!icount_available())
+    {
+        return;
+    }
+
+    // a step costs the same host instructions at every step of the on/off
+    // patterns, the wrap included: the index wraps by compare
+    for (p = 0; p < 8; p++)
+    {
+        static const unsigned int steps[] = {0, 1, 5, 7, 255};
+        unsigned long low = ~0UL;
+        unsigned long high = 0;
+        unsigned s;
+
+        setPattern(p);
+        for (s = 0; s < sizeof(steps) / sizeof(steps[0]); s++)
+        {
+            unsigned long n;
+
+            stepIndex = steps[s];
+            n = icount(call_isr, (void *)ISR_TB3_CCR0);
+            low = (n < low) ? n : low;
+            high = (n > high) ? n : high;
+        }
+        CHECK(high - low <= 2);
+    }
+}
+
+int main(void)
+{
+    test_boot();
+    test_raw();
+    test_isr_cost();
+    return check_finish("led_bar");
+}
@@ -0,0 +1,67 @@
+/**
+ * @file
+ * @brief CPU time the LED bar's bit-plane refresh takes, for the image built at each BCM_BITS.
+ *
+ * The Makefile builds the image and this test once per bit depth, with
+ * -DBCM_BITS. The simulator charges the ISR for entry, exit and its register
+ * accesses (see sim.h), so the figures leave out its few table loads.
+ */
+#include "check.h"
+#include "led_protocol.h"
+#include "sim.h"
+#include <msp430.h>
+#include <stdio.h>
+
+#define LED_ADDR 0x45
+#define REFRESH_HZ 400
+
+// Plane ticks as led_bar/main.c rounds them; the refresh runs a little fast as they shrink
+#define LSB_TICKS (8000000UL / REFRESH_HZ / ((1 << BCM_BITS) - 1))
+
+int led_bar_main(void);
+void EUSCI_B0_I2C_ISR(void);
+void ISR_TB3_CCR0(void);
+void ISR_TB0_CCR0(void);
+
+int main(void)
+{
+    uint8_t frame[LED_FRAME_HEADER_LEN + 2 + LED_FRAME_CRC_LEN] = {LED_FRAME_START, 2, LED_CMD_SET_PATTERN, 8};
+    uint16_t crc = sim_crc16(LED_CRC_SEED, frame, LED_FRAME_HEADER_LEN + 2);
+    unsigned long planes;
+    sim_time busy;
+    double expected;
+    double utilisation;
+    char name[16];
+
+    sim_reset();
+    sim_vector(EUSCI_B0_VECTOR, EUSCI_B0_I2C_ISR);
+    sim_vector(TIMER1_B0_VECTOR, ISR_TB3_CCR0);
+    sim_vector(TIMER0_B0_VECTOR, ISR_TB0_CCR0);
+    sim_boot(led_bar_main);
+    sim_run(SIM_MS(100));
+
+    // the fade, which uses every plane
+    frame[LED_FRAME_HEADER_LEN + 2] = crc >> 8;
+    frame[LED_FRAME_HEADER_LEN + 3] = crc & 0xFF;
+    CHECK(sim_i2c_send(LED_ADDR, frame, sizeof(frame)));
+    sim_run(SIM_MS(100));
+
+    planes = sim_isr_count(TIMER0_B0_VECTOR);
+    busy = sim_isr_time(TIMER0_B0_VECTOR);
+    sim_run(SIM_MS(1000));
+    planes = sim_isr_count(TIMER0_B0_VECTOR) - planes;
+    busy = sim_isr_time(TIMER0_B0_VECTOR) - busy;
+    utilisation = 100.0 * busy / SIM_MS(1000);
+
+    // every plane of every refresh, at a flicker-free rate, for a bounded
+    // share of the CPU: 0.58% at 4 bits to 1.20% at 8
+    expected = (double)BCM_BITS * sim_mclk_hz() / (LSB_TICKS * ((1 << BCM_BITS) - 1));
+    CHECK(expected >= BCM_BITS * REFRESH_HZ * 0.99);
+    CHECK(planes >= expected * 0.995);
+    CHECK(planes <= expected * 1.005);
+    CHECK(utilisation < 1.5);
+
+    snprintf(name, sizeof(name), "led_bcm%d", BCM_BITS);
+    printf("%s: %lu planes/s, %.2f%% CPU in the bit-plane ISR\n", name, planes, utilisation);
+    return check_finish(name);
+}
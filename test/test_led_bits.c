@@ -0,0 +1,53 @@
+/**
+ * @file
+ * @brief Tests for the LED bar's bit-to-pin mapping.
+ */
+#include "check.h"
+#include "led_bits.h"
+
+// P1OUT and P2OUT as the step ISR used to work them out, one LED at a time
+static unsigned char old_p1out(unsigned char bits)
+{
+    return ((bits << 1) & 0b10) | ((bits >> 1) & 0b1) | (bits & 0b10000) | (bits & 0b100000) |
+           (bits & 0b1000000) | (bits & 0b10000000);
+}
+
+static unsigned char old_p2out(unsigned char bits)
+{
+    return ((bits << 5) & 0b10000000) | ((bits << 3) & 0b1000000);
+}
+
+static void test_matches_old_mapping(void)
+{
+    unsigned bits;
+
+    for (bits = 0; bits < 256; bits++)
+    {
+        CHECK_EQ((unsigned char)LED_P1OUT(bits), old_p1out((unsigned char)bits));
+        CHECK_EQ((unsigned char)LED_P2OUT(bits), old_p2out((unsigned char)bits));
+    }
+}
+
+static void test_one_pin_per_led(void)
+{
+    static const unsigned char p1_pin[8] = { 0x02, 0x01, 0, 0, 0x10, 0x20, 0x40, 0x80 };
+    static const unsigned char p2_pin[8] = { 0, 0, 0x80, 0x40, 0, 0, 0, 0 };
+    unsigned led;
+
+    for (led = 0; led < 8; led++)
+    {
+        CHECK_EQ(LED_P1OUT(1U << led), p1_pin[led]);
+        CHECK_EQ(LED_P2OUT(1U << led), p2_pin[led]);
+    }
+
+    // nothing lands outside the LED pins, e.g. on the P2.0 heartbeat
+    CHECK_EQ(LED_P1OUT(0xFFU), LED_P1_PINS);
+    CHECK_EQ(LED_P2OUT(0xFFU), LED_P2_PINS);
+}
+
+int main(void)
+{
+    test_matches_old_mapping();
+    test_one_pin_per_led();
+    return check_finish("led_bits");
+}
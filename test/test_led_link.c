@@ -0,0 +1,198 @@
+/**
+ * @file
+ * @brief Tests for LED bar frame batching and upload retries, against a fake I2C master.
+ */
+#include "check.h"
+#include "crc16.h"
+#include "i2c_master.h"
+#include "led_link.h"
+#include "led_protocol.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#define LOG_LEN 32
+
+// Frames the fake I2C master was given, oldest first
+static uint8_t sent[LOG_LEN][I2C_TX_MAX_LEN];
+static uint8_t sent_len[LOG_LEN];
+static unsigned sent_count;
+
+static bool bus_busy;
+static uint8_t drops;
+
+bool i2c_master_enqueue(uint8_t addr, const uint8_t *data, uint8_t len)
+{
+    CHECK_EQ(addr, I2C_ADDR_LED_BAR);
+    if (sent_count == LOG_LEN)
+    {
+        return false;
+    }
+    memcpy(sent[sent_count], data, len);
+    sent_len[sent_count++] = len;
+    return true;
+}
+
+bool i2c_master_busy(void)
+{
+    return bus_busy;
+}
+
+uint8_t i2c_master_drop_count(void)
+{
+    return drops;
+}
+
+// CRC-16-CCITT, MSB first, as the CRC module computes it
+uint16_t crc16(uint16_t seed, const uint8_t *data, uint8_t len)
+{
+    uint16_t crc = seed;
+    uint8_t bit;
+
+    while (len--)
+    {
+        crc ^= (uint16_t)*data++ << 8;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Frame n of the log: check its header and CRC and return its first command
+static const uint8_t *command(unsigned n)
+{
+    const uint8_t *frame = sent[n];
+    uint8_t len = sent_len[n];
+
+    CHECK_EQ(frame[0], LED_FRAME_START);
+    CHECK_EQ(frame[1], len - LED_FRAME_HEADER_LEN - LED_FRAME_CRC_LEN);
+    CHECK_EQ((frame[len - 2] << 8) | frame[len - 1], crc16(LED_CRC_SEED, frame, len - LED_FRAME_CRC_LEN));
+    return &frame[LED_FRAME_HEADER_LEN];
+}
+
+static const uint8_t program[9 * LED_SEQ_FRAME_LEN] = {
+    0, 1, 1, 1, 2, 1, 3, 1, 4, 1, 5, 1, 6, 1, 7, 1, 8, 1,
+};
+
+// Check the log from frame first on is one whole upload of program to slot 2
+static void check_upload(unsigned first)
+{
+    uint16_t crc = crc16(LED_CRC_SEED, program, sizeof program);
+    const uint8_t *cmd;
+    unsigned chunk;
+
+    for (chunk = 0; chunk < 3; chunk++)
+    {
+        uint8_t n = (chunk < 2) ? LED_SEQ_CHUNK_FRAMES : 1;
+        cmd = command(first + chunk);
+        CHECK_EQ(cmd[0], LED_CMD_SEQ_WRITE);
+        CHECK_EQ(cmd[1], 2);
+        CHECK_EQ(cmd[2], chunk * LED_SEQ_CHUNK_FRAMES);
+        CHECK_EQ(cmd[3], n);
+        CHECK(memcmp(&cmd[4], &program[chunk * LED_SEQ_CHUNK_FRAMES * LED_SEQ_FRAME_LEN],
+                     n * LED_SEQ_FRAME_LEN) == 0);
+    }
+
+    cmd = command(first + 3);
+    CHECK_EQ(cmd[0], LED_CMD_SEQ_COMMIT);
+    CHECK_EQ(cmd[1], 2);
+    CHECK_EQ(cmd[2], 9);
+    CHECK_EQ((cmd[3] << 8) | cmd[4], crc);
+}
+
+static void test_batching(void)
+{
+    const uint8_t *cmd;
+
+    sent_count = 0;
+    led_link_set_pattern(3);
+    led_link_set_period(200);
+    led_link_set_raw(0x5A);
+    CHECK(led_link_flush());
+
+    // one frame: the period, then only the latest display command
+    CHECK_EQ(sent_count, 1);
+    CHECK_EQ(sent_len[0], LED_FRAME_HEADER_LEN + 5 + LED_FRAME_CRC_LEN);
+    cmd = command(0);
+    CHECK_EQ(cmd[0], LED_CMD_SET_PERIOD);
+    CHECK_EQ((cmd[1] << 8) | cmd[2], 200);
+    CHECK_EQ(cmd[3], LED_CMD_SET_RAW);
+    CHECK_EQ(cmd[4], 0x5A);
+
+    // nothing pending, nothing sent
+    CHECK(led_link_flush());
+    CHECK_EQ(sent_count, 1);
+}
+
+static void test_upload(void)
+{
+    sent_count = 0;
+    CHECK(led_link_upload_sequence(2, program, 9));
+    CHECK(!led_link_upload_sequence(1, program, 9));
+    led_link_run_program(2);
+    bus_busy = true;
+    CHECK(led_link_flush());
+    CHECK_EQ(sent_count, 5);
+    check_upload(0);
+    CHECK_EQ(command(4)[0], LED_CMD_PROG_RUN);
+
+    // not checked until it is off the bus
+    drops++;
+    CHECK(led_link_flush());
+    CHECK_EQ(sent_count, 5);
+    drops--;
+
+    // nothing dropped: done
+    bus_busy = false;
+    CHECK(led_link_flush());
+    CHECK_EQ(sent_count, 5);
+    CHECK(!led_link_upload_failed());
+    CHECK(led_link_upload_sequence(2, program, 9));
+    CHECK(led_link_flush());
+    CHECK(led_link_flush());
+}
+
+static void test_retry(void)
+{
+    unsigned attempt;
+
+    sent_count = 0;
+    CHECK(led_link_upload_sequence(2, program, 9));
+    led_link_run_program(2);
+    CHECK(led_link_flush());
+    CHECK_EQ(sent_count, 5);
+
+    // a dropped frame sends the whole upload again, and the run after it
+    for (attempt = 1; attempt < LED_LINK_UPLOAD_ATTEMPTS; attempt++)
+    {
+        drops++;
+        CHECK(led_link_flush());
+        CHECK_EQ(sent_count, 5 * (attempt + 1));
+        check_upload(5 * attempt);
+        CHECK_EQ(command(5 * attempt + 4)[0], LED_CMD_PROG_RUN);
+        CHECK(!led_link_upload_failed());
+    }
+
+    // then it gives up, and says so
+    drops++;
+    CHECK(led_link_flush());
+    CHECK_EQ(sent_count, 5 * LED_LINK_UPLOAD_ATTEMPTS);
+    CHECK(led_link_upload_failed());
+
+    // a new upload starts afresh
+    CHECK(led_link_upload_sequence(2, program, 9));
+    CHECK(!led_link_upload_failed());
+    CHECK(led_link_flush());
+    CHECK(led_link_flush());
+    CHECK(!led_link_upload_failed());
+}
+
+int main(void)
+{
+    test_batching();
+    test_upload();
+    test_retry();
+    return check_finish("led_link");
+}
@@ -0,0 +1,69 @@
+/**
+ * @file
+ * @brief Tests for the LED bar pattern generators against the step table they replaced.
+ */
+#include "check.h"
+#include "led_patterns.h"
+
+// The step table the generators replaced, pattern by pattern
+static const unsigned char old_pattern0[] = { 0b10101010 };
+static const unsigned char old_pattern1[] = { 0b10101010, 0b01010101 };
+static const unsigned char old_pattern3[] = {
+    0b00011000, 0b00100100, 0b01000010, 0b10000001, 0b01000010, 0b00100100,
+};
+static const unsigned char old_pattern5[] = {
+    0b00000001, 0b00000010, 0b00000100, 0b00001000, 0b00010000, 0b00100000, 0b01000000, 0b10000000,
+};
+static const unsigned char old_pattern6[] = {
+    0b01111111, 0b10111111, 0b11011111, 0b11101111, 0b11110111, 0b11111011, 0b11111101, 0b11111110,
+};
+static const unsigned char old_pattern7[] = {
+    0b1, 0b11, 0b111, 0b1111, 0b11111, 0b111111, 0b1111111, 0b11111111,
+};
+
+static void check_table(unsigned char (*bits)(unsigned int), const unsigned char *table, unsigned length,
+                        const char *name)
+{
+    unsigned step;
+
+    for (step = 0; step < length; step++)
+    {
+        if (bits(step) != table[step])
+        {
+            fprintf(stderr, "%s step %u: 0x%02X, expected 0x%02X\n", name, step, bits(step), table[step]);
+            CHECK(0);
+        }
+    }
+}
+
+#define CHECK_TABLE(bits, table) check_table(bits, table, sizeof table, #bits)
+
+static void test_tabled_patterns(void)
+{
+    CHECK_TABLE(bits_static, old_pattern0);
+    CHECK_TABLE(bits_toggle, old_pattern1);
+    CHECK_TABLE(bits_in_and_out, old_pattern3);
+    CHECK_TABLE(bits_rotate_one_left, old_pattern5);
+    CHECK_TABLE(bits_rotate_seven_right, old_pattern6);
+    CHECK_TABLE(bits_fill_left, old_pattern7);
+}
+
+static void test_counters(void)
+{
+    unsigned step;
+
+    // patterns 2 and 4 never had table rows; they are plain counters
+    for (step = 0; step < 256; step++)
+    {
+        CHECK_EQ(bits_up_counter(step), step);
+        CHECK_EQ(bits_down_counter(step), 255 - step);
+    }
+    CHECK_EQ(bits_off(0), 0);
+}
+
+int main(void)
+{
+    test_tabled_patterns();
+    test_counters();
+    return check_finish("led_patterns");
+}
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""Run random LED bar programs on the host VM and on tools/led_asm.py --simulate.
+
+Each program is written out as assembler source, simulated with
+led_asm.py --simulate, assembled with led_asm.assemble(), and run on the
+VM from led_bar/led_vm.c through led_vm_run. The two traces must match
+tick for tick.
+
+Usage: python3 test_led_vm.py <path to led_vm_run>
+"""
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+sys.dont_write_bytecode = True
+TOOLS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "tools")
+sys.path.insert(0, TOOLS)
+import led_asm  # noqa: E402
+
+PROGRAMS = 300
+TICKS = 200
+SEED = 465
+
+
+def random_source(rng):
+    """Assembler source for a random program that uses every instruction."""
+    length = rng.randint(1, led_asm.SEQ_MAX_FRAMES)
+    lines = []
+    for i in range(length):
+        mnemonic = rng.choice(["set", "shl", "shr", "rol", "ror", "xor", "wait", "loop", "branch"])
+        if mnemonic == "branch":
+            argument = "l%d" % rng.randrange(length)
+        elif mnemonic == "wait":
+            argument = str(rng.randint(0, 6))
+        elif mnemonic == "loop":
+            argument = str(rng.randint(0, 8))
+        elif mnemonic in ("shl", "shr", "rol", "ror"):
+            argument = str(rng.randint(0, 9))
+        else:
+            argument = "0x%02X" % rng.randrange(256)
+        lines.append("l%d: %s %s" % (i, mnemonic, argument))
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    runner = sys.argv[1]
+    rng = random.Random(SEED)
+    failures = 0
+
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "random.led")
+        for n in range(PROGRAMS):
+            source = random_source(rng)
+            with open(path, "w") as f:
+                f.write(source)
+
+            expected = subprocess.run(
+                [sys.executable, "-B", os.path.join(TOOLS, "led_asm.py"), "--simulate", str(TICKS), path],
+                check=True, capture_output=True, text=True).stdout
+            program = led_asm.assemble(path)
+            actual = subprocess.run(
+                [runner, str(TICKS)] + ["%02X%02X" % ins for ins in program],
+                check=True, capture_output=True, text=True).stdout
+
+            if actual != expected:
+                failures += 1
+                sys.stderr.write("program %d differs from led_asm.py --simulate:\n%s" % (n, source))
+
+    if failures:
+        sys.exit("led_vm: %d of %d programs failed" % (failures, PROGRAMS))
+    print("led_vm: ok")
+
+
+if __name__ == "__main__":
+    main()
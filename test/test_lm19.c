@@ -0,0 +1,82 @@
+/**
+ * @file
+ * @brief Tests for the table-driven LM19 conversion against the datasheet equation.
+ */
+#include "check.h"
+#include "lm19.h"
+
+#include <math.h>
+
+// Same model and ADC scaling as sensors/lm19.json
+#define VREF 3.3
+#define FULL_SCALE 65520.0
+
+// lm19.h promises 0.015 degrees C from the equation; the tenths add half a
+// step of rounding and, in F, the error of the Q15 scale factor
+#define CENTI_C_TOLERANCE 0.015
+#define DECI_C_TOLERANCE (0.05 + 0.015)
+#define DECI_F_TOLERANCE (0.05 + 1.8 * 0.015 + 0.01)
+
+// Datasheet equation, degrees C
+static double model_c(uint16_t code)
+{
+    double v = code * VREF / FULL_SCALE;
+    return -1481.96 + sqrt(2.1962e6 + (1.8639 - v) / 3.88e-6);
+}
+
+static void test_every_code(void)
+{
+    uint32_t code;
+
+    for (code = 0; code <= 0xFFFF; code++)
+    {
+        double c = model_c((uint16_t)code);
+        double f = c * 1.8 + 32;
+
+        CHECK(fabs(lm19_centi_c((uint16_t)code) / 100.0 - c) <= CENTI_C_TOLERANCE);
+        // 0.065 rather than 0.05: rounding to tenths costs up to 0.05 on top of the hundredths'
+        // own 0.015 from the equation. The Q15 factor (3277 / 32768, 6e-5 high) could add up to
+        // 0.009 more at the top of the range, but every code is checked and the worst is 0.0636.
+        CHECK(fabs(lm19_deci_c((uint16_t)code) / 10.0 - c) <= DECI_C_TOLERANCE);
+        CHECK(fabs(lm19_deci_f((uint16_t)code) / 10.0 - f) <= DECI_F_TOLERANCE);
+
+        // the output falls as the temperature rises, so it never increases with the code
+        if (code > 0)
+        {
+            CHECK(lm19_centi_c((uint16_t)code) <= lm19_centi_c((uint16_t)(code - 1)));
+        }
+    }
+}
+
+static void test_code_at_centi_c(void)
+{
+    int16_t hottest = lm19_centi_c(0);
+    int16_t coldest = lm19_centi_c(0xFFFF);
+    int32_t centi;
+
+    for (centi = coldest - 100; centi <= hottest + 100; centi++)
+    {
+        uint16_t code = lm19_code_at_centi_c((int16_t)centi);
+
+        if (centi < coldest)
+        {
+            // no code reads that cold
+            CHECK_EQ(code, 0xFFFF);
+            continue;
+        }
+
+        // smallest code that reads at or below centi
+        CHECK(lm19_centi_c(code) <= centi);
+        if (code > 0)
+        {
+            CHECK(lm19_centi_c((uint16_t)(code - 1)) > centi);
+        }
+    }
+}
+
+int main(void)
+{
+    test_every_code();
+    test_code_at_centi_c();
+    return check_finish("lm19");
+}
@@ -0,0 +1,217 @@
+/**
+ * @file
+ * @brief Tests for the ring-buffer moving average.
+ */
+#include "check.h"
+#include "icount.h"
+#include "rolling_avg.h"
+
+#include <string.h>
+
+static uint32_t rng_state = 1;
+
+// Deterministic 16-bit samples
+static uint16_t next_sample(void)
+{
+    rng_state = rng_state * 1103515245UL + 12345UL;
+    return (uint16_t)(rng_state >> 16);
+}
+
+// Rounded mean of the last n of count samples, worked out from scratch
+static uint16_t reference_mean(const uint16_t *history, unsigned count, unsigned n)
+{
+    uint32_t sum = 0;
+    unsigned i;
+
+    if (n > count)
+    {
+        n = count;
+    }
+    for (i = count - n; i < count; i++)
+    {
+        sum += history[i];
+    }
+    return (uint16_t)((sum + n / 2) / n);
+}
+
+static void test_every_window_size(void)
+{
+    static uint16_t history[3 * ROLLING_AVG_MAX_WINDOW + 7];
+    struct rolling_avg avg;
+    unsigned size;
+    unsigned i;
+
+    for (size = 1; size <= ROLLING_AVG_MAX_WINDOW; size++)
+    {
+        CHECK(rolling_avg_init(&avg, (uint8_t)size));
+        CHECK_EQ(rolling_avg_mean(&avg), 0);
+        CHECK(!rolling_avg_full(&avg));
+
+        // run the ring round more than twice so old samples have been evicted
+        for (i = 0; i < sizeof history / sizeof history[0]; i++)
+        {
+            history[i] = next_sample();
+            rolling_avg_push(&avg, history[i]);
+            CHECK_EQ(rolling_avg_full(&avg), i + 1 >= size);
+            CHECK_EQ(rolling_avg_mean(&avg), reference_mean(history, i + 1, size));
+        }
+    }
+}
+
+static void test_eviction(void)
+{
+    struct rolling_avg avg;
+    unsigned i;
+
+    CHECK(rolling_avg_init(&avg, 4));
+    for (i = 0; i < 4; i++)
+    {
+        rolling_avg_push(&avg, 1000);
+    }
+    CHECK_EQ(rolling_avg_mean(&avg), 1000);
+
+    // each new sample replaces exactly one old one
+    rolling_avg_push(&avg, 0);
+    CHECK_EQ(rolling_avg_mean(&avg), 750);
+    rolling_avg_push(&avg, 0);
+    rolling_avg_push(&avg, 0);
+    CHECK_EQ(rolling_avg_mean(&avg), 250);
+    rolling_avg_push(&avg, 0);
+    CHECK_EQ(rolling_avg_mean(&avg), 0);
+    CHECK(rolling_avg_full(&avg));
+
+    // the full-scale sum doesn't overflow
+    CHECK(rolling_avg_init(&avg, ROLLING_AVG_MAX_WINDOW));
+    for (i = 0; i < 3 * ROLLING_AVG_MAX_WINDOW; i++)
+    {
+        rolling_avg_push(&avg, 0xFFFF);
+    }
+    CHECK_EQ(rolling_avg_mean(&avg), 0xFFFF);
+}
+
+static void test_rounding(void)
+{
+    struct rolling_avg avg;
+
+    // 1.5 rounds up
+    CHECK(rolling_avg_init(&avg, 2));
+    rolling_avg_push(&avg, 1);
+    rolling_avg_push(&avg, 2);
+    CHECK_EQ(rolling_avg_mean(&avg), 2);
+
+    // 1.33 rounds down, 1.67 rounds up
+    CHECK(rolling_avg_init(&avg, 3));
+    rolling_avg_push(&avg, 1);
+    rolling_avg_push(&avg, 1);
+    rolling_avg_push(&avg, 2);
+    CHECK_EQ(rolling_avg_mean(&avg), 1);
+    rolling_avg_push(&avg, 2);
+    CHECK_EQ(rolling_avg_mean(&avg), 2);
+
+    // a partly filled window averages what it has
+    CHECK(rolling_avg_init(&avg, 10));
+    rolling_avg_push(&avg, 10);
+    rolling_avg_push(&avg, 13);
+    CHECK_EQ(rolling_avg_mean(&avg), 12);
+    CHECK(!rolling_avg_full(&avg));
+}
+
+static void test_bad_size(void)
+{
+    struct rolling_avg avg;
+    struct rolling_avg before;
+
+    CHECK(rolling_avg_init(&avg, 3));
+    rolling_avg_push(&avg, 30);
+    rolling_avg_push(&avg, 60);
+    memcpy(&before, &avg, sizeof avg);
+
+    CHECK(!rolling_avg_init(&avg, 0));
+    CHECK(!rolling_avg_init(&avg, ROLLING_AVG_MAX_WINDOW + 1));
+    CHECK(!rolling_avg_init(&avg, 255));
+    CHECK(memcmp(&before, &avg, sizeof avg) == 0);
+    CHECK_EQ(rolling_avg_mean(&avg), 45);
+
+    CHECK(rolling_avg_init(&avg, 1));
+    CHECK(rolling_avg_init(&avg, ROLLING_AVG_MAX_WINDOW));
+}
+
+static volatile uint16_t sink;
+
+// What the sample ISR does with each decimated sample
+static void push_and_mean(void *arg)
+{
+    struct rolling_avg *avg = arg;
+
+    rolling_avg_push(avg, 12345);
+    sink = rolling_avg_mean(avg);
+}
+
+// The window summed afresh for every sample, as the averaging did before the running sum
+static void resum(void *arg)
+{
+    const struct rolling_avg *avg = arg;
+    uint32_t sum = 0;
+    uint8_t i;
+
+    for (i = 0; i < avg->size; i++)
+    {
+        sum += avg->samples[i];
+    }
+    sink = (uint16_t)(sum / avg->size);
+}
+
+static void test_cost_flat(void)
+{
+    static const uint8_t sizes[] = {1, 2, 10, 50, ROLLING_AVG_MAX_WINDOW};
+    unsigned long fewest = (unsigned long)-1;
+    unsigned long most = 0;
+    unsigned long resum_small;
+    unsigned long resum_large;
+    struct rolling_avg avg;
+    unsigned i;
+
+    if (!icount_available())
+    {
+        printf("rolling_avg: can't count instructions here, cost check skipped\n");
+        return;
+    }
+
+    // a full window, mid-buffer, so the cost is the steady state's
+    for (i = 0; i < sizeof(sizes); i++)
+    {
+        unsigned long count;
+        unsigned n;
+
+        rolling_avg_init(&avg, sizes[i]);
+        for (n = 0; n < 2u * sizes[i] + sizes[i] / 2; n++)
+        {
+            rolling_avg_push(&avg, next_sample());
+        }
+        count = icount(push_and_mean, &avg);
+        CHECK(count > 0);
+        fewest = (count < fewest) ? count : fewest;
+        most = (count > most) ? count : most;
+    }
+
+    // the same instructions whatever the window, give or take the wrap test
+    CHECK(most - fewest <= 4);
+
+    // while summing the window grows with it, so the counts do measure the work
+    rolling_avg_init(&avg, 1);
+    resum_small = icount(resum, &avg);
+    rolling_avg_init(&avg, ROLLING_AVG_MAX_WINDOW);
+    resum_large = icount(resum, &avg);
+    CHECK(resum_large > 20 * resum_small);
+    CHECK(resum_large > 10 * most);
+}
+
+int main(void)
+{
+    test_every_window_size();
+    test_eviction();
+    test_rounding();
+    test_bad_size();
+    test_cost_flat();
+    return check_finish("rolling_avg");
+}
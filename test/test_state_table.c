@@ -0,0 +1,168 @@
+/**
+ * @file
+ * @brief Tests for the keypad state machine table.
+ */
+#include "check.h"
+#include "state_table.h"
+
+static const char keys[] = "123A456B789C*0#D";
+
+// Feed a string of keys from a state; return the final state and the last action
+static struct transition press(uint8_t state, const char *sequence)
+{
+    struct transition t = { state, ACTION_NONE, state };
+
+    while (*sequence)
+    {
+        t = state_table_lookup(t.next_state, *sequence++);
+    }
+    return t;
+}
+
+static void test_every_entry_is_valid(void)
+{
+    uint8_t state;
+    const char *key;
+
+    for (state = 0; state < STATE_COUNT; state++)
+    {
+        for (key = keys; *key; key++)
+        {
+            struct transition t = state_table_lookup(state, *key);
+            CHECK(t.next_state < STATE_COUNT);
+            CHECK(t.action < ACTION_COUNT);
+            CHECK(t.reject_state < STATE_COUNT);
+        }
+    }
+}
+
+static void test_unlock(void)
+{
+    struct transition t = press(STATE_LOCKED, "1111");
+
+    CHECK_EQ(t.next_state, STATE_UNLOCKED);
+    CHECK_EQ(t.action, ACTION_UNLOCKED);
+
+    CHECK_EQ(state_table_lookup(STATE_LOCKED, '1').action, ACTION_UNLOCKING);
+    CHECK_EQ(press(STATE_LOCKED, "111").next_state, STATE_UNLOCK_3);
+}
+
+static void test_wrong_digit_locks(void)
+{
+    uint8_t state;
+    const char *key;
+
+    for (state = STATE_LOCKED; state <= STATE_UNLOCK_3; state++)
+    {
+        for (key = keys; *key; key++)
+        {
+            if (*key == '1')
+            {
+                continue;
+            }
+            struct transition t = state_table_lookup(state, *key);
+            CHECK_EQ(t.next_state, STATE_LOCKED);
+            CHECK_EQ(t.action, ACTION_LOCK);
+        }
+    }
+}
+
+static void test_d_locks_everywhere(void)
+{
+    uint8_t state;
+
+    for (state = 0; state < STATE_COUNT; state++)
+    {
+        struct transition t = state_table_lookup(state, 'D');
+        CHECK_EQ(t.next_state, STATE_LOCKED);
+        CHECK_EQ(t.action, ACTION_LOCK);
+    }
+}
+
+static void test_unknown_key_and_state(void)
+{
+    uint8_t state;
+
+    for (state = 0; state < STATE_COUNT; state++)
+    {
+        struct transition t = state_table_lookup(state, 'x');
+        CHECK_EQ(t.next_state, state);
+        CHECK_EQ(t.action, ACTION_NONE);
+
+        t = state_table_lookup(state, '\0');
+        CHECK_EQ(t.next_state, state);
+        CHECK_EQ(t.action, ACTION_NONE);
+    }
+
+    CHECK_EQ(state_table_lookup(STATE_COUNT, '1').next_state, STATE_LOCKED);
+    CHECK_EQ(state_table_lookup(0xFF, '1').action, ACTION_LOCK);
+}
+
+static void test_menus(void)
+{
+    struct transition t;
+
+    t = press(STATE_UNLOCKED, "A");
+    CHECK_EQ(t.next_state, STATE_PATTERN_ENTRY);
+    CHECK_EQ(t.action, ACTION_ENTER_PATTERN);
+    CHECK_EQ(press(STATE_UNLOCKED, "A7").action, ACTION_SELECT_PATTERN);
+    CHECK_EQ(press(STATE_UNLOCKED, "AA").action, ACTION_PERIOD_DEC);
+    CHECK_EQ(press(STATE_UNLOCKED, "AB").action, ACTION_PERIOD_INC);
+    CHECK_EQ(press(STATE_UNLOCKED, "A3*").next_state, STATE_UNLOCKED);
+
+    t = press(STATE_UNLOCKED, "B12*");
+    CHECK_EQ(t.next_state, STATE_UNLOCKED);
+    CHECK_EQ(t.action, ACTION_WINDOW_COMMIT);
+
+    CHECK_EQ(press(STATE_UNLOCKED, "C").action, ACTION_TOGGLE_UNITS);
+    CHECK_EQ(press(STATE_UNLOCKED, "*").action, ACTION_MONITOR_OFF);
+
+    t = press(STATE_UNLOCKED, "#20*");
+    CHECK_EQ(t.next_state, STATE_HIGH_LIMIT_ENTRY);
+    CHECK_EQ(t.action, ACTION_LOW_LIMIT_COMMIT);
+    CHECK_EQ(t.reject_state, STATE_UNLOCKED);
+    t = press(STATE_UNLOCKED, "#20*30*");
+    CHECK_EQ(t.next_state, STATE_UNLOCKED);
+    CHECK_EQ(t.action, ACTION_HIGH_LIMIT_COMMIT);
+    CHECK_EQ(t.reject_state, STATE_UNLOCKED);
+
+    t = press(STATE_UNLOCKED, "04");
+    CHECK_EQ(t.next_state, STATE_UNLOCKED);
+    CHECK_EQ(t.action, ACTION_SELECT_FILTER);
+    t = press(STATE_UNLOCKED, "05");
+    CHECK_EQ(t.next_state, STATE_FILTER_ENTRY);
+    CHECK_EQ(t.action, ACTION_NONE);
+}
+
+static void test_reject_states(void)
+{
+    uint8_t state;
+    const char *key;
+
+    // only actions that can fail move anywhere but their next state on failure
+    for (state = 0; state < STATE_COUNT; state++)
+    {
+        for (key = keys; *key; key++)
+        {
+            struct transition t = state_table_lookup(state, *key);
+            if ((t.action != ACTION_LOW_LIMIT_COMMIT) && (t.action != ACTION_HIGH_LIMIT_COMMIT))
+            {
+                CHECK_EQ(t.reject_state, t.next_state);
+            }
+        }
+    }
+    CHECK_EQ(state_table_lookup(STATE_UNLOCKED, 'x').reject_state, STATE_UNLOCKED);
+    CHECK_EQ(state_table_lookup(STATE_COUNT, '1').reject_state, STATE_LOCKED);
+}
+
+int main(void)
+{
+    test_every_entry_is_valid();
+    test_unlock();
+    test_wrong_digit_locks();
+    test_d_locks_everywhere();
+    test_unknown_key_and_state();
+    test_menus();
+    test_reject_states();
+    return check_finish("state_table");
+}
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""Generate a sensor transfer-function table and its interpolation routine.
+
+Reads a JSON sensor description and writes <name>_table.h and <name>_table.c:
+a const int16_t table of the sensor output every 2^table_shift ADC codes, and
+<name>_lookup(), which interpolates between entries with integer math only.
+Every constant is baked into the generated code, so changing the sensor, ADC
+resolution or reference costs nothing at runtime.
+
+Sensor description fields:
+    name         C identifier prefix for the generated table and routine
+    description  Free text copied into the generated file headers
+    code         What the lookup's code argument is, for its doc comment, optional;
+                 defaults to "<adc_bits>-bit code"
+    model        "polynomial", "sqrt" or "piecewise"
+    params       polynomial: {"coeffs": [c0, c1, ...]}       y = c0 + c1*V + c2*V^2 + ...
+                 sqrt:       {"a": a, "b": b, "c": c, "d": d}  y = a + sqrt(b + (c - V) / d)
+                 piecewise:  {"points": [[V, y], ...]}        linear between points, V ascending
+    adc_bits     Width of the codes the table is indexed by, at most 16
+    vref         ADC reference voltage
+    full_scale   Code that reads vref, optional; defaults to 2^adc_bits - 1.
+                 Left-justified codes need it, e.g. 4095 << 4 for 12 bits in 16
+    table_shift  log2 of the number of codes between table entries
+    scale        Factor applied to y before rounding, e.g. 100 for hundredths
+
+Usage: python3 tools/gen_sensor_table.py <sensor.json> <output directory>
+"""
+import json
+import math
+import numbers
+import os
+import sys
+
+REQUIRED = ("name", "model", "params", "adc_bits", "vref", "table_shift", "scale")
+
+
+def load(path):
+    """Read a sensor description, exiting with a message if it is malformed."""
+    try:
+        with open(path) as f:
+            desc = json.load(f)
+    except (OSError, ValueError) as e:
+        sys.exit("%s: %s" % (path, e))
+    if not isinstance(desc, dict):
+        sys.exit("%s: expected a JSON object" % path)
+    missing = [field for field in REQUIRED if field not in desc]
+    if missing:
+        sys.exit("%s: missing %s" % (path, ", ".join(missing)))
+    if not (isinstance(desc["name"], str) and desc["name"].isidentifier()):
+        sys.exit("%s: name must be a C identifier" % path)
+    for field in ("adc_bits", "table_shift", "scale"):
+        if not isinstance(desc[field], int) or isinstance(desc[field], bool):
+            sys.exit("%s: %s must be an integer" % (path, field))
+    if not isinstance(desc["vref"], numbers.Real) or desc["vref"] <= 0:
+        sys.exit("%s: vref must be a positive number" % path)
+    if not isinstance(desc.get("full_scale", 1), int) or desc.get("full_scale", 1) <= 0:
+        sys.exit("%s: full_scale must be a positive integer" % path)
+    if not isinstance(desc["params"], dict):
+        sys.exit("%s: params must be an object" % path)
+    return desc
+
+
+def make_model(desc):
+    model = desc["model"]
+    params = desc["params"]
+    try:
+        return make_model_params(model, params)
+    except (KeyError, TypeError, ValueError) as e:
+        sys.exit("%s: %s model: %s" % (desc["name"], model, e))
+
+
+def make_model_params(model, params):
+    if model == "polynomial":
+        coeffs = [float(c) for c in params["coeffs"]]
+        if not coeffs:
+            raise ValueError("no coeffs")
+        return lambda v: sum(c * v ** n for n, c in enumerate(coeffs))
+    if model == "sqrt":
+        a, b, c, d = (float(params[k]) for k in "abcd")
+        if d == 0:
+            raise ValueError("d is 0")
+        return lambda v: a + math.sqrt(b + (c - v) / d)
+    if model == "piecewise":
+        points = [(float(v), float(y)) for v, y in params["points"]]
+        if len(points) < 2 or any(v1 <= v0 for (v0, _), (v1, _) in zip(points, points[1:])):
+            raise ValueError("need at least two points with V ascending")
+
+        def piecewise(v):
+            k = 1
+            while k < len(points) - 1 and v >= points[k][0]:
+                k += 1
+            (v0, y0), (v1, y1) = points[k - 1], points[k]
+            return y0 + (y1 - y0) * (v - v0) / (v1 - v0)
+
+        return piecewise
+    raise ValueError("unknown model")
+
+
+def interpolate(values, shift, code):
+    """Bit-exact model of the generated C lookup routine."""
+    i = code >> shift
+    frac = code & ((1 << shift) - 1)
+    product = (values[i + 1] - values[i]) * frac
+    return values[i] + int(product / (1 << shift))  # C division truncates toward zero
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    desc = load(sys.argv[1])
+    out_dir = sys.argv[2]
+
+    name = desc["name"]
+    upper = name.upper()
+    bits = desc["adc_bits"]
+    shift = desc["table_shift"]
+    scale = desc["scale"]
+    about = desc.get("description", name)
+    if bits > 16 or not 0 < shift <= min(bits - 1, 14):
+        sys.exit("%s: need adc_bits <= 16 and 0 < table_shift <= min(adc_bits - 1, 14)" % name)
+    code_max = (1 << bits) - 1
+    full_scale = desc.get("full_scale", code_max)
+    model = make_model(desc)
+
+    def code_to_y(code):
+        return model(code * desc["vref"] / full_scale)
+
+    count = (1 << (bits - shift)) + 1
+    try:
+        values = [round(code_to_y(i << shift) * scale) for i in range(count)]
+    except (ValueError, OverflowError) as e:
+        sys.exit("%s: model fails over the code range: %s" % (name, e))
+    if min(values) < -32768 or max(values) > 32767:
+        sys.exit("%s: table values do not fit in int16_t, lower the scale" % name)
+    # Keep the interpolation multiply 16-bit when the steepest segment allows it
+    max_product = max(abs(values[i + 1] - values[i]) for i in range(count - 1)) * ((1 << shift) - 1)
+    if max_product > 0x7FFFFFFF:
+        sys.exit("%s: interpolation product overflows int32_t" % name)
+    product_type = "int16_t" if max_product <= 0x7FFF else "int32_t"
+
+    max_error = max(abs(interpolate(values, shift, c) / scale - code_to_y(c)) for c in range(code_max + 1))
+    print("%s: %d entries, max interpolation error %.4f" % (name, count, max_error))
+
+    banner = [
+        "/**",
+        " * @file",
+        " * @brief %s" % about,
+        " *",
+        " * Generated by tools/gen_sensor_table.py from sensors/%s.json; do not edit." % name,
+        " */",
+    ]
+
+    header = banner + [
+        "#ifndef %s_TABLE_H" % upper,
+        "#define %s_TABLE_H" % upper,
+        "",
+        "#include <stdint.h>",
+        "",
+        "/** Width of the codes the table is indexed by */",
+        "#define %s_ADC_BITS %d" % (upper, bits),
+        "",
+        "/** Lookup output units per model unit */",
+        "#define %s_SCALE %d" % (upper, scale),
+        "",
+        "/**",
+        " * Convert an ADC code with the %s model." % name,
+        " *",
+        " * Interpolates linearly between table entries %d codes apart; the largest" % (1 << shift),
+        " * deviation from the model is %.4f model units." % max_error,
+        " *",
+        " * @param: code %s%s." % (desc.get("code", "%d-bit code" % bits),
+                                   "" if bits == 16 else "; larger codes are clamped"),
+        " *",
+        " * @return: Model output times %s_SCALE." % upper,
+        " */",
+        "int16_t %s_lookup(uint16_t code);" % name,
+        "",
+        "#endif // %s_TABLE_H" % upper,
+    ]
+
+    rows = ["    " + " ".join("%6d," % v for v in values[i:i + 8]) for i in range(0, count, 8)]
+    source = banner + [
+        '#include "%s_table.h"' % name,
+        "",
+        "#define TABLE_SHIFT %d" % shift,
+    ] + ([] if bits == 16 else ["#define CODE_MAX %d" % code_max]) + [
+        "",
+        "// Model output times %s_SCALE at code i << TABLE_SHIFT (%d-bit codes, %g V at code %d)"
+        % (upper, bits, desc["vref"], full_scale),
+        "static const int16_t table[%d] = {" % count,
+    ] + rows + [
+        "};",
+        "",
+        "int16_t %s_lookup(uint16_t code)" % name,
+        "{",
+    ] + ([] if bits == 16 else [
+        "    if (code > CODE_MAX)",
+        "    {",
+        "        code = CODE_MAX;",
+        "    }",
+        "",
+    ]) + [
+        "    uint16_t i = code >> TABLE_SHIFT;",
+        "    int16_t frac = code & ((1 << TABLE_SHIFT) - 1);",
+        "    %s product = (%s)(table[i + 1] - table[i]) * frac;" % (product_type, product_type),
+        "",
+        "    return table[i] + (int16_t)(product / (1 << TABLE_SHIFT));",
+        "}",
+    ]
+
+    with open(os.path.join(out_dir, "%s_table.h" % name), "w") as f:
+        f.write("\n".join(header) + "\n")
+    with open(os.path.join(out_dir, "%s_table.c" % name), "w") as f:
+        f.write("\n".join(source) + "\n")
+
+
+if __name__ == "__main__":
+    main()
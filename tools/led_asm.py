@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Assemble an LED bar animation program, or simulate one on the host.
+
+Reads a program for the LED bar's animation VM (see common/led_protocol.h)
+and writes <name>_program.h and <name>_program.c: a const uint8_t array of
+[opcode][argument] pairs, ready for led_link_upload_sequence(), and the
+number of instructions in it.
+
+Program syntax, one instruction per line:
+    label:              names the next instruction
+    set 0b00000011      bits = value
+    shl 1 / shr 1       shift bits left / right
+    rol 1 / ror 1       rotate bits left / right (ror n is rol 8-n)
+    xor 0xFF            bits ^= value
+    wait 2              show bits for 2 ticks
+    loop 6              counter = 6
+    branch label        counter -= 1; go to label unless counter is 0
+Numbers are C literals (decimal, 0x, 0b). ';' starts a comment.
+
+Usage: python3 tools/led_asm.py <program.led> <output directory>
+       python3 tools/led_asm.py --simulate <ticks> <program.led>
+"""
+import os
+import re
+import sys
+
+# Opcodes and limits, as in common/led_protocol.h
+OPCODES = {"set": 0x00, "shl": 0x01, "shr": 0x02, "rol": 0x03,
+           "xor": 0x04, "wait": 0x05, "loop": 0x06, "branch": 0x07}
+SEQ_MAX_FRAMES = 16
+VM_BUDGET = 16
+
+
+def fail(path, line_no, message):
+    sys.exit("%s:%d: %s" % (path, line_no, message))
+
+
+def assemble(path):
+    """Return the program as a list of (opcode, argument) pairs."""
+    lines = []
+    labels = {}
+    with open(path) as f:
+        for line_no, line in enumerate(f, 1):
+            line = line.split(";")[0].strip()
+            match = re.match(r"([A-Za-z_]\w*):\s*(.*)", line)
+            if match:
+                if match.group(1) in labels:
+                    fail(path, line_no, "duplicate label %s" % match.group(1))
+                labels[match.group(1)] = len(lines)
+                line = match.group(2)
+            if line:
+                lines.append((line_no, line.split()))
+
+    program = []
+    for line_no, words in lines:
+        mnemonic = words[0].lower()
+        if len(words) != 2 or (mnemonic not in OPCODES and mnemonic != "ror"):
+            fail(path, line_no, "expected '<instruction> <argument>'")
+        if mnemonic == "branch":
+            if words[1] not in labels:
+                fail(path, line_no, "unknown label %s" % words[1])
+            value = labels[words[1]]
+        else:
+            try:
+                value = int(words[1], 0)
+            except ValueError:
+                fail(path, line_no, "bad number %s" % words[1])
+        if not 0 <= value <= 255:
+            fail(path, line_no, "argument out of range: %d" % value)
+        if mnemonic == "ror":
+            mnemonic, value = "rol", (8 - value % 8) % 8
+        program.append((OPCODES[mnemonic], value))
+
+    if not program:
+        sys.exit("%s: empty program" % path)
+    if len(program) > SEQ_MAX_FRAMES:
+        sys.exit("%s: %d instructions, a slot holds %d" % (path, len(program), SEQ_MAX_FRAMES))
+    return program
+
+
+def simulate(program, ticks):
+    """Bit-exact model of led_vm_tick() in led_bar/led_vm.c; yields the bits shown each tick."""
+    pc = bits = count = wait = 0
+    for _ in range(ticks):
+        if wait:
+            wait -= 1
+            yield bits
+            continue
+        for _ in range(VM_BUDGET):
+            op, arg = program[pc]
+            pc = (pc + 1) % len(program)
+            if op == OPCODES["set"]:
+                bits = arg
+            elif op == OPCODES["shl"]:
+                bits = (bits << (arg & 7)) & 0xFF
+            elif op == OPCODES["shr"]:
+                bits >>= arg & 7
+            elif op == OPCODES["rol"]:
+                arg &= 7
+                bits = ((bits << arg) | (bits >> (8 - arg))) & 0xFF
+            elif op == OPCODES["xor"]:
+                bits ^= arg
+            elif op == OPCODES["wait"]:
+                wait = arg - 1 if arg else 0
+                break
+            elif op == OPCODES["loop"]:
+                count = arg
+            elif op == OPCODES["branch"]:
+                count = (count - 1) & 0xFF
+                if count != 0 and arg < len(program):
+                    pc = arg
+        yield bits
+
+
+def main():
+    if len(sys.argv) == 4 and sys.argv[1] == "--simulate":
+        program = assemble(sys.argv[3])
+        for tick, bits in enumerate(simulate(program, int(sys.argv[2]))):
+            # first LED on the left, as bit 0
+            print("%4d  %s" % (tick, "".join("#" if bits >> i & 1 else "." for i in range(8))))
+        return
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+
+    path, out_dir = sys.argv[1], sys.argv[2]
+    program = assemble(path)
+    name = os.path.splitext(os.path.basename(path))[0]
+    guard = "%s_PROGRAM_H" % name.upper()
+    source = os.path.relpath(path, out_dir).replace(os.sep, "/")
+
+    with open(os.path.join(out_dir, "%s_program.h" % name), "w") as f:
+        f.write("/**\n * @file\n * @brief LED bar animation program assembled from %s.\n *\n"
+                " * Generated by tools/led_asm.py; do not edit.\n */\n" % source)
+        f.write("#ifndef %s\n#define %s\n\n#include <stdint.h>\n\n" % (guard, guard))
+        f.write("/** Number of instructions, the frame count for led_link_upload_sequence */\n")
+        f.write("#define %s_PROGRAM_FRAMES %d\n\n" % (name.upper(), len(program)))
+        f.write("/** [opcode][argument] pairs */\n")
+        f.write("extern const uint8_t %s_program[%s_PROGRAM_FRAMES * 2];\n\n" % (name, name.upper()))
+        f.write("#endif // %s\n" % guard)
+
+    with open(os.path.join(out_dir, "%s_program.c" % name), "w") as f:
+        f.write("/**\n * @file\n * @brief LED bar animation program assembled from %s.\n *\n"
+                " * Generated by tools/led_asm.py; do not edit.\n */\n" % source)
+        f.write('#include "%s_program.h"\n\n' % name)
+        f.write("const uint8_t %s_program[%s_PROGRAM_FRAMES * 2] = {\n" % (name, name.upper()))
+        for op, arg in program:
+            f.write("    0x%02X, 0x%02X,\n" % (op, arg))
+        f.write("};\n")
+
+
+if __name__ == "__main__":
+    main()